@@ -0,0 +1,77 @@
+/*
+ * plutt, a scriptable monitor for experimental data.
+ *
+ * Copyright (C) 2025
+ * Hans Toshihide Toernqvist <hans.tornqvist@chalmers.se>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/*
+ * Fit benchmark, "make fit_bench". Fits noisy synthetic peaks, and fit.cpp
+ * built with PLUTT_FIT_BENCH prints the built-in solver vs nlopt, when
+ * available, for every fit from the same start:
+ *  model  solver  y  itn  time
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <fit.hpp>
+
+#define BENCH_ROUNDS 20
+
+namespace {
+  // Poisson-ish noise, good enough for fitting.
+  uint32_t Noisy(double a_mu)
+  {
+    double u1 = (rand() + 1.0) / ((double)RAND_MAX + 2.0);
+    double u2 = (rand() + 1.0) / ((double)RAND_MAX + 2.0);
+    auto g = sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+    auto v = a_mu + sqrt(a_mu) * g;
+    return v > 0.0 ? (uint32_t)v : 0;
+  }
+}
+
+int main()
+{
+  srand(1);
+  std::vector<uint32_t> vg(200), veg(200);
+  for (unsigned round = 0; round < BENCH_ROUNDS; ++round) {
+    double y = 100.0 * (1 + round % 4);
+    double amp = 2e3;
+    double mean = 60.0 + 4 * round;
+    double std = 3.0 + round % 5;
+    double denom = 1 / (2 * std * std);
+    double max_g = 0.0;
+    double max_eg = 0.0;
+    for (uint32_t i = 0; i < vg.size(); ++i) {
+      auto d1 = i - 150.0;
+      auto d2 = i - mean;
+      auto g = amp * exp(-d2 * d2 * denom);
+      vg.at(i) = Noisy(y + g);
+      veg.at(i) = Noisy(y + exp(d1 / -20.0) + g);
+      max_g = std::max(max_g, (double)vg.at(i));
+      max_eg = std::max(max_eg, (double)veg.at(i));
+    }
+    FitGauss fg(vg, max_g, 0, (uint32_t)(vg.size() - 1));
+    FitExpGauss feg(veg, max_eg, 0, (uint32_t)(veg.size() - 1));
+  }
+  return 0;
+}
@@ -27,26 +27,39 @@
  *
  * Calibrations are double-buffered, so in the beginning the fine-time is
  * slowly building, and eventually old calibrations are discarded.
+ *
+ * All channels live in flat tables of channel x fine-bin, with a stride that
+ * grows with the largest fine-time seen, up to a fixed maximum. The look-up
+ * table is normalized and padded to the stride, so conversion is a single
+ * load per hit.
  */
-class CalFineTime {
+class CalFineTable {
   public:
-    CalFineTime();
-    double Get(uint32_t);
+    CalFineTable();
+    double Get(uint32_t, uint32_t);
+    // Accounts and converts all hits of one channel, the table is
+    // recalibrated at most once per call.
+    void GetMany(uint32_t, uint32_t const *, size_t, double *);
+    bool StateLoad(std::vector<uint8_t> const &, size_t *);
+    void StateSave(std::vector<uint8_t> *) const;
 
   private:
-    void Calib();
-    uint32_t m_counter;
+    void Calib(uint32_t, unsigned);
+    void ChannelFit(uint32_t);
+    void Restride(uint32_t);
 
-    struct Span {
-      Span();
-      uint32_t sum;
-      uint32_t min, max;
-      std::vector<uint32_t> hist;
-    };
-    std::vector<Span> m_span_vec;
-    size_t m_span_i;
-    uint32_t m_acc_max, m_acc_sum;
-    std::vector<uint32_t> m_acc;
+    uint32_t m_stride;
+    // Per channel.
+    std::vector<uint32_t> m_counter;
+    std::vector<uint8_t> m_span_i;
+    // Per channel and span at [2 * ch + span].
+    std::vector<uint32_t> m_span_sum;
+    std::vector<uint32_t> m_span_min;
+    std::vector<uint32_t> m_span_max;
+    // Counts at [(2 * ch + span) * stride + bin].
+    std::vector<uint32_t> m_hist;
+    // Look-up at [ch * stride + bin].
+    std::vector<double> m_lut;
 };
 
 #endif
@@ -0,0 +1,81 @@
+/*
+ * plutt, a scriptable monitor for experimental data.
+ *
+ * Copyright (C) 2025
+ * Hans Toshihide Toernqvist <hans.tornqvist@chalmers.se>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+#ifndef CHANNEL_HPP
+#define CHANNEL_HPP
+
+#include <value.hpp>
+
+/*
+ * Kernels over the sorted channel layout of Value, i.e. GetID() is strictly
+ * increasing and GetEnd() gives the end of every channel in GetV().
+ */
+
+// First index >= a_from with id >= a_id, or the size if none. Gallops from
+// a_from, so short hops stay cheap and long skips are logarithmic.
+uint32_t ChannelSeek(Vector<uint32_t> const &, uint32_t, uint32_t);
+
+// Index range [i0, i1) of the channels with first <= id <= last.
+void ChannelRange(Value const &, uint32_t, uint32_t, uint32_t *, uint32_t
+    *);
+
+// Indices into two values with the same channel id.
+struct ChannelPair {
+  uint32_t l;
+  uint32_t r;
+};
+void ChannelIntersect(Value const &, Value const &, std::vector<ChannelPair>
+    *);
+
+// Run of channels [i0, i1) from one source of a ChannelMerge.
+struct ChannelRun {
+  uint32_t src;
+  uint32_t i0;
+  uint32_t i1;
+};
+
+/*
+ * k-way merge of channel ids with a heap over the sources. Every Next gives
+ * the lowest remaining channel id and the sources that have it, in source
+ * order. When only one source has it, its run continues as far as it is
+ * below every other source, so callers can copy whole ranges.
+ */
+class ChannelMerge {
+  public:
+    ChannelMerge();
+    void Clear();
+    // Adds the next source, which must outlive the walk.
+    void Add(Value const *);
+    bool Next(std::vector<ChannelRun> *);
+
+  private:
+    struct Entry {
+      uint32_t id;
+      uint32_t src;
+      uint32_t i;
+      bool operator<(Entry const &) const;
+    };
+    std::vector<Value const *> m_src_vec;
+    std::vector<Entry> m_heap;
+};
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * plutt, a scriptable monitor for experimental data.
+ *
+ * Copyright (C) 2025
+ * Hans Toshihide Toernqvist <hans.tornqvist@chalmers.se>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+/*
+ * Node state checkpoints, so slowly built calibrations survive restarts.
+ *
+ * A checkpoint is a map of key -> blob, where Config makes keys from the
+ * node kind and its input expression. Blobs are in native byte order, a file
+ * from a different machine is rejected by its magic.
+ */
+class Checkpoint {
+  public:
+    Checkpoint();
+    bool Get(std::string const &, std::vector<uint8_t> const **) const;
+    // Missing file gives false without complaints.
+    bool Load(std::string const &);
+    void Put(std::string const &, std::vector<uint8_t> const &);
+    // Writes a temp file and renames it over the old one.
+    bool Save(std::string const &) const;
+
+  private:
+    std::map<std::string, std::vector<uint8_t>> m_blob_map;
+};
+
+/* Interface for nodes with state worth a checkpoint. */
+class Checkpointable {
+  public:
+    virtual ~Checkpointable() {}
+    virtual char const *StateKind() const = 0;
+    // Returns false on inconsistent blob, the state must then be untouched.
+    virtual bool StateLoad(std::vector<uint8_t> const &) = 0;
+    virtual void StateSave(std::vector<uint8_t> *) const = 0;
+};
+
+// Sequential blob (de)serialization, the offset is advanced by getters.
+void StatePut(std::vector<uint8_t> *, void const *, size_t);
+bool StateGet(std::vector<uint8_t> const &, size_t *, void *, size_t);
+
+template <typename T> void StatePutVec(std::vector<uint8_t> *a_blob,
+    std::vector<T> const &a_vec)
+{
+  uint64_t n = a_vec.size();
+  StatePut(a_blob, &n, sizeof n);
+  StatePut(a_blob, a_vec.data(), n * sizeof(T));
+}
+
+template <typename T> bool StateGetVec(std::vector<uint8_t> const &a_blob,
+    size_t *a_ofs, std::vector<T> *a_vec)
+{
+  uint64_t n;
+  if (!StateGet(a_blob, a_ofs, &n, sizeof n) ||
+      n > (a_blob.size() - *a_ofs) / sizeof(T)) {
+    return false;
+  }
+  a_vec->resize(n);
+  return StateGet(a_blob, a_ofs, a_vec->data(), n * sizeof(T));
+}
+
+#endif
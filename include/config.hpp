@@ -32,6 +32,8 @@ struct BitfieldArg;
 struct FilterRangeCond;
 struct FilterRangeArg;
 struct MergeArg;
+class Checkpoint;
+class Checkpointable;
 class CutPolygon;
 class Node;
 class NodeAlias;
@@ -53,7 +55,7 @@ class Config {
         double, bool, double, unsigned, double);
     NodeValue *AddArray(NodeValue *, uint64_t, uint64_t = 0);
     NodeValue *AddBitfield(BitfieldArg *);
-    NodeValue *AddCluster(NodeValue *);
+    NodeValue *AddCluster(NodeValue *, uint32_t, uint32_t);
     NodeValue *AddCoarseFine(NodeValue *, NodeValue *, double);
     NodeValue *AddCut(CutPolygon *);
     NodeValue *AddFilterRange(std::vector<FilterRangeCond> const &,
@@ -61,7 +63,7 @@ class Config {
     void AddFit(char const *, double, double);
     NodeValue *AddFloor(NodeValue *);
     void AddHist1(char const *, NodeValue *, uint32_t, char const *,
-        PeakFitVec const &, bool, bool, double, unsigned, double);
+        PeakFitVec const &, bool, bool, uint32_t, double, unsigned, double);
     void AddHist2(char const *, NodeValue *, NodeValue *, uint32_t, uint32_t,
         char const *, char const *, bool, double, unsigned, double, double,
         bool);
@@ -89,9 +91,20 @@ class Config {
     void ClockMatch(NodeValue *, double);
     void ColormapSet(char const *);
     void HistCutAdd(CutPolygon *);
+    // Caps the multiplicity of the named signal, or of all signals without
+    // their own cap if the name is null.
+    void MultMaxSet(char const *, uint32_t, bool);
+    void MultOver();
+    // Per-signal counts of events over their multiplicity caps.
+    void MultOverPrint() const;
     unsigned UIRateGet() const;
     void UIRateSet(unsigned);
 
+    // Loads node states from the given path, which is also where they are
+    // periodically and finally saved.
+    void StateLoad(char const *);
+    void StateSave();
+
     std::string GetLocStr() const;
     void SetLoc(int, int);
 
@@ -114,7 +127,16 @@ class Config {
     void NodeCuttableAdd(NodeCuttable *);
     void NodeValueAdd(std::string const &, NodeValue *);
     NodeValue *NodeValueGet(std::string const &);
+    std::string DotExpr(uintptr_t) const;
+    void StateAdd(Node *, Checkpointable *);
+    void StateCollect(Checkpoint *);
+    void StateKeysSet();
 
+    struct MultMax {
+      uint32_t max;
+      bool skip;
+      std::string loc;
+    };
     struct FitEntry {
       double k;
       double m;
@@ -147,6 +169,10 @@ class Config {
     CutPolyList m_cut_poly_list;
     std::map<std::string, CutPolyList> m_cut_ref_map;
     std::map<std::string, FitEntry> m_fit_map;
+    MultMax m_mult_max;
+    std::map<std::string, MultMax> m_mult_max_map;
+    // Set by signals when an event hit a multiplicity cap.
+    bool m_mult_over;
     struct {
       NodeValue *node;
       double s_from_ts;
@@ -154,6 +180,20 @@ class Config {
       Input::Scalar ts0;
       double t0;
     } m_clock_match;
+    class StateWriter;
+    // Checkpointed nodes in parse order, keyed after parsing when the dot
+    // graph is complete.
+    std::vector<std::pair<Node *, Checkpointable *>> m_state_node_vec;
+    struct StateEntry {
+      Checkpointable *node;
+      // Node label with parameters, a changed node rejects its old state.
+      std::string fingerprint;
+    };
+    // Keyed by "kind(inputs)", see StateKeysSet.
+    std::map<std::string, StateEntry> m_state_map;
+    std::string m_state_path;
+    uint64_t m_state_t;
+    StateWriter *m_state_writer;
     size_t m_colormap;
     unsigned m_ui_rate;
     uint64_t m_evid;
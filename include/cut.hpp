@@ -34,6 +34,9 @@ struct NodeCutValue {
 };
 
 // Contains polygon vertices and tests if 1d/2d coords are inside.
+// 2d polygons are lazily compiled into a bounding box and a grid of cells
+// which are inside, outside, or crossed by an edge, and only points in edge
+// cells need the exact winding test.
 class CutPolygon {
   public:
     struct Point {
@@ -50,39 +53,61 @@ class CutPolygon {
     bool Test(double, double) const;
 
   private:
+    enum Cell {
+      CELL_OUT,
+      CELL_IN,
+      CELL_EDGE
+    };
+    void Compile() const;
+    bool TestExact(double, double) const;
+
     std::string m_title;
     int m_dim;
     std::vector<Point> m_point_vec;
+    // Compiled on the first 2d test, AddPoint invalidates.
+    mutable bool m_is_compiled;
+    mutable double m_min_x, m_min_y;
+    mutable double m_max_x, m_max_y;
+    mutable double m_scale_x, m_scale_y;
+    mutable std::vector<uint8_t> m_grid;
 };
 
 // Tests 1d/2d coords against a list of polygons.
+// Every polygon is tested once per coord into a bitmask, which the data and
+// event entries then pick bits from.
 class CutProducerList {
   public:
     CutProducerList();
     ~CutProducerList();
     NodeCutValue *AddData(CutPolygon const *);
     bool *AddEvent(CutPolygon const *);
+    bool IsEmpty() const;
     void Reset();
     void Test(Input::Type, Input::Scalar const &);
     void Test(Input::Type, Input::Scalar const &,
         Input::Type, Input::Scalar const &);
 
   private:
-    typedef std::map<CutPolygon const *, bool> CutPolyMap;
-    CutPolyMap::iterator AddCutPolygon(CutPolygon const *);
+    CutProducerList(CutProducerList const &);
+    CutProducerList &operator=(CutProducerList const &);
+    uint32_t AddCutPolygon(CutPolygon const *);
+    bool MaskTest(uint32_t) const;
+
     struct EntryData {
-      EntryData(CutPolyMap::iterator);
-      CutPolyMap::iterator cut_poly_it;
+      EntryData(uint32_t);
+      uint32_t poly_i;
       NodeCutValue value;
     };
     struct EntryEvent {
-      EntryEvent(CutPolyMap::iterator);
-      CutPolyMap::iterator cut_poly_it;
+      EntryEvent(uint32_t);
+      uint32_t poly_i;
       bool is_ok;
     };
-    CutPolyMap m_cut_poly_map;
+    std::vector<CutPolygon const *> m_poly_vec;
+    std::vector<uint64_t> m_mask;
     std::vector<EntryData *> m_cut_data_vec;
-    std::vector<EntryEvent> m_cut_event_vec;
+    // Consumers keep pointers to is_ok, so entries must not move.
+    std::vector<EntryEvent *> m_cut_event_vec;
 };
 
 // Processes a list of cuttable nodes and points to their results.
@@ -36,16 +36,26 @@ struct PeakFitEntry {
 typedef std::vector<PeakFitEntry> PeakFitVec;
 
 /*
- * Fitting y-offset functions against vector range [left_i, right_i].
- * Since this online tool ranks reasonable visualization higher than correct
- * decimals, the curve peak is constrained with max_y. This value should be
- * the max in the histogram, and will after fitting be close to GetOfs() +
- * GetAmp().
+ * Raw fit parameters in bin units. Passing the result of one fit to the next
+ * one on a slightly changed histogram warm-starts it.
+ */
+struct FitParams {
+  FitParams();
+  bool is_set;
+  double x[6];
+};
+
+/*
+ * Fitting y-offset functions against vector range [left_i, right_i] with a
+ * built-in Levenberg-Marquardt solver. Initial values are estimated from the
+ * range, max_y should be the max in the histogram and is only used when no
+ * peak sticks out. A failed or impossible fit gives a zero amplitude.
  */
 
 class FitExpGauss {
   public:
-    FitExpGauss(std::vector<uint32_t> const &, double, uint32_t, uint32_t);
+    FitExpGauss(std::vector<uint32_t> const &, double, uint32_t, uint32_t,
+        FitParams * = nullptr);
     ~FitExpGauss();
     double GetY() const;
     double GetExpPhase() const;
@@ -65,7 +75,8 @@ class FitExpGauss {
 
 class FitGauss {
   public:
-    FitGauss(std::vector<uint32_t> const &, double, uint32_t, uint32_t);
+    FitGauss(std::vector<uint32_t> const &, double, uint32_t, uint32_t,
+        FitParams * = nullptr);
     ~FitGauss();
     double GetY() const;
     double GetAmp() const;
@@ -23,7 +23,9 @@
 #ifndef GUI_HPP
 #define GUI_HPP
 
+class Hist1Pyramid;
 class LinearTransform;
+class TiledCounts;
 
 /*
  * GUI interface for plots and such.
@@ -54,6 +56,9 @@ class Gui {
       public:
         virtual ~Plot();
         virtual void Draw(Gui *) = 0;
+        // Changes whenever the latched copy changes, so GUI:s can skip
+        // re-drawing what they already have.
+        virtual uint64_t GetVersion() = 0;
         virtual void Latch() = 0;
     };
 
@@ -69,19 +74,36 @@ class Gui {
 
     virtual void DrawAnnular(uint32_t, Axis const &, double, double, Axis
         const &, double, bool, std::vector<uint32_t> const &) = 0;
+    // The pyramid summarizes the same bins, and the float vector is an
+    // optional per-bin background, empty if unused.
     virtual void DrawHist1(uint32_t, Axis const &, LinearTransform const &,
-        bool, bool, std::vector<uint32_t> const &, std::vector<Peak> const &)
-        = 0;
+        bool, bool, std::vector<uint32_t> const &, Hist1Pyramid const &,
+        std::vector<Peak> const &, std::vector<float> const &) = 0;
+    // Only touched tiles of the counts need visiting.
     virtual void DrawHist2(uint32_t, Axis const &, Axis const &,
         LinearTransform const &, LinearTransform const &,
-        bool, std::vector<uint32_t> const &) = 0;
+        bool, TiledCounts const &) = 0;
+
+    // Plots not visible in any GUI are latched less often. A GUI that
+    // cannot tell what its users look at answers kUnknown, and if no GUI
+    // can tell, everything is latched.
+    enum Visibility {
+      kHidden,
+      kVisible,
+      kUnknown
+    };
+    virtual Visibility GetVisibility(uint32_t) = 0;
 
     friend class GuiCollection;
 };
 
 class GuiCollection {
   public:
+    GuiCollection();
+    ~GuiCollection();
+
     void AddGui(Gui *);
+    void RemoveGui(Gui *);
 
     void AddPage(std::string const &);
     uint32_t AddPlot(std::string const &, Gui::Plot *);
@@ -94,22 +116,31 @@ class GuiCollection {
         Gui::Axis const &, double, bool, std::vector<uint32_t> const &);
     void DrawHist1(Gui *, uint32_t, Gui::Axis const &,
         LinearTransform const &, bool, bool, std::vector<uint32_t> const &,
-        std::vector<Gui::Peak> const &);
+        Hist1Pyramid const &, std::vector<Gui::Peak> const &,
+        std::vector<float> const &);
     void DrawHist2(Gui *, uint32_t, Gui::Axis const &, Gui::Axis const &,
         LinearTransform const &, LinearTransform const &,
-        bool, std::vector<uint32_t> const &);
+        bool, TiledCounts const &);
 
   private:
+    GuiCollection(GuiCollection const &);
+    GuiCollection &operator=(GuiCollection const &);
+
+    class LatchBatch;
+
     std::map<Gui *, uint32_t> m_gui_map;
     struct Entry {
       Entry();
       Entry(Entry const &);
       Gui::Plot *plot;
       std::vector<uint32_t> id_vec;
+      uint64_t t_latch;
       private:
         Entry &operator=(Entry const &);
     };
     std::vector<Entry> m_plot_vec;
+    std::vector<Gui::Plot *> m_latch_vec;
+    LatchBatch *m_latch_batch;
 };
 
 #endif
@@ -30,6 +30,8 @@
 #ifndef IMPLUTT_HPP
 #define IMPLUTT_HPP
 
+class Hist1Pyramid;
+class TiledCounts;
 union SDL_Event;
 struct SDL_Renderer;
 struct SDL_Window;
@@ -138,6 +140,13 @@ namespace ImPlutt {
       Window *window;
       PlotState *plot_state;
       std::vector<float> vec;
+      // Running sums across the projected axis, so a band of any width
+      // costs one subtraction per output bin. Sparse histograms sum the
+      // band directly instead, the sums would be dense.
+      std::vector<double> prefix;
+      uint64_t prefix_version;
+      size_t prefix_bins_x;
+      size_t prefix_bins_y;
       Point point;
       int width;
       Rect band_r;
@@ -159,6 +168,8 @@ namespace ImPlutt {
     bool do_clear;
     void CutClear();
     bool GoTo(UserState);
+    // True while user interaction overrides the incoming limits.
+    bool IsTense() const;
     void Project(UserState, char const *, Point const &, Point const &);
     void Unproject();
     private:
@@ -166,6 +177,27 @@ namespace ImPlutt {
       PlotState &operator=(PlotState const &);
   };
 
+  // Streaming texture for a 2D plot, kept by the caller between frames and
+  // only refilled when anything that goes into the pixels changed.
+  struct Hist2Texture {
+    Hist2Texture();
+    ~Hist2Texture();
+    SDL_Texture *tex;
+    size_t w;
+    size_t h;
+    uint64_t version;
+    size_t colormap;
+    size_t bins_x;
+    size_t bins_y;
+    bool is_log;
+    int rect_w;
+    int rect_h;
+    Style style_i;
+    private:
+      Hist2Texture(Hist2Texture const &);
+      Hist2Texture &operator=(Hist2Texture const &);
+  };
+
   class Plot {
     public:
       Plot(Window *, PlotState *, char const *, Pos const &, Point const &,
@@ -223,21 +255,8 @@ namespace ImPlutt {
     Pos cursor;
     // Max height of widgets until 'Newline'.
     int max_h;
-  };
-
-  // Text texture cache.
-  struct TextKey {
-    TextKey();
-    std::string str;
-    int font_style;
-    int style_i;
-    int style_sub_i;
-    bool operator()(TextKey const &, TextKey const &) const;
-  };
-  struct TextTexture {
-    Rect r;
-    SDL_Texture *tex;
-    uint64_t t_last;
+    // Nothing is rendered, widgets only advance the layout.
+    bool is_muted;
   };
 
   class Window {
@@ -253,12 +272,15 @@ namespace ImPlutt {
       bool DoClose() const;
       void ProcessEvent(SDL_Event const &);
 
-      void Begin();
+      // A cached window keeps its pixels between frames, see Redraw.
+      void Begin(bool = false);
       void End();
       Pos GetSize();
       int Newline();
       void Pop();
       void Push(Rect const &);
+      // Clears the current level if dirty, otherwise mutes it.
+      bool Redraw(bool);
       void Rewind();
 
       void Advance(Pos const &);
@@ -274,10 +296,10 @@ namespace ImPlutt {
           Point const &, std::vector<T> const &, size_t, size_t, double,
           double, double);
       template <typename T> void PlotHist1(Plot const *, double, double,
-          std::vector<T> const &, size_t, bool);
-      template <typename T> void PlotHist2(Plot  *, size_t, Point const &,
-          Point const &, std::vector<T> const &, size_t, size_t,
-          std::vector<uint8_t> &);
+          std::vector<T> const &, size_t, bool, Hist1Pyramid const * =
+          nullptr);
+      void PlotHist2(Plot *, size_t, Point const &, Point const &,
+          TiledCounts const &, uint64_t, Hist2Texture *);
       void PlotLines(Plot const *, std::vector<Point> const &);
       void PlotText(Plot const *, char const *, Point const &, TextAlign,
           bool, bool);
@@ -305,9 +327,16 @@ namespace ImPlutt {
       void RenderLine(Pos const &, Pos const &);
       void RenderLineDashed(Pos const &, Pos const &, double, double);
       void RenderRect(Rect const &, bool);
+      // Batched filled rects, submitted in one call by RenderRectsFlush.
+      void RenderRectsAdd(Rect const &);
+      void RenderRectsAddLine(Pos const &, Pos const &);
+      void RenderRectsFlush();
       void RenderTexture(SDL_Texture *, Rect const &);
       void RenderTriangle(Pos const *, Pos const *, Pos const *);
       void RenderCross(Pos const &, int);
+      // All glyphs live in one atlas texture, each text is one batch.
+      SDL_Rect RenderGlyphGet(uint32_t, unsigned, unsigned, uint8_t const *);
+      void RenderGlyphFlush();
       void RenderText(char const *, TextStyle, int, Pos const &);
       Pos RenderTextMeasure(char const *, TextStyle);
       void RenderTransparent(bool);
@@ -321,9 +350,21 @@ namespace ImPlutt {
       std::list<Event> m_event_list;
       Pos m_pointer;
       std::list<Level> m_level_stack;
-      std::map<TextKey, TextTexture, TextKey> m_text_tex_map;
       bool m_do_close;
-      std::list<SDL_Texture *> m_tex_destroy_list;
+      SDL_Texture *m_glyph_tex;
+      // Shelf packing position.
+      Pos m_glyph_pen;
+      int m_glyph_row_h;
+      // Atlas rect indexed by glyph id, empty if not packed.
+      std::vector<SDL_Rect> m_glyph_rect_vec;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+      std::vector<SDL_Vertex> m_glyph_vertex_vec;
+      std::vector<int> m_glyph_index_vec;
+#endif
+      std::vector<SDL_Rect> m_rect_vec;
+      SDL_Texture *m_canvas;
+      bool m_do_redraw;
+      bool m_do_present;
 
       friend class Plot;
   };
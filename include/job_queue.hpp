@@ -0,0 +1,51 @@
+/*
+ * plutt, a scriptable monitor for experimental data.
+ *
+ * Copyright (C) 2025
+ * Hans Toshihide Toernqvist <hans.tornqvist@chalmers.se>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+#ifndef JOB_QUEUE_HPP
+#define JOB_QUEUE_HPP
+
+/*
+ * Jobs, eg peak fits and plot latching, run on a few background threads so
+ * the GUI never waits for them. A job is queued at most once, queuing it
+ * again while it's waiting is a no-op, so owners can keep the input up to
+ * date and queue on every change. A job never runs on two threads at once.
+ */
+class Job {
+  public:
+    Job();
+    virtual ~Job();
+    void Queue();
+    // Unqueues, and waits if running, must be called before destruction.
+    void Cancel();
+    virtual void Run() = 0;
+
+  private:
+    Job(Job const &);
+    Job &operator=(Job const &);
+
+    bool m_is_queued;
+    bool m_is_running;
+
+    friend class JobQueue;
+};
+
+#endif
@@ -22,6 +22,7 @@
 #ifndef NODE_BITFIELD_HPP
 #define NODE_BITFIELD_HPP
 
+#include <channel.hpp>
 #include <node.hpp>
 
 /*
@@ -53,16 +54,22 @@ class NodeBitfield: public NodeValue {
       Field(NodeValue *, uint32_t);
       NodeValue *node;
       uint32_t bits;
+      // Sum of the bits of all earlier fields.
+      uint32_t ofs;
       Value const *value;
-      uint32_t i;
-      uint32_t vi;
     };
 
     NodeBitfield(NodeBitfield const &);
     NodeBitfield &operator=(NodeBitfield const &);
 
+    static uint64_t GetPart(Field const &, uint32_t);
+    bool ProcessSameLayout();
+
     std::vector<Field> m_source_vec;
     Value m_value;
+    std::vector<Input::Scalar> m_word_vec;
+    ChannelMerge m_merge;
+    std::vector<ChannelRun> m_run_vec;
 };
 
 #endif
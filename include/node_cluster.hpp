@@ -26,24 +26,47 @@
 #include <node.hpp>
 
 /*
- * Clusterizes neighbouring channels.
+ * Clusterizes neighbouring channels, allowing 'gap' empty channels in
+ * between. With a non-zero 'width', ids are pixels y * width + x and are
+ * clusterized in 2D.
  */
 
 class NodeCluster: public NodeValue {
   public:
-    NodeCluster(std::string const &, NodeValue *);
+    NodeCluster(std::string const &, NodeValue *, uint32_t, uint32_t);
     Value const &GetValue(uint32_t);
     void Process(uint64_t);
 
   private:
+    struct Cluster {
+      double x;
+      double y;
+      double e;
+    };
+
     NodeCluster(NodeCluster const &);
     NodeCluster &operator=(NodeCluster const &);
 
+    void Process1D(Value const &);
+    void Process2D(Value const &);
+    uint32_t Root(uint32_t);
+
     NodeValue *m_child;
+    uint32_t m_gap;
+    uint32_t m_width;
     // Clusters.
     Value m_clu;
     // Eta.
     Value m_eta;
+    // Reused between events, only grow.
+    std::vector<Cluster> m_cluster_vec;
+    std::vector<uint32_t> m_parent_vec;
+    // Occupied rows of the current event and their first hits, index the
+    // ring of label grid lines.
+    std::vector<uint32_t> m_row_vec;
+    std::vector<uint32_t> m_row_hit_vec;
+    // Hit index + 1 per pixel, all zero between events.
+    std::vector<uint32_t> m_label_grid;
 };
 
 #endif
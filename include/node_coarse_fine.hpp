@@ -23,16 +23,20 @@
 #define NODE_COARSE_FINE_HPP
 
 #include <cal.hpp>
+#include <checkpoint.hpp>
 #include <node.hpp>
 
 /*
  * On-the-fly fine-time calibration merged with coarse times.
  */
-class NodeCoarseFine: public NodeValue {
+class NodeCoarseFine: public NodeValue, public Checkpointable {
   public:
     NodeCoarseFine(std::string const &, NodeValue *, NodeValue *, double);
     Value const &GetValue(uint32_t);
     void Process(uint64_t);
+    char const *StateKind() const;
+    bool StateLoad(std::vector<uint8_t> const &);
+    void StateSave(std::vector<uint8_t> *) const;
 
   private:
     NodeCoarseFine(NodeCoarseFine const &);
@@ -41,7 +45,9 @@ class NodeCoarseFine: public NodeValue {
     NodeValue *m_coarse;
     NodeValue *m_fine;
     double m_fine_range;
-    std::vector<CalFineTime> m_cal_fine;
+    CalFineTable m_cal_fine;
+    std::vector<uint32_t> m_fine_buf;
+    std::vector<double> m_ft_buf;
     Value m_value;
 };
 
@@ -53,9 +53,13 @@ class NodeFilterRange: public NodeValue {
 
     NodeFilterRange(NodeFilterRange const &);
     NodeFilterRange &operator=(NodeFilterRange const &);
+    void MaskCond(FilterRangeCond const &, uint32_t);
 
     CondVec m_cond_vec;
     std::vector<Arg> m_arg_vec;
+    // Per value of the first condition, conditions are ANDed in.
+    std::vector<double> m_dbl;
+    std::vector<uint8_t> m_mask;
 };
 
 #endif
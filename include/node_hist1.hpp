@@ -34,8 +34,8 @@
 class NodeHist1: public NodeCuttable {
   public:
     NodeHist1(std::string const &, char const *, NodeValue *, uint32_t,
-        LinearTransform const &, PeakFitVec const &, bool, bool, double,
-        unsigned, double);
+        LinearTransform const &, PeakFitVec const &, bool, bool, uint32_t,
+        double, unsigned, double);
     void Process(uint64_t);
 
   private:
@@ -23,6 +23,7 @@
 #ifndef NODE_MATCH_ID_HPP
 #define NODE_MATCH_ID_HPP
 
+#include <channel.hpp>
 #include <node.hpp>
 
 /*
@@ -42,6 +43,7 @@ class NodeMatchId: public NodeValue {
     NodeValue *m_node_r;
     Value m_val_l;
     Value m_val_r;
+    std::vector<ChannelPair> m_pair_vec;
 };
 
 #endif
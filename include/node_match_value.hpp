@@ -22,6 +22,7 @@
 #ifndef NODE_MATCH_VALUE_HPP
 #define NODE_MATCH_VALUE_HPP
 
+#include <channel.hpp>
 #include <node.hpp>
 
 /*
@@ -42,6 +43,7 @@ class NodeMatchValue: public NodeValue {
     double m_cutoff;
     Value m_val_l;
     Value m_val_r;
+    std::vector<ChannelPair> m_pair_vec;
 };
 
 #endif
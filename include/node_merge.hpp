@@ -22,6 +22,7 @@
 #ifndef NODE_MERGE_HPP
 #define NODE_MERGE_HPP
 
+#include <channel.hpp>
 #include <node.hpp>
 
 /*
@@ -52,8 +53,6 @@ class NodeMerge: public NodeValue {
       Field(NodeValue *);
       NodeValue *node;
       Value const *value;
-      uint32_t i;
-      uint32_t vi;
     };
 
     NodeMerge(NodeMerge const &);
@@ -61,6 +60,8 @@ class NodeMerge: public NodeValue {
 
     std::vector<Field> m_source_vec;
     Value m_value;
+    ChannelMerge m_merge;
+    std::vector<ChannelRun> m_run_vec;
 };
 
 #endif
@@ -22,6 +22,7 @@
 #ifndef NODE_MEXPR_HPP
 #define NODE_MEXPR_HPP
 
+#include <channel.hpp>
 #include <node.hpp>
 
 /*
@@ -61,6 +62,7 @@ class NodeMExpr: public NodeValue {
     int m_mix;
     Operation m_op;
     Value m_value;
+    std::vector<ChannelPair> m_pair_vec;
 };
 
 #endif
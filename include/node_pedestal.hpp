@@ -22,40 +22,46 @@
 #ifndef NODE_PEDESTAL_HPP
 #define NODE_PEDESTAL_HPP
 
+#include <checkpoint.hpp>
 #include <node.hpp>
 
 /*
  * On-the-fly pedestal subtraction.
  */
-class NodePedestal: public NodeValue {
+class NodePedestal: public NodeValue, public Checkpointable {
   public:
     NodePedestal(std::string const &, NodeValue *, double, NodeValue *);
     Value const &GetValue(uint32_t);
     void Process(uint64_t);
+    char const *StateKind() const;
+    bool StateLoad(std::vector<uint8_t> const &);
+    void StateSave(std::vector<uint8_t> *) const;
 
   private:
     NodePedestal(NodePedestal const &);
     NodePedestal &operator=(NodePedestal const &);
+    void StatsAdd(uint32_t, double);
     void StatsFit(uint32_t);
+    void StatsRefresh(uint32_t);
 
-    struct StatPage {
-      uint32_t num;
-      double mean;
-      double M2;
-      double var;
-      void Add(double);
-    };
-    struct Stats {
-      StatPage page[2];
-      size_t write_i;
-      void Get(double *, double *);
-    };
     NodeValue *m_child;
     double m_cutoff;
     NodeValue *m_tpat;
     Value m_value;
     Value m_sigma;
-    std::vector<Stats> m_stats;
+    // Per-channel stats as structure-of-arrays, two Welford pages per
+    // channel at [2 * ch + page].
+    std::vector<uint32_t> m_page_num;
+    std::vector<double> m_page_mean;
+    std::vector<double> m_page_M2;
+    std::vector<uint8_t> m_write_i;
+    // Cached mean and sigma, and #adds since the cache was refreshed.
+    std::vector<double> m_mean;
+    std::vector<double> m_std;
+    std::vector<uint32_t> m_stale;
+    uint64_t m_refresh_ms;
+    // Values of the current event as doubles.
+    std::vector<double> m_dbl;
 };
 
 #endif
@@ -41,6 +41,8 @@ class NodeSignal: public NodeValue {
     NodeSignal(Config &, std::string const &);
     void BindSignal(std::string const &, MemberType, size_t, Input::Type);
     Value const &GetValue(uint32_t);
+    uint64_t MultOverGet() const;
+    void MultMaxSet(uint32_t, bool);
     void Process(uint64_t);
     void SetLocStr(std::string const &);
     void UnbindSignal();
@@ -59,6 +61,11 @@ class NodeSignal: public NodeValue {
     Member *m_id;
     Member *m_end;
     Member *m_v;
+    // Events with more hits than this are truncated or skipped, to bound the
+    // time spent on broken or noisy events.
+    uint32_t m_mult_max;
+    bool m_mult_skip;
+    uint64_t m_mult_over_num;
 };
 
 #endif
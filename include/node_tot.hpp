@@ -22,6 +22,7 @@
 #ifndef NODE_TOT_HPP
 #define NODE_TOT_HPP
 
+#include <channel.hpp>
 #include <node.hpp>
 
 /*
@@ -41,6 +42,7 @@ class NodeTot: public NodeValue {
     NodeValue *m_t;
     double m_range;
     Value m_value;
+    std::vector<ChannelPair> m_pair_vec;
 };
 
 #endif
@@ -50,10 +50,13 @@ class RootGui: public Gui {
     void DrawAnnular(uint32_t, Axis const &, double, double, Axis const &,
         double, bool, std::vector<uint32_t> const &);
     void DrawHist1(uint32_t, Axis const &, LinearTransform const &, bool,
-        bool, std::vector<uint32_t> const &, std::vector<Peak> const &);
+        bool, std::vector<uint32_t> const &, Hist1Pyramid const &,
+        std::vector<Peak> const &, std::vector<float> const &);
     void DrawHist2(uint32_t, Axis const &, Axis const &,
         LinearTransform const &, LinearTransform const &,
-        bool, std::vector<uint32_t> const &);
+        bool, TiledCounts const &);
+
+    Visibility GetVisibility(uint32_t);
 
   private:
     RootGui(RootGui const &);
@@ -74,9 +77,12 @@ class RootGui: public Gui {
         TH2Poly *hp;
         std::vector<int> bin_vec;
       } poly;
+      TGraph bg_gr;
       std::vector<TGraph> gr_vec;
       std::vector<TText> tx_vec;
+      uint64_t version;
       bool do_clear;
+      bool do_draw;
       bool is_log_set;
       bool is_log;
       private:
@@ -42,10 +42,13 @@ class SdlGui: public Gui {
     void DrawAnnular(uint32_t, Axis const &, double, double, Axis const &,
         double, bool, std::vector<uint32_t> const &);
     void DrawHist1(uint32_t, Axis const &, LinearTransform const &, bool,
-        bool, std::vector<uint32_t> const &, std::vector<Gui::Peak> const &);
+        bool, std::vector<uint32_t> const &, Hist1Pyramid const &,
+        std::vector<Gui::Peak> const &, std::vector<float> const &);
     void DrawHist2(uint32_t, Axis const &, Axis const &,
         LinearTransform const &, LinearTransform const &,
-        bool, std::vector<uint32_t> const &);
+        bool, TiledCounts const &);
+
+    Visibility GetVisibility(uint32_t);
 
     bool DoClose();
 
@@ -58,7 +61,10 @@ class SdlGui: public Gui {
       Plot *plot;
       bool is_log_set;
       ImPlutt::PlotState plot_state;
-      std::vector<uint8_t> pixels;
+      ImPlutt::Hist2Texture hist2_tex;
+      // What the cached pixels were drawn from.
+      uint64_t version;
+      bool is_tense;
       private:
         PlotWrap(PlotWrap const &);
         PlotWrap &operator=(PlotWrap const &);
@@ -71,6 +77,7 @@ class SdlGui: public Gui {
     ImPlutt::Window *m_window;
     std::vector<Page *> m_page_vec;
     Page *m_page_sel;
+    std::string m_status_prev;
 };
 
 #endif
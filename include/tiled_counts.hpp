@@ -0,0 +1,99 @@
+/*
+ * plutt, a scriptable monitor for experimental data.
+ *
+ * Copyright (C) 2025
+ * Hans Toshihide Toernqvist <hans.tornqvist@chalmers.se>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+#ifndef TILED_COUNTS_HPP
+#define TILED_COUNTS_HPP
+
+/*
+ * Histogram counters stored in tiles of adaptive width.
+ * Every tile starts with 16-bit counters and is promoted to 32 and then 64
+ * bits only when one of its bins saturates. Most bins in online monitoring
+ * are small, so this halves memory and cache footprint compared to plain
+ * 32-bit counters, and long runs cannot silently wrap around.
+ * 1D counts use up to 4096x1 tiles, 2D counts up to 64x64 tiles, smaller
+ * histograms get tiles just covering them. Large histograms only
+ * allocate tiles on first touch, so eg correlation plots with a populated
+ * diagonal band only pay for the band.
+ */
+class TiledCounts {
+  public:
+    TiledCounts();
+    void Add(TiledCounts const &);
+    void Add(size_t, size_t, uint64_t);
+    void Clear();
+    // Dense row-major copy, saturates to 32 bits.
+    void Copy(std::vector<uint32_t> *) const;
+    // Same for the rectangle (x, y, w, h), untouched tiles read as 0.
+    void CopyRect(size_t, size_t, size_t, size_t, uint32_t *) const;
+    uint64_t Get(size_t, size_t) const;
+    size_t GetHeight() const;
+    // Over all bins, saturated to 32 bits.
+    void GetMinMax(uint32_t *, uint32_t *) const;
+    // Bytes held by the tiles.
+    size_t GetMemSize() const;
+    size_t GetSize() const;
+    size_t GetTileHeight() const;
+    size_t GetTileWidth() const;
+    size_t GetWidth() const;
+    void Halve();
+    // False if no bin in the tile covering the given bin was ever touched.
+    bool HasTile(size_t, size_t) const;
+    void Inc(size_t, size_t);
+    bool IsSparse() const;
+    void Resize(size_t, size_t);
+    void Set(std::vector<uint32_t> const &, size_t, size_t);
+    void Sub(TiledCounts const &);
+    void Zero();
+
+  private:
+    enum Width {
+      WIDTH_16,
+      WIDTH_32,
+      WIDTH_64
+    };
+    struct Tile {
+      Tile();
+      Width width;
+      std::vector<uint16_t> v16;
+      std::vector<uint32_t> v32;
+      std::vector<uint64_t> v64;
+    };
+    size_t BinIndex(size_t, size_t) const;
+    size_t TileIndex(size_t, size_t) const;
+    void TileAlloc(Tile *) const;
+    static uint64_t TileGet(Tile const &, size_t);
+    static bool TileIsAlloc(Tile const &);
+    static void TilePromote(Tile *);
+    static void TileSet(Tile *, size_t, uint64_t);
+    void TileZero(Tile *, bool) const;
+
+    size_t m_width;
+    size_t m_height;
+    unsigned m_tile_w_bits;
+    unsigned m_tile_h_bits;
+    size_t m_tiles_x;
+    size_t m_tile_size;
+    bool m_is_sparse;
+    std::vector<Tile> m_tile_vec;
+};
+
+#endif
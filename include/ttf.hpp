@@ -31,16 +31,23 @@ struct FontSize {
   unsigned w;
   unsigned h;
 };
-struct FontPrinted {
-  FontPrinted();
-  FontSize size;
-  std::vector<uint8_t> bmap;
+// Placed glyph, the bitmap is 8-bit coverage and stays valid until the
+// font is unloaded.
+struct FontGlyph {
+  // Unique per font, size, glyph and boldness.
+  uint32_t id;
+  // Top-left corner relative to the text position.
+  int x;
+  int y;
+  unsigned w;
+  unsigned h;
+  uint8_t const *bmap;
 };
 
 int FontGetHeight(Font *);
 Font *FontLoad(char const *);
+void FontLayout(Font *, char const *, std::vector<FontGlyph> *);
 FontSize FontMeasure(Font *, char const *);
-FontPrinted FontPrintf(Font *, char const *, uint8_t, uint8_t, uint8_t);
 void FontSetBold(Font *, bool);
 void FontSetSize(Font *, int);
 void FontUnload(Font **);
@@ -25,6 +25,8 @@
 
 #define LENGTH(x) (sizeof x / sizeof *x)
 
+class TiledCounts;
+
 // Replaces weird chars with '_' and avoids doubles.
 std::string CleanName(std::string const &);
 
@@ -59,16 +61,47 @@ std::vector<uint32_t> Rebin1(std::vector<uint32_t> const &,
 std::vector<uint32_t> Rebin2(std::vector<uint32_t> const &,
     size_t, double, double, size_t, double, double,
     size_t, double, double, size_t, double, double);
+// Only looks at touched tiles, the old bin counts come with the tiles.
+TiledCounts Rebin2(TiledCounts const &,
+    double, double, double, double,
+    size_t, double, double, size_t, double, double);
 
-// SNIP.
-std::vector<float> Snip(std::vector<uint32_t> const &, uint32_t);
-std::vector<float> Snip2(std::vector<uint32_t> const &, size_t, size_t,
-    uint32_t);
+// Min/max over aligned power-of-two blocks of a 1D histogram, so any bin
+// range can be summarized in O(log n) instead of O(n).
+class Hist1Pyramid {
+  public:
+    Hist1Pyramid();
+    void Build(std::vector<uint32_t> const &);
+    size_t GetSize() const;
+    void Query(size_t, size_t, uint32_t *, uint32_t *) const;
+
+  private:
+    struct Node {
+      uint32_t min;
+      uint32_t max;
+    };
+    std::vector<std::vector<Node>> m_level_vec;
+};
+
+// SNIP background, 2^n - 1 bins wide at most. The buffers are scratch that
+// can be kept around between calls.
+struct SnipBuf {
+  std::vector<uint32_t> v[2];
+  std::vector<uint32_t> avg;
+};
+void Snip(std::vector<uint32_t> const &, uint32_t, SnipBuf *,
+    std::vector<float> *);
+void Snip2(std::vector<uint32_t> const &, size_t, size_t, uint32_t, SnipBuf *,
+    std::vector<float> *);
 
 // Global status.
 std::string Status_get();
 void Status_set(char const *, ...);
 
+// Events which hit a multiplicity cap.
+void Pathological_add();
+uint64_t Pathological_get();
+
 // Cyclic subtraction around 0: (a,b,c) -> (a-b+(n+1/2)*c)%c-c/2
 // Note that the u64 version works with doubles immediately after the first
 // subtraction!
@@ -44,6 +44,16 @@ class Value {
     double GetV(uint32_t, bool) const;
     // Pushes scalar to given channel.
     void Push(uint32_t, Input::Scalar const &);
+    // Appends whole channels [i0, i1) of another value, the ids must not
+    // go backwards.
+    void PushChannels(Value const &, uint32_t, uint32_t);
+    // Appends all channels of another value, but with the given scalars in
+    // place of its values.
+    void PushLayout(Value const &, Input::Scalar const *);
+    // Appends the values of channels [0, i1) of another value whose mask
+    // byte is non-zero, channels without survivors are dropped. The ids
+    // must not go backwards.
+    void PushMasked(Value const &, uint32_t, uint8_t const *);
     void SetType(Input::Type);
 
   private:
@@ -26,6 +26,9 @@
 #include <fit.hpp>
 #include <gui.hpp>
 #include <input.hpp>
+#include <job_queue.hpp>
+#include <tiled_counts.hpp>
+#include <vector.hpp>
 
 typedef std::vector<uint32_t> VisualHistVec;
 
@@ -71,15 +74,55 @@ class Range {
     size_t m_stat_i;
 };
 
+/*
+ * Histogram counts sliced in time for drop_counts.
+ * The sum over all slices is kept up to date while filling, so a latch is a
+ * single copy and a rotation only subtracts the retired slice.
+ * With 0 slices the counts are instead halved every period, i.e. they decay
+ * exponentially with the period as half-life, which needs only one buffer.
+ * Every change bumps a version, so unchanged counts need not be latched.
+ */
+class VisualSlices {
+  public:
+    VisualSlices(double, unsigned);
+    void Add(size_t, size_t, uint64_t);
+    void Clear();
+    void ClearActive();
+    void Copy(VisualHistVec *) const;
+    TiledCounts const &GetSum() const;
+    uint64_t GetVersion() const;
+    void Inc(size_t, size_t);
+    void Rebin1(Gui::Axis const &, Gui::Axis const &);
+    void Rebin2(Gui::Axis const &, Gui::Axis const &, Gui::Axis const &,
+        Gui::Axis const &);
+    void Update();
+
+  private:
+    void Resum();
+
+    uint64_t m_drop_ms;
+    bool m_is_decay;
+    std::vector<TiledCounts> m_slice_vec;
+    TiledCounts m_sum;
+    size_t m_active_i;
+    uint64_t m_t_prev;
+    uint64_t m_version;
+};
+
 class Visual: public Gui::Plot {
   public:
     Visual(std::string const &);
     virtual ~Visual();
     virtual void Draw(Gui *) = 0;
+    uint64_t GetVersion();
     virtual void Latch() = 0;
 
     std::string m_name;
     uint32_t m_gui_id;
+
+  protected:
+    // Slices version of the latched copy.
+    uint64_t m_version_latch;
 };
 
 class VisualAnnular: public Visual {
@@ -105,16 +148,7 @@ class VisualAnnular: public Visual {
     Gui::Axis m_axis_r;
     Gui::Axis m_axis_p;
     std::mutex m_hist_mutex;
-    int64_t m_drop_counts_ms;
-    struct Slices {
-      Slices(unsigned a_num):
-        slice_vec(a_num),
-        active_i(0),
-        t_prev(0) {}
-      std::vector<VisualHistVec> slice_vec;
-      size_t active_i;
-      uint64_t t_prev;
-    } m_hist;
+    VisualSlices m_hist;
     Gui::Axis m_axis_r_copy;
     Gui::Axis m_axis_p_copy;
     VisualHistVec m_hist_copy;
@@ -124,16 +158,33 @@ class VisualAnnular: public Visual {
 class VisualHist: public Visual {
   public:
     VisualHist(std::string const &, uint32_t, LinearTransform const &,
-        PeakFitVec const &, bool, bool, double, unsigned, double);
+        PeakFitVec const &, bool, bool, uint32_t, double, unsigned, double);
+    ~VisualHist();
     void Draw(Gui *);
     void Fill(Input::Type, Input::Scalar const &);
     void Fit();
+    uint64_t GetVersion();
     void Latch();
     void Prefill(Input::Type, Input::Scalar const &);
 
   private:
+    VisualHist(VisualHist const &);
+    VisualHist &operator=(VisualHist const &);
+
+    // Peak fits and SNIP run in the background on the latest latched copy.
+    class FitJob: public Job {
+      public:
+        FitJob(VisualHist *);
+        void Run();
+      private:
+        FitJob(FitJob const &);
+        FitJob &operator=(FitJob const &);
+        VisualHist *m_visual;
+    };
+
     void FitGauss(std::vector<uint32_t> const &, Gui::Axis const &, PeakFitVec
-        const &);
+        const &, std::vector<Gui::Peak> *);
+    void FitRun();
 
     uint32_t m_xb;
     LinearTransform m_transform;
@@ -141,21 +192,36 @@ class VisualHist: public Visual {
     Range m_range;
     Gui::Axis m_axis;
     std::mutex m_hist_mutex;
-    int64_t m_drop_counts_ms;
-    struct Slices {
-      Slices(unsigned a_num):
-        slice_vec(a_num),
-        active_i(0),
-        t_prev(0) {}
-      std::vector<VisualHistVec> slice_vec;
-      size_t active_i;
-      uint64_t t_prev;
-    } m_hist;
+    VisualSlices m_hist;
     Gui::Axis m_axis_copy;
     VisualHistVec m_hist_copy;
+    Hist1Pyramid m_pyramid;
     bool m_is_log_y;
     bool m_is_contour;
+    uint32_t m_snip_exp;
+    FitJob m_fit_job;
+    std::mutex m_fit_mutex;
+    struct {
+      // Input, guarded by m_fit_mutex.
+      VisualHistVec hist;
+      Gui::Axis axis;
+      uint64_t sum;
+      uint64_t t_snip;
+      bool do_fit;
+      bool do_snip;
+      // Output, guarded by m_fit_mutex.
+      std::vector<Gui::Peak> peak_vec;
+      std::vector<float> bg_vec;
+      bool is_new;
+      // Only touched by the job.
+      VisualHistVec work;
+      Gui::Axis work_axis;
+      std::vector<FitParams> param_vec;
+      SnipBuf snip_buf;
+    } m_fit;
     std::vector<Gui::Peak> m_peak_vec;
+    std::vector<float> m_bg_vec;
+    uint64_t m_peak_version;
 };
 
 class VisualHist2: public Visual {
@@ -172,8 +238,24 @@ class VisualHist2: public Visual {
     void Prefill(
         Input::Type, Input::Scalar const &,
         Input::Type, Input::Scalar const &);
+    // All (x, y) combinations of the two arrays, binned per axis and then
+    // filled as the outer product of the occupied bins.
+    void FillOuter(
+        Input::Type, Vector<Input::Scalar> const &,
+        Input::Type, Vector<Input::Scalar> const &);
+    void PrefillOuter(
+        Input::Type, Vector<Input::Scalar> const &,
+        Input::Type, Vector<Input::Scalar> const &);
 
   private:
+    // Per-axis bin counts and the list of occupied bins.
+    struct OuterAxis {
+      std::vector<uint32_t> count;
+      std::vector<uint32_t> used;
+    };
+    static void OuterBin(Input::Type, Vector<Input::Scalar> const &,
+        Gui::Axis const &, OuterAxis *);
+
     uint32_t m_xb;
     uint32_t m_yb;
     LinearTransform m_transform_x;
@@ -183,20 +265,14 @@ class VisualHist2: public Visual {
     Gui::Axis m_axis_x;
     Gui::Axis m_axis_y;
     std::mutex m_hist_mutex;
-    int64_t m_drop_counts_ms;
-    struct Slices {
-      Slices(unsigned a_num):
-        slice_vec(a_num),
-        active_i(0),
-        t_prev(0) {}
-      std::vector<VisualHistVec> slice_vec;
-      size_t active_i;
-      uint64_t t_prev;
-    } m_hist;
+    VisualSlices m_hist;
     Gui::Axis m_axis_x_copy;
     Gui::Axis m_axis_y_copy;
-    VisualHistVec m_hist_copy;
+    // Stays tiled, huge mostly empty plots are never made dense.
+    TiledCounts m_hist_copy;
     bool m_is_log_z;
+    OuterAxis m_outer_x;
+    OuterAxis m_outer_y;
     struct {
       uint64_t time_ms;
       uint64_t time_ms_prev;
@@ -32,7 +32,7 @@ syn match pluttComment "\/\/.*$"
 syn match pluttNumber "\<\d\+"
 syn match pluttString "\"[^\"]*\""
 
-syn keyword pluttFunctions annular appearance binsx binsy bitfield clock_match cluster coarse_fine colormap contoured ctdc cut drop_counts drop_stats filled filter_range fit floor hist hist2d length logy logz match_index match_value max mean_arith mean_geom merge min page pedestal permutate select_index signal single sub_mod tamex3 tot tpat transformx transformy trig_map ui_rate vftx2 zero_suppress
+syn keyword pluttFunctions annular appearance binsx binsy bitfield clock_match cluster coarse_fine colormap contoured ctdc cut drop_counts drop_stats filled filter_range fit floor gap hist hist2d length logy logz match_index match_value max mean_arith mean_geom merge min mult_max page pedestal permutate select_index signal single skip snip sub_mod tamex3 tot tpat transformx transformy trig_map ui_rate vftx2 width zero_suppress
 
 hi def link pluttComment Comment
 hi def link pluttFunctions Type
@@ -19,93 +19,226 @@
  * MA  02110-1301  USA
  */
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <map>
+#include <string>
 #include <vector>
 #include <cal.hpp>
+#include <checkpoint.hpp>
 
-CalFineTime::Span::Span():
-  sum(),
-  min(1),
-  max(),
-  hist()
-{
-}
+#define STRIDE_MIN 16
+// Fine times at or above this are not accounted and convert like the last
+// bin, which bounds the stride and the tables.
+#define FINE_MAX 4096
+#define TAMEX_MAGIC 0x3ff
 
-CalFineTime::CalFineTime():
+CalFineTable::CalFineTable():
+  m_stride(STRIDE_MIN),
   m_counter(),
-  m_span_vec(2),
   m_span_i(),
-  m_acc_max(),
-  m_acc_sum(),
-  m_acc()
+  m_span_sum(),
+  m_span_min(),
+  m_span_max(),
+  m_hist(),
+  m_lut()
 {
 }
 
-void CalFineTime::Calib()
+void CalFineTable::Calib(uint32_t a_ch, unsigned a_span)
 {
-  auto &span = m_span_vec[m_span_i];
-  m_acc_max = span.max;
-  if (m_acc_max >= m_acc.size()) {
-    m_acc.resize(m_acc_max + 1);
+  auto const si = 2 * a_ch + a_span;
+  auto const *hist = &m_hist[si * m_stride];
+  auto *lut = &m_lut[a_ch * m_stride];
+  auto const acc_max = std::min(m_span_max[si], m_stride - 1);
+  uint32_t acc_sum = 0;
+  for (uint32_t i = 0; i <= acc_max; ++i) {
+    acc_sum += hist[i];
+  }
+  if (0 == acc_sum) {
+    std::fill(lut, lut + m_stride, 0.0);
+    return;
   }
-  m_acc_sum = 0;
-  for (size_t i = 0; i <= m_acc_max; ++i) {
-    m_acc[i] = m_acc_sum;
-    m_acc_sum += span.hist[i];
+  auto const norm = 1.0 / acc_sum;
+  uint32_t acc = 0;
+  for (uint32_t i = 0; i <= acc_max; ++i) {
+    lut[i] = acc * norm;
+    acc += hist[i];
   }
+  // Anything beyond the calibrated range clamps to the last bin.
+  std::fill(lut + acc_max + 1, lut + m_stride, lut[acc_max]);
 }
 
-double CalFineTime::Get(uint32_t a_i)
+void CalFineTable::ChannelFit(uint32_t a_ch)
 {
-  if (0x3ff == a_i) {
-    // Magical Tamex fine time...
-    return 0.0;
+  if (a_ch < m_counter.size()) {
+    return;
   }
+  size_t n = a_ch + 1;
+  m_counter.resize(n);
+  m_span_i.resize(n);
+  m_span_sum.resize(2 * n);
+  m_span_min.resize(2 * n, 1);
+  m_span_max.resize(2 * n);
+  m_hist.resize(2 * n * m_stride);
+  m_lut.resize(n * m_stride);
+}
 
-  // Pick span, swap if we've reached ~10%.
-  Span *span = &m_span_vec[m_span_i];
-  if (span->sum > 1000 &&
-      span->sum > 100 * span->max) {
-    Calib();
-    m_span_i ^= 1;
-    span = &m_span_vec[m_span_i];
-    span->sum = 0;
-    span->min = 1;
-    span->max = 0;
-    // Keep vector buffer, just zero it.
-    std::fill(span->hist.begin(), span->hist.end(), 0);
-  }
+double CalFineTable::Get(uint32_t a_ch, uint32_t a_fine)
+{
+  double ft;
+  GetMany(a_ch, &a_fine, 1, &ft);
+  return ft;
+}
+
+void CalFineTable::GetMany(uint32_t a_ch, uint32_t const *a_fine, size_t
+    a_num, double *a_out)
+{
+  ChannelFit(a_ch);
 
-  // Add value to hist.
-  if (span->min > span->max) {
-    span->max = span->min = a_i;
-  } else {
-    span->min = std::min(span->min, a_i);
-    span->max = std::max(span->max, a_i);
+  int calib_span = -1;
+  for (size_t j = 0; j < a_num; ++j) {
+    auto const f = a_fine[j];
+    if (TAMEX_MAGIC == f) {
+      // Magical Tamex fine time...
+      continue;
+    }
+    if (f >= FINE_MAX) {
+      continue;
+    }
+    if (f >= m_stride) {
+      Restride(f);
+    }
+
+    // Pick span, swap if we've reached ~10%.
+    auto si = 2 * a_ch + m_span_i[a_ch];
+    if (m_span_sum[si] > 1000 &&
+        m_span_sum[si] > 100 * m_span_max[si]) {
+      calib_span = m_span_i[a_ch];
+      m_span_i[a_ch] ^= 1;
+      si = 2 * a_ch + m_span_i[a_ch];
+      m_span_sum[si] = 0;
+      m_span_min[si] = 1;
+      m_span_max[si] = 0;
+      auto it = m_hist.begin() + si * m_stride;
+      std::fill(it, it + m_stride, 0);
+    }
+
+    // Add value to hist.
+    if (m_span_min[si] > m_span_max[si]) {
+      m_span_max[si] = m_span_min[si] = f;
+    } else {
+      m_span_min[si] = std::min(m_span_min[si], f);
+      m_span_max[si] = std::max(m_span_max[si], f);
+    }
+    ++m_hist[si * m_stride + f];
+    ++m_span_sum[si];
+    auto &counter = m_counter[a_ch];
+    ++counter;
+    if (counter >= 100000) {
+      // Revert to a calib state.
+      counter = 10000;
+    }
+    if (10 == counter ||
+        100 == counter ||
+        1000 == counter ||
+        10000 == counter) {
+      calib_span = m_span_i[a_ch];
+    }
   }
-  if (a_i >= span->hist.size()) {
-    span->hist.resize(a_i + 1);
+  if (calib_span >= 0) {
+    Calib(a_ch, (unsigned)calib_span);
   }
-  ++span->hist[a_i];
-  ++span->sum;
-  ++m_counter;
-  if (m_counter >= 100000) {
-    // Revert to a calib state.
-    m_counter = 10000;
+
+  // Convert, uncalibrated channels have an all-zero table.
+  auto const *lut = &m_lut[a_ch * m_stride];
+  for (size_t j = 0; j < a_num; ++j) {
+    auto const f = a_fine[j];
+    a_out[j] = TAMEX_MAGIC == f ? 0.0 : lut[std::min(f, m_stride - 1)];
   }
+}
 
-  if (10 == m_counter ||
-      100 == m_counter ||
-      1000 == m_counter ||
-      10000 == m_counter) {
-    Calib();
+void CalFineTable::Restride(uint32_t a_fine)
+{
+  uint32_t stride = m_stride;
+  while (stride <= a_fine) {
+    stride *= 2;
+  }
+  size_t ch_num = m_counter.size();
+  std::vector<uint32_t> hist(2 * ch_num * stride);
+  for (size_t i = 0; i < 2 * ch_num; ++i) {
+    auto src = m_hist.begin() + (ptrdiff_t)(i * m_stride);
+    std::copy(src, src + m_stride, hist.begin() + (ptrdiff_t)(i * stride));
   }
+  std::vector<double> lut(ch_num * stride);
+  for (size_t i = 0; i < ch_num; ++i) {
+    auto src = m_lut.begin() + (ptrdiff_t)(i * m_stride);
+    auto dst = lut.begin() + (ptrdiff_t)(i * stride);
+    std::copy(src, src + m_stride, dst);
+    std::fill(dst + m_stride, dst + stride, src[m_stride - 1]);
+  }
+  m_hist.swap(hist);
+  m_lut.swap(lut);
+  m_stride = stride;
+}
 
-  // Convert.
-  if (m_acc.empty()) {
-    return 0.0;
+bool CalFineTable::StateLoad(std::vector<uint8_t> const &a_blob, size_t
+    *a_ofs)
+{
+  uint32_t stride;
+  std::vector<uint32_t> counter;
+  std::vector<uint8_t> span_i;
+  std::vector<uint32_t> span_sum;
+  std::vector<uint32_t> span_min;
+  std::vector<uint32_t> span_max;
+  std::vector<uint32_t> hist;
+  std::vector<double> lut;
+  if (!StateGet(a_blob, a_ofs, &stride, sizeof stride) ||
+      !StateGetVec(a_blob, a_ofs, &counter) ||
+      !StateGetVec(a_blob, a_ofs, &span_i) ||
+      !StateGetVec(a_blob, a_ofs, &span_sum) ||
+      !StateGetVec(a_blob, a_ofs, &span_min) ||
+      !StateGetVec(a_blob, a_ofs, &span_max) ||
+      !StateGetVec(a_blob, a_ofs, &hist) ||
+      !StateGetVec(a_blob, a_ofs, &lut)) {
+    return false;
   }
-  a_i = std::min(a_i, m_acc_max);
-  return (double)m_acc.at(a_i) / m_acc_sum;
+  auto n = counter.size();
+  if (stride < STRIDE_MIN || stride > FINE_MAX ||
+      0 != (stride & (stride - 1)) ||
+      span_i.size() != n ||
+      span_sum.size() != 2 * n ||
+      span_min.size() != 2 * n ||
+      span_max.size() != 2 * n ||
+      hist.size() != 2 * n * stride ||
+      lut.size() != n * stride) {
+    return false;
+  }
+  for (auto it = span_i.begin(); span_i.end() != it; ++it) {
+    if (*it > 1) {
+      return false;
+    }
+  }
+  m_stride = stride;
+  m_counter.swap(counter);
+  m_span_i.swap(span_i);
+  m_span_sum.swap(span_sum);
+  m_span_min.swap(span_min);
+  m_span_max.swap(span_max);
+  m_hist.swap(hist);
+  m_lut.swap(lut);
+  return true;
+}
+
+void CalFineTable::StateSave(std::vector<uint8_t> *a_blob) const
+{
+  StatePut(a_blob, &m_stride, sizeof m_stride);
+  StatePutVec(a_blob, m_counter);
+  StatePutVec(a_blob, m_span_i);
+  StatePutVec(a_blob, m_span_sum);
+  StatePutVec(a_blob, m_span_min);
+  StatePutVec(a_blob, m_span_max);
+  StatePutVec(a_blob, m_hist);
+  StatePutVec(a_blob, m_lut);
 }
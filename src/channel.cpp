@@ -0,0 +1,194 @@
+/*
+ * plutt, a scriptable monitor for experimental data.
+ *
+ * Copyright (C) 2025
+ * Hans Toshihide Toernqvist <hans.tornqvist@chalmers.se>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <channel.hpp>
+
+// Below this size ratio a linear walk beats galloping.
+#define GALLOP_RATIO 8
+
+uint32_t ChannelSeek(Vector<uint32_t> const &a_id, uint32_t a_from, uint32_t
+    a_target)
+{
+  auto n = (uint32_t)a_id.size();
+  if (a_from >= n) {
+    return n;
+  }
+  auto p = a_id.begin();
+  // Gallop until overshooting, then bisect the last step.
+  uint32_t lo = a_from;
+  uint32_t step = 1;
+  while (lo + step < n && p[lo + step] < a_target) {
+    lo += step;
+    step <<= 1;
+  }
+  if (p[lo] >= a_target) {
+    return lo;
+  }
+  auto hi = std::min(lo + step, n);
+  return (uint32_t)(std::lower_bound(p + lo + 1, p + hi, a_target) - p);
+}
+
+void ChannelRange(Value const &a_val, uint32_t a_first, uint32_t a_last,
+    uint32_t *a_i0, uint32_t *a_i1)
+{
+  auto const &vid = a_val.GetID();
+  *a_i0 = ChannelSeek(vid, 0, a_first);
+  if (UINT32_MAX == a_last) {
+    *a_i1 = (uint32_t)vid.size();
+  } else {
+    *a_i1 = ChannelSeek(vid, *a_i0, a_last + 1);
+  }
+}
+
+void ChannelIntersect(Value const &a_l, Value const &a_r,
+    std::vector<ChannelPair> *a_vec)
+{
+  a_vec->clear();
+  auto const &vid_l = a_l.GetID();
+  auto const &vid_r = a_r.GetID();
+  auto n_l = (uint32_t)vid_l.size();
+  auto n_r = (uint32_t)vid_r.size();
+  if (!n_l || !n_r) {
+    return;
+  }
+  ChannelPair pair;
+  if (n_l > GALLOP_RATIO * n_r || n_r > GALLOP_RATIO * n_l) {
+    // Sparse against dense, gallop through the dense side.
+    bool is_l_short = n_l < n_r;
+    auto const &vid_s = is_l_short ? vid_l : vid_r;
+    auto const &vid_d = is_l_short ? vid_r : vid_l;
+    auto n_s = is_l_short ? n_l : n_r;
+    auto n_d = is_l_short ? n_r : n_l;
+    uint32_t j = 0;
+    for (uint32_t i = 0; i < n_s && j < n_d; ++i) {
+      auto id = vid_s.begin()[i];
+      j = ChannelSeek(vid_d, j, id);
+      if (j < n_d && vid_d.begin()[j] == id) {
+        pair.l = is_l_short ? i : j;
+        pair.r = is_l_short ? j : i;
+        a_vec->push_back(pair);
+        ++j;
+      }
+    }
+    return;
+  }
+  // Similar sizes, step both sides without unpredictable branches.
+  auto p_l = vid_l.begin();
+  auto p_r = vid_r.begin();
+  uint32_t i_l = 0;
+  uint32_t i_r = 0;
+  while (i_l < n_l && i_r < n_r) {
+    auto id_l = p_l[i_l];
+    auto id_r = p_r[i_r];
+    if (id_l == id_r) {
+      pair.l = i_l;
+      pair.r = i_r;
+      a_vec->push_back(pair);
+    }
+    i_l += id_l <= id_r;
+    i_r += id_r <= id_l;
+  }
+}
+
+// Inverted so the std heap functions keep the lowest id, and then the lowest
+// source, on top.
+bool ChannelMerge::Entry::operator<(Entry const &a_e) const
+{
+  if (id != a_e.id) {
+    return id > a_e.id;
+  }
+  return src > a_e.src;
+}
+
+ChannelMerge::ChannelMerge():
+  m_src_vec(),
+  m_heap()
+{
+}
+
+void ChannelMerge::Clear()
+{
+  m_src_vec.clear();
+  m_heap.clear();
+}
+
+void ChannelMerge::Add(Value const *a_val)
+{
+  auto src = (uint32_t)m_src_vec.size();
+  m_src_vec.push_back(a_val);
+  auto const &vid = a_val->GetID();
+  if (!vid.empty()) {
+    Entry e;
+    e.id = vid.begin()[0];
+    e.src = src;
+    e.i = 0;
+    m_heap.push_back(e);
+    std::push_heap(m_heap.begin(), m_heap.end());
+  }
+}
+
+bool ChannelMerge::Next(std::vector<ChannelRun> *a_vec)
+{
+  a_vec->clear();
+  if (m_heap.empty()) {
+    return false;
+  }
+  auto id = m_heap.front().id;
+  while (!m_heap.empty() && m_heap.front().id == id) {
+    std::pop_heap(m_heap.begin(), m_heap.end());
+    auto e = m_heap.back();
+    m_heap.pop_back();
+    ChannelRun run;
+    run.src = e.src;
+    run.i0 = e.i;
+    run.i1 = e.i + 1;
+    a_vec->push_back(run);
+  }
+  if (1 == a_vec->size()) {
+    // Alone, take everything below the other sources in one go.
+    auto &run = a_vec->front();
+    auto const &vid0 = m_src_vec[run.src]->GetID();
+    if (m_heap.empty()) {
+      run.i1 = (uint32_t)vid0.size();
+    } else {
+      run.i1 = ChannelSeek(vid0, run.i1, m_heap.front().id);
+    }
+  }
+  for (auto it = a_vec->begin(); a_vec->end() != it; ++it) {
+    auto const &vid = m_src_vec[it->src]->GetID();
+    if (it->i1 < vid.size()) {
+      Entry e;
+      e.id = vid.begin()[it->i1];
+      e.src = it->src;
+      e.i = it->i1;
+      m_heap.push_back(e);
+      std::push_heap(m_heap.begin(), m_heap.end());
+    }
+  }
+  return true;
+}
@@ -0,0 +1,149 @@
+/*
+ * plutt, a scriptable monitor for experimental data.
+ *
+ * Copyright (C) 2025
+ * Hans Toshihide Toernqvist <hans.tornqvist@chalmers.se>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+#include <err.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <checkpoint.hpp>
+
+#define CHECKPOINT_MAGIC 0x4b434c50
+#define CHECKPOINT_VERSION 2
+
+Checkpoint::Checkpoint():
+  m_blob_map()
+{
+}
+
+bool Checkpoint::Get(std::string const &a_key, std::vector<uint8_t> const
+    **a_blob) const
+{
+  auto it = m_blob_map.find(a_key);
+  if (m_blob_map.end() == it) {
+    return false;
+  }
+  *a_blob = &it->second;
+  return true;
+}
+
+bool Checkpoint::Load(std::string const &a_path)
+{
+  m_blob_map.clear();
+  std::ifstream ifile(a_path, std::ios::binary);
+  if (!ifile.is_open()) {
+    return false;
+  }
+  uint32_t header[3];
+  if (!ifile.read((char *)header, sizeof header) ||
+      CHECKPOINT_MAGIC != header[0] ||
+      CHECKPOINT_VERSION != header[1]) {
+    std::cerr << a_path << ": Not a checkpoint of this version/machine.\n";
+    return false;
+  }
+  for (uint32_t i = 0; i < header[2]; ++i) {
+    uint32_t key_len;
+    uint64_t blob_len;
+    std::string key;
+    std::vector<uint8_t> blob;
+    bool ok = !!ifile.read((char *)&key_len, sizeof key_len);
+    if (ok) {
+      key.resize(key_len);
+      ok = ifile.read(&key[0], key_len) &&
+          ifile.read((char *)&blob_len, sizeof blob_len);
+    }
+    if (ok) {
+      blob.resize(blob_len);
+      ok = !!ifile.read((char *)blob.data(), (std::streamsize)blob_len);
+    }
+    if (!ok) {
+      std::cerr << a_path << ": Truncated checkpoint.\n";
+      m_blob_map.clear();
+      return false;
+    }
+    m_blob_map[key].swap(blob);
+  }
+  return true;
+}
+
+void Checkpoint::Put(std::string const &a_key, std::vector<uint8_t> const
+    &a_blob)
+{
+  m_blob_map[a_key] = a_blob;
+}
+
+bool Checkpoint::Save(std::string const &a_path) const
+{
+  auto tmp_path = a_path + ".tmp";
+  {
+    std::ofstream of(tmp_path, std::ios::binary);
+    if (!of.is_open()) {
+      warn("ofstream(%s)", tmp_path.c_str());
+      return false;
+    }
+    uint32_t header[3] = {
+      CHECKPOINT_MAGIC, CHECKPOINT_VERSION, (uint32_t)m_blob_map.size()
+    };
+    of.write((char const *)header, sizeof header);
+    for (auto it = m_blob_map.begin(); m_blob_map.end() != it; ++it) {
+      auto key_len = (uint32_t)it->first.size();
+      uint64_t blob_len = it->second.size();
+      of.write((char const *)&key_len, sizeof key_len);
+      of.write(it->first.data(), key_len);
+      of.write((char const *)&blob_len, sizeof blob_len);
+      of.write((char const *)it->second.data(), (std::streamsize)blob_len);
+    }
+    if (!of) {
+      std::cerr << tmp_path << ": Could not write checkpoint.\n";
+      return false;
+    }
+  }
+  if (0 != rename(tmp_path.c_str(), a_path.c_str())) {
+    warn("rename(%s, %s)", tmp_path.c_str(), a_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+void StatePut(std::vector<uint8_t> *a_blob, void const *a_src, size_t
+    a_bytes)
+{
+  auto p = (uint8_t const *)a_src;
+  a_blob->insert(a_blob->end(), p, p + a_bytes);
+}
+
+bool StateGet(std::vector<uint8_t> const &a_blob, size_t *a_ofs, void
+    *a_dst, size_t a_bytes)
+{
+  if (*a_ofs > a_blob.size() || a_bytes > a_blob.size() - *a_ofs) {
+    return false;
+  }
+  if (a_bytes) {
+    memcpy(a_dst, &a_blob[*a_ofs], a_bytes);
+  }
+  *a_ofs += a_bytes;
+  return true;
+}
@@ -23,6 +23,7 @@
 #include <err.h>
 
 #include <cassert>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <list>
@@ -30,9 +31,12 @@
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <cal.hpp>
+#include <checkpoint.hpp>
+#include <job_queue.hpp>
 #include <util.hpp>
 #include <visual.hpp>
 #if PLUTT_SDL2
@@ -74,6 +78,9 @@
 #include <config_parser.tab.h>
 
 #define DEFAULT_UI_RATE 20U
+#define STATE_PERIOD_MS (60 * 1000)
+// 2D clustering keeps (gap + 2) lines of 'width' labels.
+#define CLUSTER_GRID_MAX (1 << 24)
 
 extern FILE *yycpin;
 extern Config *g_config;
@@ -84,6 +91,54 @@ extern int yycplex_destroy();
 
 extern char const *yycppath;
 
+// Writes checkpoints off the event thread, a checkpoint posted before the
+// previous one was written replaces it.
+class Config::StateWriter: public Job {
+  public:
+    StateWriter(std::string const &);
+    void Post(Checkpoint *);
+    void Run();
+
+  private:
+    StateWriter(StateWriter const &);
+    StateWriter &operator=(StateWriter const &);
+
+    std::string m_path;
+    std::mutex m_mutex;
+    Checkpoint m_checkpoint;
+    bool m_is_posted;
+};
+
+Config::StateWriter::StateWriter(std::string const &a_path):
+  Job(),
+  m_path(a_path),
+  m_mutex(),
+  m_checkpoint(),
+  m_is_posted()
+{
+}
+
+void Config::StateWriter::Post(Checkpoint *a_checkpoint)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  std::swap(m_checkpoint, *a_checkpoint);
+  m_is_posted = true;
+}
+
+void Config::StateWriter::Run()
+{
+  Checkpoint checkpoint;
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_is_posted) {
+      return;
+    }
+    std::swap(checkpoint, m_checkpoint);
+    m_is_posted = false;
+  }
+  checkpoint.Save(m_path);
+}
+
 Config::Config(char const *a_path, char const *a_dot_path):
   m_path(a_path),
   m_dot_node_map(),
@@ -100,15 +155,26 @@ Config::Config(char const *a_path, char const *a_dot_path):
   m_cut_poly_list(),
   m_cut_ref_map(),
   m_fit_map(),
+  m_mult_max(),
+  m_mult_max_map(),
+  m_mult_over(),
   m_clock_match(),
+  m_state_node_vec(),
+  m_state_map(),
+  m_state_path(),
+  m_state_t(),
+  m_state_writer(),
   m_colormap(),
   m_ui_rate(DEFAULT_UI_RATE),
-  m_evid(),
+  m_evid(1),
   m_input()
 {
   // config_parser relies on this global!
   g_config = this;
 
+  m_mult_max.max = UINT32_MAX;
+  m_mult_max.skip = false;
+
 #if PLUTT_SDL2
   m_colormap = ImPlutt::ColormapGet(nullptr);
 #endif
@@ -135,6 +201,10 @@ Config::Config(char const *a_path, char const *a_dot_path):
       auto const &name = it->first;
       auto signal = new NodeSignal(*this, name);
       signal->SetLocStr(it->second->GetLocStr());
+      auto mult_it = m_mult_max_map.find(name);
+      auto const &mult_max = m_mult_max_map.end() == mult_it ?
+          m_mult_max : mult_it->second;
+      signal->MultMaxSet(mult_max.max, mult_max.skip);
       alias->SetSource(GetLocStr(), signal);
       m_signal_map.insert(std::make_pair(name, signal));
       std::cout << "Signal=" << it->first << '\n';
@@ -145,6 +215,15 @@ Config::Config(char const *a_path, char const *a_dot_path):
       DotAddLink(alias, signal);
     }
   }
+  for (auto it = m_mult_max_map.begin(); m_mult_max_map.end() != it; ++it) {
+    if (!m_signal_map.count(it->first)) {
+      std::cerr << it->second.loc << ": Multiplicity cap on '" << it->first
+          << "', which is not a signal!\n";
+      throw std::runtime_error(__func__);
+    }
+  }
+
+  StateKeysSet();
 
   // Write dot file.
   if (a_dot_path) {
@@ -211,6 +290,10 @@ Config::Config(char const *a_path, char const *a_dot_path):
 
 Config::~Config()
 {
+  if (m_state_writer) {
+    m_state_writer->Cancel();
+    delete m_state_writer;
+  }
   for (auto it = m_alias_map.begin(); m_alias_map.end() != it; ++it) {
     delete it->second;
   }
@@ -327,14 +410,21 @@ NodeValue *Config::AddBitfield(BitfieldArg *a_arg)
   return node;
 }
 
-NodeValue *Config::AddCluster(NodeValue *a_node)
+NodeValue *Config::AddCluster(NodeValue *a_node, uint32_t a_gap, uint32_t
+    a_width)
 {
+  if ((uint64_t)(a_gap + 2) * a_width > CLUSTER_GRID_MAX) {
+    std::cerr << GetLocStr() << ": Cluster (gap + 2) * width must be <= " <<
+        CLUSTER_GRID_MAX << "!\n";
+    throw std::runtime_error(__func__);
+  }
   std::ostringstream oss;
-  oss << __LINE__ << ',' << a_node;
+  oss << __LINE__ << ',' << a_node << ',' << a_gap << ',' << a_width;
   auto key = oss.str();
   auto node = NodeValueGet(key);
   if (!node) {
-    NodeValueAdd(key, node = new NodeCluster(GetLocStr(), a_node));
+    NodeValueAdd(key, node = new NodeCluster(GetLocStr(), a_node, a_gap,
+        a_width));
   }
   DotAddNode(node, "Cluster");
   DotAddLink(node, a_node);
@@ -349,10 +439,14 @@ NodeValue *Config::AddCoarseFine(NodeValue *a_coarse, NodeValue *a_fine,
   auto key = oss.str();
   auto node = NodeValueGet(key);
   if (!node) {
-    NodeValueAdd(key, node = new NodeCoarseFine(GetLocStr(), a_coarse, a_fine,
-        a_fine_range));
+    auto coarse_fine = new NodeCoarseFine(GetLocStr(), a_coarse, a_fine,
+        a_fine_range);
+    StateAdd(coarse_fine, coarse_fine);
+    NodeValueAdd(key, node = coarse_fine);
   }
-  DotAddNode(node, "CoarseFine", {"coarse", "fine"});
+  std::ostringstream oss2;
+  oss2 << "CoarseFine, fine_range=" << a_fine_range;
+  DotAddNode(node, oss2.str(), {"coarse", "fine"});
   DotAddLink(node, a_coarse, 0);
   DotAddLink(node, a_fine, 1);
   return node;
@@ -432,8 +526,8 @@ NodeValue *Config::AddFloor(NodeValue *a_value)
 
 void Config::AddHist1(char const *a_title, NodeValue *a_x, uint32_t a_xb, char
     const *a_transform, PeakFitVec const &a_fit_vec, bool a_log_y, bool
-    a_contour, double a_drop_counts_s, unsigned a_drop_counts_num, double
-    a_drop_stats_s)
+    a_contour, uint32_t a_snip_exp, double a_drop_counts_s, unsigned
+    a_drop_counts_num, double a_drop_stats_s)
 {
   double k = 1.0;
   double m = 0.0;
@@ -455,8 +549,8 @@ void Config::AddHist1(char const *a_title, NodeValue *a_x, uint32_t a_xb, char
   }
 
   auto node = new NodeHist1(GetLocStr(), a_title, a_x, a_xb,
-      LinearTransform(k, m), a_fit_vec, a_log_y, a_contour, a_drop_counts_s,
-      a_drop_counts_num, a_drop_stats_s);
+      LinearTransform(k, m), a_fit_vec, a_log_y, a_contour, a_snip_exp,
+      a_drop_counts_s, a_drop_counts_num, a_drop_stats_s);
   NodeCuttableAdd(node);
 
   std::ostringstream oss2;
@@ -757,8 +851,9 @@ NodeValue *Config::AddPedestal(NodeValue *a_value, double a_cutoff, NodeValue
   auto key = oss.str();
   auto node = NodeValueGet(key);
   if (!node) {
-    NodeValueAdd(key,
-        node = new NodePedestal(GetLocStr(), a_value, a_cutoff, a_tpat));
+    auto pedestal = new NodePedestal(GetLocStr(), a_value, a_cutoff, a_tpat);
+    StateAdd(pedestal, pedestal);
+    NodeValueAdd(key, node = pedestal);
   }
 
   std::ostringstream oss2;
@@ -993,11 +1088,67 @@ void Config::DotAddNode(Node *a_node, std::string const &a_name,
   }
 }
 
+std::string Config::DotExpr(uintptr_t a_node) const
+{
+  if (!a_node) {
+    return "-";
+  }
+  auto it = m_dot_node_map.find((Node *)a_node);
+  std::string expr = m_dot_node_map.end() == it ? "?" : it->second.name;
+  expr += '(';
+  for (unsigned i = 0;; ++i) {
+    std::ostringstream oss;
+    oss << a_node << ":f" << i;
+    auto link_it = m_dot_link_map.find(oss.str());
+    if (m_dot_link_map.end() == link_it) {
+      break;
+    }
+    if (i > 0) {
+      expr += ',';
+    }
+    expr += DotExpr(link_it->second);
+  }
+  return expr + ')';
+}
+
 void Config::HistCutAdd(CutPolygon *a_poly)
 {
   m_cut_poly_list.push_back(a_poly);
 }
 
+void Config::MultMaxSet(char const *a_name, uint32_t a_max, bool a_skip)
+{
+  MultMax mult_max;
+  mult_max.max = a_max;
+  mult_max.skip = a_skip;
+  mult_max.loc = GetLocStr();
+  if (!a_name) {
+    m_mult_max = mult_max;
+    return;
+  }
+  if (!m_mult_max_map.insert(std::make_pair(a_name, mult_max)).second) {
+    std::cerr << GetLocStr() << ": Multiplicity cap on '" << a_name <<
+        "' already set!\n";
+    throw std::runtime_error(__func__);
+  }
+}
+
+void Config::MultOver()
+{
+  m_mult_over = true;
+}
+
+void Config::MultOverPrint() const
+{
+  for (auto it = m_signal_map.begin(); m_signal_map.end() != it; ++it) {
+    auto num = it->second->MultOverGet();
+    if (num) {
+      std::cout << it->first << ": " << num <<
+          " events over the multiplicity cap.\n";
+    }
+  }
+}
+
 unsigned Config::UIRateGet() const
 {
   return m_ui_rate;
@@ -1008,6 +1159,101 @@ void Config::UIRateSet(unsigned a_ui_rate)
   m_ui_rate = std::min(a_ui_rate, DEFAULT_UI_RATE);
 }
 
+void Config::StateAdd(Node *a_node, Checkpointable *a_state)
+{
+  m_state_node_vec.push_back(std::make_pair(a_node, a_state));
+}
+
+void Config::StateCollect(Checkpoint *a_checkpoint)
+{
+  std::vector<uint8_t> blob;
+  for (auto it = m_state_map.begin(); m_state_map.end() != it; ++it) {
+    auto const &fp = it->second.fingerprint;
+    blob.clear();
+    StatePutVec(&blob, std::vector<char>(fp.begin(), fp.end()));
+    it->second.node->StateSave(&blob);
+    a_checkpoint->Put(it->first, blob);
+  }
+}
+
+void Config::StateKeysSet()
+{
+  // Keys come from the input expressions so they survive config edits,
+  // identical ones are numbered in parse order.
+  for (auto it = m_state_node_vec.begin(); m_state_node_vec.end() != it;
+      ++it) {
+    auto kind = std::string(it->second->StateKind());
+    auto const &name = m_dot_node_map[it->first].name;
+    // Swap the node label for the kind, the label goes in the fingerprint.
+    auto key = kind + DotExpr((uintptr_t)it->first).substr(name.size());
+    auto key0 = key;
+    for (unsigned i = 1; m_state_map.count(key); ++i) {
+      std::ostringstream oss;
+      oss << key0 << '#' << i;
+      key = oss.str();
+    }
+    StateEntry entry;
+    entry.node = it->second;
+    entry.fingerprint = kind + ':' + name;
+    m_state_map.insert(std::make_pair(key, entry));
+  }
+  m_state_node_vec.clear();
+}
+
+void Config::StateLoad(char const *a_path)
+{
+  m_state_path = a_path;
+  m_state_t = Time_get_ms();
+  m_state_writer = new StateWriter(m_state_path);
+  Checkpoint checkpoint;
+  if (!checkpoint.Load(m_state_path)) {
+    std::cout << m_state_path << ": No state loaded.\n";
+    return;
+  }
+  unsigned num = 0;
+  for (auto it = m_state_map.begin(); m_state_map.end() != it; ++it) {
+    std::vector<uint8_t> const *blob;
+    if (!checkpoint.Get(it->first, &blob)) {
+      continue;
+    }
+    auto const &fp = it->second.fingerprint;
+    size_t ofs = 0;
+    std::vector<char> fp_blob;
+    if (!StateGetVec(*blob, &ofs, &fp_blob)) {
+      std::cerr << m_state_path << ": " << it->first <<
+          ": Inconsistent state, ignored.\n";
+      continue;
+    }
+    if (std::string(fp_blob.begin(), fp_blob.end()) != fp) {
+      std::cerr << m_state_path << ": " << it->first <<
+          ": Saved for a different node, ignored.\n";
+      continue;
+    }
+    std::vector<uint8_t> node_blob(blob->begin() + (ptrdiff_t)ofs,
+        blob->end());
+    if (it->second.node->StateLoad(node_blob)) {
+      ++num;
+    } else {
+      std::cerr << m_state_path << ": " << it->first <<
+          ": Inconsistent state, ignored.\n";
+    }
+  }
+  std::cout << m_state_path << ": Loaded " << num << '/' <<
+      m_state_map.size() << " node states.\n";
+}
+
+void Config::StateSave()
+{
+  if (m_state_path.empty() || m_state_map.empty()) {
+    return;
+  }
+  // Final save, wait for any periodic one so they don't race.
+  m_state_writer->Cancel();
+  Checkpoint checkpoint;
+  StateCollect(&checkpoint);
+  checkpoint.Save(m_state_path);
+}
+
 void Config::CutListBind(std::string const &a_dst_title)
 {
   // Bind temp list to histogram via its name.
@@ -1103,13 +1349,29 @@ void Config::DoEvent(Input *a_input)
     auto node = it->second;
     node->CutReset();
   }
+  m_mult_over = false;
   for (auto it = m_cuttable_map.begin(); m_cuttable_map.end() != it; ++it) {
     auto node = it->second;
     node->Process(m_evid);
   }
+  if (m_mult_over) {
+    Pathological_add();
+  }
 
   m_input = nullptr;
   ++m_evid;
+
+  if (!m_state_path.empty()) {
+    auto t = Time_get_ms();
+    if (t > m_state_t + STATE_PERIOD_MS && !m_state_map.empty()) {
+      // Serialize here, but leave the file writing to a job.
+      Checkpoint checkpoint;
+      StateCollect(&checkpoint);
+      m_state_writer->Post(&checkpoint);
+      m_state_writer->Queue();
+      m_state_t = t;
+    }
+  }
 }
 
 std::string Config::GetLocStr() const
@@ -113,6 +113,10 @@ static struct {
 	double r_min;
 	double r_max;
 } g_annular;
+static struct {
+	uint32_t gap;
+	uint32_t width;
+} g_cluster;
 static NodeValue *g_pedestal_tpat;
 static uint32_t g_binsx;
 static uint32_t g_binsy;
@@ -127,6 +131,7 @@ static struct {
 static double g_drop_stats = -1.0;
 static bool g_permutate;
 static double g_single = -1.0;
+static uint32_t g_snip;
 
 static void ResetDrawArgs() {
 	g_peak_fit_vec.clear();
@@ -144,8 +149,11 @@ static void ResetDrawArgs() {
 	g_drop_stats = -1.0;
 	g_permutate = false;
 	g_single = -1.0;
+	g_snip = 0;
 }
 
+#define SNIP_EXP_DEFAULT 6
+
 #define CTDC_BITS 12
 #define TAMEX3_BITS 11
 #define VFTX2_BITS 11
@@ -200,6 +208,7 @@ static void ResetDrawArgs() {
 %token TK_FILLED
 %token TK_FILTER_RANGE
 %token TK_FIT
+%token TK_GAP
 %token TK_HIST
 %token TK_HIST2D
 %token TK_LENGTH
@@ -213,6 +222,7 @@ static void ResetDrawArgs() {
 %token TK_MEAN_GEOM
 %token TK_MERGE
 %token TK_MIN
+%token TK_MULT_MAX
 %token TK_PAGE
 %token TK_PEDESTAL
 %token TK_PERMUTATE
@@ -222,6 +232,8 @@ static void ResetDrawArgs() {
 %token TK_SIGNAL
 %token TK_SIN
 %token TK_SINGLE
+%token TK_SKIP
+%token TK_SNIP
 %token TK_SQRT
 %token TK_SUB_MOD
 %token TK_TAMEX3
@@ -234,6 +246,7 @@ static void ResetDrawArgs() {
 %token TK_FLOOR
 %token TK_UI_RATE
 %token TK_VFTX2
+%token TK_WIDTH
 %token TK_ZERO_SUPPRESS
 
 %token TK_OP_EQ
@@ -265,6 +278,8 @@ static void ResetDrawArgs() {
 %type <merge> merge_arg
 %type <merge> merge_args
 %type <value> mexpr
+%type <u32> mult_max_num
+%type <u32> mult_max_skip
 %type <dbl> clock_range
 %type <value> select_index
 %type <value> signal
@@ -299,6 +314,7 @@ stmt
 	| hist
 	| match_index
 	| match_value
+	| mult_max
 	| page
 	| pedestal
 	| ui_rate
@@ -375,6 +391,31 @@ cut
 		g_cut_poly = nullptr;
 	}
 
+mult_max_num
+	: const {
+		LOC_SAVE(@1);
+		auto max = $1.GetI64();
+		if (max < 1 || max > UINT32_MAX) {
+			std::cerr << g_config->GetLocStr() <<
+			    ": Multiplicity cap must be in [1,2^32)!\n";
+			throw std::runtime_error(__func__);
+		}
+		$$ = (uint32_t)max;
+	}
+mult_max_skip
+	: { $$ = 0; }
+	| ',' TK_SKIP { $$ = 1; }
+mult_max
+	: TK_MULT_MAX '(' mult_max_num mult_max_skip ')' {
+		LOC_SAVE(@1);
+		g_config->MultMaxSet(nullptr, $3, 0 != $4);
+	}
+	| TK_MULT_MAX '(' TK_STRING ',' mult_max_num mult_max_skip ')' {
+		LOC_SAVE(@1);
+		g_config->MultMaxSet($3, $5, 0 != $6);
+		free($3);
+	}
+
 page
 	: TK_PAGE '(' TK_STRING ')' {
 		g_gui.AddPage($3);
@@ -694,21 +735,55 @@ bitfield
 		LOC_SAVE(@1);
 		$$ = g_config->AddBitfield($3);
 	}
+cluster_opts
+	:
+	| cluster_opt_list
+cluster_opt_list
+	: cluster_opt
+	| cluster_opt_list cluster_opt
+cluster_opt: ',' cluster_arg
+cluster_arg
+	: TK_GAP '=' const {
+		LOC_SAVE(@1);
+		auto gap = $3.GetI64();
+		if (gap < 0 || gap > 1000) {
+			std::cerr << g_config->GetLocStr() <<
+			    ": Cluster gap must be in [0,1000]!\n";
+			throw std::runtime_error(__func__);
+		}
+		g_cluster.gap = (uint32_t)gap;
+	}
+	| TK_WIDTH '=' const {
+		LOC_SAVE(@1);
+		auto width = $3.GetI64();
+		if (width < 1 || width > 1000000) {
+			std::cerr << g_config->GetLocStr() <<
+			    ": Cluster width must be in [1,1000000]!\n";
+			throw std::runtime_error(__func__);
+		}
+		g_cluster.width = (uint32_t)width;
+	}
 cluster
-	: TK_IDENT '=' TK_CLUSTER '(' value ')' {
+	: TK_IDENT '=' TK_CLUSTER '(' value cluster_opts ')' {
 		LOC_SAVE(@3);
-		auto node = g_config->AddCluster($5);
+		auto node = g_config->AddCluster($5, g_cluster.gap,
+		    g_cluster.width);
 		LOC_SAVE(@1);
 		g_config->AddAlias($1, node, 0);
+		g_cluster.gap = 0;
+		g_cluster.width = 0;
 		free($1);
 	}
-	| TK_IDENT ',' TK_IDENT '=' TK_CLUSTER '(' value ')' {
+	| TK_IDENT ',' TK_IDENT '=' TK_CLUSTER '(' value cluster_opts ')' {
 		LOC_SAVE(@5);
-		auto node = g_config->AddCluster($7);
+		auto node = g_config->AddCluster($7, g_cluster.gap,
+		    g_cluster.width);
 		LOC_SAVE(@1);
 		g_config->AddAlias($1, node, 0);
 		LOC_SAVE(@3);
 		g_config->AddAlias($3, node, 1);
+		g_cluster.gap = 0;
+		g_cluster.width = 0;
 		free($1);
 		free($3);
 	}
@@ -728,12 +803,13 @@ drop_counts
 	| TK_DROP_COUNTS '(' const unit_time ',' const ')' {
 		LOC_SAVE(@1);
 		g_drop_counts.time = $3.GetDouble() * $4;
-		g_drop_counts.slice_num = $6.GetI64();
-		if (g_drop_counts.slice_num < 1) {
+		auto slice_num = $6.GetI64();
+		if (slice_num < 0) {
 			std::cerr << g_config->GetLocStr() <<
-			    ": Must have >= 1 drop-slice!\n";
+			    ": Must have >= 0 drop-slices!\n";
 			throw std::runtime_error(__func__);
 		}
+		g_drop_counts.slice_num = (unsigned)slice_num;
 		if (g_drop_counts.slice_num > 5) {
 			std::cerr << g_config->GetLocStr() <<
 			    ": Must have <= 5 drop-slices!\n";
@@ -759,6 +835,21 @@ single
 		LOC_SAVE(@1);
 		g_single = $3.GetDouble() * $4;
 	}
+snip
+	: TK_SNIP {
+		LOC_SAVE(@1);
+		g_snip = SNIP_EXP_DEFAULT;
+	}
+	| TK_SNIP '=' const {
+		LOC_SAVE(@1);
+		auto snip_exp = $3.GetI64();
+		if (snip_exp < 1 || snip_exp > 16) {
+			std::cerr << g_config->GetLocStr() <<
+			    ": SNIP iterations must be in [1,16]!\n";
+			throw std::runtime_error(__func__);
+		}
+		g_snip = (uint32_t)snip_exp;
+	}
 
 hist_opts
 	:
@@ -788,6 +879,7 @@ hist_arg
 	| hist_cut
 	| drop_counts
 	| drop_stats
+	| snip
 hist2d_opts
 	:
 	| hist2d_opt_list
@@ -822,8 +914,8 @@ hist
 	: TK_HIST '(' TK_STRING ',' value hist_opts ')' {
 		LOC_SAVE(@1);
 		g_config->AddHist1($3, $5, g_binsx, g_transformx,
-		    g_peak_fit_vec, g_logy, g_contour, g_drop_counts.time,
-		    g_drop_counts.slice_num, g_drop_stats);
+		    g_peak_fit_vec, g_logy, g_contour, g_snip,
+		    g_drop_counts.time, g_drop_counts.slice_num, g_drop_stats);
 		ResetDrawArgs();
 		free($3);
 	}
@@ -20,6 +20,8 @@
  * MA  02110-1301  USA
  */
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <fstream>
 #include <iostream>
@@ -29,6 +31,10 @@
 #include <node.hpp>
 #include <cut.hpp>
 
+#define GRID_N 64
+// Edge cells are found by clipping edges to slightly fattened rows.
+#define GRID_ROW_PAD 0.01
+
 NodeCutValue::NodeCutValue():
   x(),
   y()
@@ -44,7 +50,15 @@ CutPolygon::Point::Point(double a_x, double a_y):
 CutPolygon::CutPolygon(char const *a_str, bool a_is_path):
   m_title(),
   m_dim(),
-  m_point_vec()
+  m_point_vec(),
+  m_is_compiled(),
+  m_min_x(),
+  m_min_y(),
+  m_max_x(),
+  m_max_y(),
+  m_scale_x(),
+  m_scale_y(),
+  m_grid()
 {
   if (a_is_path) {
     // No inline points, expect path.
@@ -102,6 +116,7 @@ void CutPolygon::AddPoint(double a_x, double a_y)
   }
   Point p(a_x, a_y);
   m_point_vec.push_back(p);
+  m_is_compiled = false;
 }
 
 std::string const &CutPolygon::GetTitle() const
@@ -124,7 +139,7 @@ bool CutPolygon::Test(double a_x) const
   return m_point_vec[0].x <= a_x && a_x < m_point_vec[1].x;
 }
 
-bool CutPolygon::Test(double a_x, double a_y) const
+void CutPolygon::Compile() const
 {
   if (2 != m_dim) {
     std::cerr << m_title <<
@@ -136,6 +151,104 @@ bool CutPolygon::Test(double a_x, double a_y) const
         ": CutPolygon 2d Test has " << m_point_vec.size() << "<3 points.\n";
     throw std::runtime_error(__func__);
   }
+  m_min_x = m_max_x = m_point_vec[0].x;
+  m_min_y = m_max_y = m_point_vec[0].y;
+  for (auto it = m_point_vec.begin(); m_point_vec.end() != it; ++it) {
+    m_min_x = std::min(m_min_x, it->x);
+    m_max_x = std::max(m_max_x, it->x);
+    m_min_y = std::min(m_min_y, it->y);
+    m_max_y = std::max(m_max_y, it->y);
+  }
+  m_is_compiled = true;
+  m_grid.clear();
+  if (!(m_max_x > m_min_x) || !(m_max_y > m_min_y)) {
+    // Degenerate, every test is exact.
+    return;
+  }
+  m_scale_x = GRID_N / (m_max_x - m_min_x);
+  m_scale_y = GRID_N / (m_max_y - m_min_y);
+  m_grid.resize(GRID_N * GRID_N, CELL_OUT);
+
+  // Mark every cell an edge passes through, per row the edge is clipped to
+  // the row and the x-range is padded by a cell for rounding.
+  auto const h = 1 / m_scale_y;
+  auto it2 = m_point_vec.begin();
+  auto it1 = it2++;
+  for (; m_point_vec.end() != it1; ++it1, ++it2) {
+    if (m_point_vec.end() == it2) {
+      it2 = m_point_vec.begin();
+    }
+    auto y_lo = std::min(it1->y, it2->y);
+    auto y_hi = std::max(it1->y, it2->y);
+    auto row0 = std::max((int)((y_lo - m_min_y) * m_scale_y) - 1, 0);
+    auto row1 = std::min((int)((y_hi - m_min_y) * m_scale_y) + 1,
+        GRID_N - 1);
+    for (int row = row0; row <= row1; ++row) {
+      auto band_lo = std::max(m_min_y + (row - GRID_ROW_PAD) * h, y_lo);
+      auto band_hi = std::min(m_min_y + (row + 1 + GRID_ROW_PAD) * h, y_hi);
+      if (band_lo > band_hi) {
+        continue;
+      }
+      double x_lo, x_hi;
+      if (it1->y == it2->y) {
+        x_lo = std::min(it1->x, it2->x);
+        x_hi = std::max(it1->x, it2->x);
+      } else {
+        auto k = (it2->x - it1->x) / (it2->y - it1->y);
+        auto xa = it1->x + (band_lo - it1->y) * k;
+        auto xb = it1->x + (band_hi - it1->y) * k;
+        x_lo = std::min(xa, xb);
+        x_hi = std::max(xa, xb);
+      }
+      auto col0 = std::max((int)((x_lo - m_min_x) * m_scale_x) - 1, 0);
+      auto col1 = std::min((int)((x_hi - m_min_x) * m_scale_x) + 1,
+          GRID_N - 1);
+      for (int col = col0; col <= col1; ++col) {
+        m_grid[(size_t)(row * GRID_N + col)] = CELL_EDGE;
+      }
+    }
+  }
+
+  // No edge crosses the remaining cells, so their centers tell all.
+  for (int row = 0; row < GRID_N; ++row) {
+    auto y = m_min_y + (row + 0.5) * h;
+    for (int col = 0; col < GRID_N; ++col) {
+      auto &cell = m_grid[(size_t)(row * GRID_N + col)];
+      if (CELL_EDGE != cell) {
+        auto x = m_min_x + (col + 0.5) / m_scale_x;
+        cell = TestExact(x, y) ? CELL_IN : CELL_OUT;
+      }
+    }
+  }
+}
+
+bool CutPolygon::Test(double a_x, double a_y) const
+{
+  if (!m_is_compiled) {
+    Compile();
+  }
+  // Also rejects NaN.
+  if (!(a_x >= m_min_x && a_x <= m_max_x &&
+        a_y >= m_min_y && a_y <= m_max_y)) {
+    return false;
+  }
+  if (m_grid.empty()) {
+    return TestExact(a_x, a_y);
+  }
+  auto col = std::min((int)((a_x - m_min_x) * m_scale_x), GRID_N - 1);
+  auto row = std::min((int)((a_y - m_min_y) * m_scale_y), GRID_N - 1);
+  switch (m_grid[(size_t)(row * GRID_N + col)]) {
+    case CELL_OUT:
+      return false;
+    case CELL_IN:
+      return true;
+    default:
+      return TestExact(a_x, a_y);
+  }
+}
+
+bool CutPolygon::TestExact(double a_x, double a_y) const
+{
   // This is so much more work than the 1D case...
   // - Create a x+ ray from the point to test.
   // - The ray points in (+1,0) so the winding = cross product is trivial.
@@ -219,20 +332,21 @@ void CutConsumerList::Process(uint64_t a_evid)
   }
 }
 
-CutProducerList::EntryData::EntryData(CutPolyMap::iterator a_it):
-  cut_poly_it(a_it),
+CutProducerList::EntryData::EntryData(uint32_t a_poly_i):
+  poly_i(a_poly_i),
   value()
 {
 }
 
-CutProducerList::EntryEvent::EntryEvent(CutPolyMap::iterator a_it):
-  cut_poly_it(a_it),
+CutProducerList::EntryEvent::EntryEvent(uint32_t a_poly_i):
+  poly_i(a_poly_i),
   is_ok()
 {
 }
 
 CutProducerList::CutProducerList():
-  m_cut_poly_map(),
+  m_poly_vec(),
+  m_mask(),
   m_cut_data_vec(),
   m_cut_event_vec()
 {
@@ -243,26 +357,44 @@ CutProducerList::~CutProducerList()
   for (auto it = m_cut_data_vec.begin(); m_cut_data_vec.end() != it; ++it) {
     delete *it;
   }
+  for (auto it = m_cut_event_vec.begin(); m_cut_event_vec.end() != it; ++it) {
+    delete *it;
+  }
 }
 
 NodeCutValue *CutProducerList::AddData(CutPolygon const *a_poly)
 {
-  auto it = AddCutPolygon(a_poly);
-  m_cut_data_vec.push_back(new EntryData(it));
+  auto poly_i = AddCutPolygon(a_poly);
+  m_cut_data_vec.push_back(new EntryData(poly_i));
   return &m_cut_data_vec.back()->value;
 }
 
 bool *CutProducerList::AddEvent(CutPolygon const *a_poly)
 {
-  auto it = AddCutPolygon(a_poly);
-  m_cut_event_vec.push_back(EntryEvent(it));
-  return &m_cut_event_vec.back().is_ok;
+  auto poly_i = AddCutPolygon(a_poly);
+  m_cut_event_vec.push_back(new EntryEvent(poly_i));
+  return &m_cut_event_vec.back()->is_ok;
+}
+
+uint32_t CutProducerList::AddCutPolygon(CutPolygon const *a_poly)
+{
+  auto it = std::find(m_poly_vec.begin(), m_poly_vec.end(), a_poly);
+  if (m_poly_vec.end() != it) {
+    return (uint32_t)(it - m_poly_vec.begin());
+  }
+  m_poly_vec.push_back(a_poly);
+  m_mask.resize((m_poly_vec.size() + 63) / 64);
+  return (uint32_t)m_poly_vec.size() - 1;
 }
 
-CutProducerList::CutPolyMap::iterator
-CutProducerList::AddCutPolygon(CutPolygon const *a_poly)
+bool CutProducerList::IsEmpty() const
 {
-  return m_cut_poly_map.insert(std::make_pair(a_poly, false)).first;
+  return m_poly_vec.empty();
+}
+
+bool CutProducerList::MaskTest(uint32_t a_poly_i) const
+{
+  return 0 != (1 & (m_mask[a_poly_i / 64] >> (a_poly_i % 64)));
 }
 
 void CutProducerList::Reset()
@@ -273,21 +405,25 @@ void CutProducerList::Reset()
     entry->value.y.Clear();
   }
   for (auto it = m_cut_event_vec.begin(); m_cut_event_vec.end() != it; ++it) {
-    it->is_ok = false;
+    (*it)->is_ok = false;
   }
 }
 
 void CutProducerList::Test(Input::Type a_type, Input::Scalar const &a_x)
 {
+  if (m_poly_vec.empty()) {
+    return;
+  }
   auto x = a_x.GetDouble(a_type);
   // Test polys.
-  for (auto it = m_cut_poly_map.begin(); m_cut_poly_map.end() != it; ++it) {
-    it->second = it->first->Test(x);
+  std::fill(m_mask.begin(), m_mask.end(), 0);
+  for (uint32_t i = 0; i < m_poly_vec.size(); ++i) {
+    m_mask[i / 64] |= (uint64_t)m_poly_vec[i]->Test(x) << (i % 64);
   }
   // Save hits inside cut.
   for (auto it = m_cut_data_vec.begin(); m_cut_data_vec.end() != it; ++it) {
     auto entry = *it;
-    if (entry->cut_poly_it->second) {
+    if (MaskTest(entry->poly_i)) {
       // TODO: Channel?
       entry->value.x.SetType(a_type);
       entry->value.x.Push(0, a_x);
@@ -295,23 +431,27 @@ void CutProducerList::Test(Input::Type a_type, Input::Scalar const &a_x)
   }
   // Accumulate event cuts.
   for (auto it = m_cut_event_vec.begin(); m_cut_event_vec.end() != it; ++it) {
-    it->is_ok |= it->cut_poly_it->second;
+    (*it)->is_ok |= MaskTest((*it)->poly_i);
   }
 }
 
 void CutProducerList::Test(Input::Type a_x_type, Input::Scalar const &a_x,
     Input::Type a_y_type, Input::Scalar const &a_y)
 {
+  if (m_poly_vec.empty()) {
+    return;
+  }
   auto x = a_x.GetDouble(a_x_type);
   auto y = a_y.GetDouble(a_y_type);
   // Test polys.
-  for (auto it = m_cut_poly_map.begin(); m_cut_poly_map.end() != it; ++it) {
-    it->second = it->first->Test(x, y);
+  std::fill(m_mask.begin(), m_mask.end(), 0);
+  for (uint32_t i = 0; i < m_poly_vec.size(); ++i) {
+    m_mask[i / 64] |= (uint64_t)m_poly_vec[i]->Test(x, y) << (i % 64);
   }
   // Pass through data cuts.
   for (auto it = m_cut_data_vec.begin(); m_cut_data_vec.end() != it; ++it) {
     auto entry = *it;
-    if (entry->cut_poly_it->second) {
+    if (MaskTest(entry->poly_i)) {
       // TODO: Channel?
       entry->value.x.SetType(a_x_type);
       entry->value.x.Push(0, a_x);
@@ -321,6 +461,6 @@ void CutProducerList::Test(Input::Type a_x_type, Input::Scalar const &a_x,
   }
   // Accumulate event cuts.
   for (auto it = m_cut_event_vec.begin(); m_cut_event_vec.end() != it; ++it) {
-    it->is_ok |= it->cut_poly_it->second;
+    (*it)->is_ok |= MaskTest((*it)->poly_i);
   }
 }
@@ -20,27 +20,39 @@
  * MA  02110-1301  USA
  */
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <vector>
 #include <fit.hpp>
 
-#if PLUTT_NLOPT
+#define LM_ITN_MAX 200
+#define LM_LAMBDA_INIT 1e-3
+#define LM_LAMBDA_MAX 1e10
+#define LM_TOL_REL 1e-8
 
-# include <nlopt.h>
+/*
+ * Built with PLUTT_FIT_BENCH only for bench/fit_bench.cpp, prints LM vs nlopt
+ * (when available) results for every fit, started from the same guess:
+ *  solver  y          itn  time
+ */
+#if PLUTT_FIT_BENCH
+# include <ctime>
 # include <iostream>
+#endif
+#if PLUTT_FIT_BENCH && PLUTT_NLOPT
+# include <nlopt.h>
+#endif
 
-# define BENCHMARK 0
+FitParams::FitParams():
+  is_set(),
+  x()
+{
+}
 
 namespace {
-  struct Region {
-    std::vector<uint32_t> const *vec;
-    uint32_t left;
-    uint32_t right;
-    unsigned itn;
-  };
-
   enum {
     OFS = 0,
     EXP_GAUSS_PHASE = 1,
@@ -53,14 +65,40 @@ namespace {
     GAUSS_WIDTH
   };
 
-  double ExpGauss(unsigned a_n, double const *a_x, double *a_grad, void
-      *a_data)
+  /*
+   * Fit region as contiguous doubles, with room for residuals and the
+   * Jacobian stored column by column, so the model loops run straight over
+   * the bins.
+   */
+  struct Region {
+    Region(std::vector<uint32_t> const &a_hist, uint32_t a_left, uint32_t
+        a_right, unsigned a_n):
+      n((size_t)(a_right - a_left + 1)),
+      t(n),
+      v(n),
+      res(n),
+      jac(a_n * n)
+    {
+      for (size_t i = 0; i < n; ++i) {
+        t[i] = a_left + (double)i;
+        v[i] = a_hist[a_left + i];
+      }
+    }
+    size_t n;
+    std::vector<double> t;
+    std::vector<double> v;
+    std::vector<double> res;
+    std::vector<double> jac;
+  };
+
+  // Fills residuals (and Jacobian if asked) and returns the sum of squares.
+  typedef double (*ModelFunc)(double const *, Region *, bool);
+  typedef bool (*ValidFunc)(double const *);
+
+  double ExpGauss(double const *a_x, Region *a_r, bool a_do_jac)
   {
-    auto r = (Region *)a_data;
     /*
      * f(t) = x1 + exp[(t-x2) / x3] + x4 exp[-(t-x5)^2 / x6]
-     * err = sum [f(i) - v_i]^2
-     * derr/dx = 2 sum [f(i) - v_i]df(i)/dx
      * df(t)/dx1 = 1
      * df(t)/dx2 = -1/x3 exp[(t-x2) / x3]
      * df(t)/dx3 = -(t-x2)/x3^2 exp[(t-x2) / x3]
@@ -74,45 +112,43 @@ namespace {
     auto x4 = a_x[EXP_GAUSS_AMP];
     auto x5 = a_x[EXP_GAUSS_MEAN];
     auto x6 = a_x[EXP_GAUSS_WIDTH];
+    auto inv_x3 = 1 / x3;
+    auto inv_x6 = 1 / x6;
+    auto n = a_r->n;
+    auto t = a_r->t.data();
+    auto v = a_r->v.data();
+    auto res = a_r->res.data();
+    auto j = a_r->jac.data();
     double sum = 0.0;
-    if (a_grad) {
-      a_grad[OFS            ] = 0.0;
-      a_grad[EXP_GAUSS_PHASE] = 0.0;
-      a_grad[EXP_GAUSS_TAU  ] = 0.0;
-      a_grad[EXP_GAUSS_AMP  ] = 0.0;
-      a_grad[EXP_GAUSS_MEAN ] = 0.0;
-      a_grad[EXP_GAUSS_WIDTH] = 0.0;
-    }
-    for (uint32_t i = r->left; i <= r->right; ++i) {
-      auto v_i = r->vec->at(i);
-      auto dx1 = i - x2;
-      double e1 = exp(dx1 / x3);
-      auto dx2 = i - x5;
-      double e2 = exp(-dx2*dx2 / x6);
-      auto f_i = x1 + e1 + x4 * e2;
-      auto dv = f_i - v_i;
+    for (size_t i = 0; i < n; ++i) {
+      auto dx1 = t[i] - x2;
+      double e1 = exp(dx1 * inv_x3);
+      auto dx2 = t[i] - x5;
+      double e2 = exp(-dx2*dx2 * inv_x6);
+      auto dv = x1 + e1 + x4 * e2 - v[i];
+      res[i] = dv;
       sum += dv * dv;
-      if (a_grad) {
-        dv *= 2;
-        a_grad[OFS            ] += dv;
-        a_grad[EXP_GAUSS_PHASE] += dv * -1/x3 * e1;
-        a_grad[EXP_GAUSS_TAU  ] += dv * -dx1 / (x3*x3) * e1;
-        a_grad[EXP_GAUSS_AMP  ] += dv * e2;
-        a_grad[EXP_GAUSS_MEAN ] += dv * x4 * e2 * 2 * dx2 / x6;
-        a_grad[EXP_GAUSS_WIDTH] += dv * x4 * e2 * dx2*dx2 / (x6*x6);
+      if (a_do_jac) {
+        j[OFS             * n + i] = 1.0;
+        j[EXP_GAUSS_PHASE * n + i] = -inv_x3 * e1;
+        j[EXP_GAUSS_TAU   * n + i] = -dx1 * inv_x3 * inv_x3 * e1;
+        j[EXP_GAUSS_AMP   * n + i] = e2;
+        j[EXP_GAUSS_MEAN  * n + i] = x4 * e2 * 2 * dx2 * inv_x6;
+        j[EXP_GAUSS_WIDTH * n + i] = x4 * e2 * dx2*dx2 * inv_x6 * inv_x6;
       }
     }
-    ++r->itn;
     return sum;
   }
 
-  double Gauss(unsigned a_n, double const *a_x, double *a_grad, void *a_data)
+  bool ExpGaussValid(double const *a_x)
+  {
+    return 0.0 != a_x[EXP_GAUSS_TAU] && a_x[EXP_GAUSS_WIDTH] > 0.0;
+  }
+
+  double Gauss(double const *a_x, Region *a_r, bool a_do_jac)
   {
-    auto r = (Region *)a_data;
     /*
      * f(t) = x1 + x2 exp[-(t-x3)^2 / x4]
-     * err = sum [f(i) - v_i]^2
-     * derr/dx = 2 sum [f(i) - v_i]df(i)/dx
      * df(t)/dx1 = 1
      * df(t)/dx2 = exp[-(t-x3)^2 / x4]
      * df(t)/dx3 = 2 x2 (t-x3) / x4 exp[-(t-x3)^2 / x4]
@@ -122,58 +158,317 @@ namespace {
     auto x2 = a_x[GAUSS_AMP];
     auto x3 = a_x[GAUSS_MEAN];
     auto x4 = a_x[GAUSS_WIDTH];
+    auto inv_x4 = 1 / x4;
+    auto n = a_r->n;
+    auto t = a_r->t.data();
+    auto v = a_r->v.data();
+    auto res = a_r->res.data();
+    auto j = a_r->jac.data();
     double sum = 0.0;
-    if (a_grad) {
-      a_grad[OFS        ] = 0.0;
-      a_grad[GAUSS_AMP  ] = 0.0;
-      a_grad[GAUSS_MEAN ] = 0.0;
-      a_grad[GAUSS_WIDTH] = 0.0;
-    }
-    for (uint32_t i = r->left; i <= r->right; ++i) {
-      auto v_i = r->vec->at(i);
-      auto dx = i - x3;
-      double e = exp(-dx*dx / x4);
-      auto f_i = x1 + x2 * e;
-      auto dv = f_i - v_i;
+    for (size_t i = 0; i < n; ++i) {
+      auto dx = t[i] - x3;
+      double e = exp(-dx*dx * inv_x4);
+      auto dv = x1 + x2 * e - v[i];
+      res[i] = dv;
       sum += dv * dv;
-      if (a_grad) {
-        dv *= 2;
-        a_grad[OFS        ] += dv;
-        a_grad[GAUSS_AMP  ] += dv * e;
-        a_grad[GAUSS_MEAN ] += dv * x2 * e * 2 * dx / x4;
-        a_grad[GAUSS_WIDTH] += dv * x2 * e * dx*dx / (x4*x4);
+      if (a_do_jac) {
+        j[OFS         * n + i] = 1.0;
+        j[GAUSS_AMP   * n + i] = e;
+        j[GAUSS_MEAN  * n + i] = x2 * e * 2 * dx * inv_x4;
+        j[GAUSS_WIDTH * n + i] = x2 * e * dx*dx * inv_x4 * inv_x4;
       }
     }
-    ++r->itn;
     return sum;
   }
 
+  bool GaussValid(double const *a_x)
+  {
+    return a_x[GAUSS_WIDTH] > 0.0;
+  }
+
+  // Solves a_n x a_n system a_a * x = a_b in place, x ends up in a_b.
+  bool Solve(double *a_a, double *a_b, unsigned a_n)
+  {
+    for (unsigned c = 0; c < a_n; ++c) {
+      auto p = c;
+      for (unsigned r = c + 1; r < a_n; ++r) {
+        if (std::abs(a_a[r * a_n + c]) > std::abs(a_a[p * a_n + c])) {
+          p = r;
+        }
+      }
+      if (0.0 == a_a[p * a_n + c]) {
+        return false;
+      }
+      if (p != c) {
+        for (unsigned k = 0; k < a_n; ++k) {
+          std::swap(a_a[p * a_n + k], a_a[c * a_n + k]);
+        }
+        std::swap(a_b[p], a_b[c]);
+      }
+      for (unsigned r = c + 1; r < a_n; ++r) {
+        auto f = a_a[r * a_n + c] / a_a[c * a_n + c];
+        for (unsigned k = c; k < a_n; ++k) {
+          a_a[r * a_n + k] -= f * a_a[c * a_n + k];
+        }
+        a_b[r] -= f * a_b[c];
+      }
+    }
+    for (unsigned c = a_n; c-- > 0;) {
+      auto s = a_b[c];
+      for (unsigned k = c + 1; k < a_n; ++k) {
+        s -= a_a[c * a_n + k] * a_b[k];
+      }
+      a_b[c] = s / a_a[c * a_n + c];
+    }
+    return true;
+  }
+
+  /*
+   * Levenberg-Marquardt with Marquardt diagonal scaling, a_n <= 6 params.
+   * Returns the number of model evaluations, a_chi2 gets the final sum of
+   * squares.
+   */
+  unsigned Lm(Region *a_r, ModelFunc a_model, ValidFunc a_valid, unsigned
+      a_n, double *a_x, double *a_chi2)
+  {
+    auto n = a_r->n;
+    auto chi2 = a_model(a_x, a_r, true);
+    unsigned itn = 1;
+    auto lambda = LM_LAMBDA_INIT;
+    double jtj[6 * 6];
+    double jtr[6];
+    bool do_build = true;
+    while (itn < LM_ITN_MAX && std::isfinite(chi2)) {
+      if (do_build) {
+        auto j = a_r->jac.data();
+        auto res = a_r->res.data();
+        for (unsigned p = 0; p < a_n; ++p) {
+          auto jp = j + p * n;
+          for (unsigned q = 0; q <= p; ++q) {
+            auto jq = j + q * n;
+            double s = 0.0;
+            for (size_t i = 0; i < n; ++i) {
+              s += jp[i] * jq[i];
+            }
+            jtj[p * a_n + q] = jtj[q * a_n + p] = s;
+          }
+          double s = 0.0;
+          for (size_t i = 0; i < n; ++i) {
+            s += jp[i] * res[i];
+          }
+          jtr[p] = -s;
+        }
+        do_build = false;
+      }
+      double a[6 * 6];
+      double dx[6];
+      memcpy(a, jtj, sizeof a);
+      memcpy(dx, jtr, sizeof dx);
+      for (unsigned p = 0; p < a_n; ++p) {
+        a[p * a_n + p] += lambda * std::max(jtj[p * a_n + p], 1e-30);
+      }
+      bool is_better = false;
+      bool is_small = true;
+      double x_new[6];
+      double chi2_new = chi2;
+      if (Solve(a, dx, a_n)) {
+        for (unsigned p = 0; p < a_n; ++p) {
+          x_new[p] = a_x[p] + dx[p];
+          is_small = is_small &&
+              std::abs(dx[p]) <= LM_TOL_REL * (std::abs(a_x[p]) + 1.0);
+        }
+        if (is_small) {
+          // Already at the minimum, e.g. when warm-started.
+          break;
+        }
+        if (a_valid(x_new)) {
+          // Jacobian for free, jtj/jtr keep the last accepted point.
+          chi2_new = a_model(x_new, a_r, true);
+          ++itn;
+          is_better = std::isfinite(chi2_new) && chi2_new < chi2;
+        }
+      }
+      if (is_better) {
+        bool is_done = chi2 - chi2_new <= LM_TOL_REL * chi2;
+        memcpy(a_x, x_new, a_n * sizeof *a_x);
+        chi2 = chi2_new;
+        lambda = std::max(lambda / 10, 1e-12);
+        do_build = true;
+        if (is_done) {
+          break;
+        }
+      } else {
+        lambda *= 10;
+        if (lambda > LM_LAMBDA_MAX) {
+          break;
+        }
+      }
+    }
+    *a_chi2 = chi2;
+    return itn;
+  }
 }
 
-#define NLOPT_CALL(func, args) do { \
-  auto res_ = func args; \
-  if (res_ < 0) { \
-    auto str = nlopt_result_to_string(res_); \
-    std::cerr << "nlopt failed: " << str << ".\n"; \
-    throw std::runtime_error(__func__); \
-  } \
-} while (0)
+namespace {
+  // Averages ~10% of the bins at either end of the region.
+  void EdgeMeans(Region const &a_reg, double *a_left_t, double *a_left_v,
+      double *a_right_t, double *a_right_v)
+  {
+    auto m = std::max<size_t>(1, a_reg.n / 10);
+    double l = 0.0;
+    double r = 0.0;
+    for (size_t i = 0; i < m; ++i) {
+      l += a_reg.v[i];
+      r += a_reg.v[a_reg.n - 1 - i];
+    }
+    *a_left_t = a_reg.t[0] + 0.5 * (double)(m - 1);
+    *a_left_v = l / (double)m;
+    *a_right_t = a_reg.t[a_reg.n - 1] - 0.5 * (double)(m - 1);
+    *a_right_v = r / (double)m;
+  }
+
+  /*
+   * Gauss guess from the peak above the given background: the height of the
+   * tallest bin, the half-max crossings for the width and the first moment
+   * of the bins in between for the mean. Neighbouring peaks and tails don't
+   * drag this around like full-range moments would.
+   */
+  void GaussGuess(Region const &a_reg, std::vector<double> const &a_bg,
+      double a_max_y, double *a_amp, double *a_mean, double *a_width)
+  {
+    auto n = a_reg.n;
+    std::vector<double> w(n);
+    size_t peak_i = 0;
+    for (size_t i = 0; i < n; ++i) {
+      w[i] = a_reg.v[i] - a_bg[i];
+      if (w[i] > w[peak_i]) {
+        peak_i = i;
+      }
+    }
+    if (w[peak_i] <= 0.0) {
+      // Nothing sticks out, fall back to the middle.
+      *a_amp = std::max(a_max_y - a_bg[n / 2], 1.0);
+      *a_mean = 0.5 * (a_reg.t[0] + a_reg.t[n - 1]);
+      *a_width = 0.5 * (double)n;
+      return;
+    }
+    auto half = 0.5 * w[peak_i];
+    auto l = peak_i;
+    while (l > 0 && w[l - 1] > half) {
+      --l;
+    }
+    auto r = peak_i;
+    while (r + 1 < n && w[r + 1] > half) {
+      ++r;
+    }
+    // Interpolate the crossings, w[l] > half >= w[l-1] etc.
+    auto t_l = (double)l - 0.5;
+    if (l > 0) {
+      t_l = (double)l - (w[l] - half) / (w[l] - w[l - 1]);
+    }
+    auto t_r = (double)r + 0.5;
+    if (r + 1 < n) {
+      t_r = (double)r + (w[r] - half) / (w[r] - w[r + 1]);
+    }
+    double sum = 0.0;
+    double sum_t = 0.0;
+    for (auto i = l; i <= r; ++i) {
+      sum += w[i];
+      sum_t += w[i] * a_reg.t[i];
+    }
+    // FWHM = 2 sqrt(2 ln 2) std, and the width param is 2 std^2.
+    auto sigma = std::max(t_r - t_l, 1.0) / 2.35482;
+    *a_amp = w[peak_i];
+    *a_mean = sum_t / sum;
+    *a_width = 2 * sigma * sigma;
+  }
+
+#if PLUTT_FIT_BENCH
+  double BenchTime()
+  {
+    timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return (double)tp.tv_sec + 1e-9 * (double)tp.tv_nsec;
+  }
+
+# if PLUTT_NLOPT
+  struct NloptData {
+    Region *r;
+    ModelFunc model;
+    unsigned itn;
+  };
+
+  double NloptFunc(unsigned a_n, double const *a_x, double *a_grad, void
+      *a_data)
+  {
+    auto d = (NloptData *)a_data;
+    auto sum = d->model(a_x, d->r, nullptr != a_grad);
+    if (a_grad) {
+      // derr/dx = 2 sum [f(i) - v_i]df(i)/dx
+      auto n = d->r->n;
+      for (unsigned p = 0; p < a_n; ++p) {
+        double s = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+          s += d->r->jac[p * n + i] * d->r->res[i];
+        }
+        a_grad[p] = 2 * s;
+      }
+    }
+    ++d->itn;
+    return sum;
+  }
+# endif
+
+  /*
+   * Earlier nlopt tests, exp+gauss from mid-range guess:
+   *  solver             y       cnt  time
+   *  ln_praxis          9.3283  2055 0.0022
+   *  ld_tnewton         9.3283    58 0.0009
+   *  ld_tnewton_precond 9.3283    33 0.0008
+   *  ld_mma             9.85733  100 0.00018
+   *  ln_newuoa          9.3283    33 0.0014
+   *  ln_neldermead      9.33134  501 0.00055
+   *  ln_sbplx           11.1854 1647 0.0017
+   *  ld_ccsaq           9.33496  123 0.00021
+   */
+  void Bench(char const *a_name, Region *a_r, ModelFunc a_model, unsigned
+      a_n, double const *a_x0, double a_chi2, unsigned a_itn, double a_dt)
+  {
+    std::cout << a_name << " lm       " << a_chi2 << ' ' << a_itn << ' ' <<
+        a_dt << '\n';
+# if PLUTT_NLOPT
+    double x[6];
+    memcpy(x, a_x0, a_n * sizeof *x);
+    NloptData d;
+    d.r = a_r;
+    d.model = a_model;
+    d.itn = 0;
+    auto t0 = BenchTime();
+    auto opt = nlopt_create(NLOPT_LD_MMA, a_n);
+    nlopt_set_min_objective(opt, NloptFunc, &d);
+    nlopt_set_ftol_rel(opt, 1e-5);
+    double y;
+    auto res = nlopt_optimize(opt, x, &y);
+    auto t1 = BenchTime();
+    nlopt_destroy(opt);
+    std::cout << a_name << " nlopt_mma " << y << ' ' << d.itn << ' ' <<
+        t1 - t0 << (res < 0 ? " failed" : "") << '\n';
+# else
+    (void)a_r;
+    (void)a_model;
+    (void)a_n;
+    (void)a_x0;
+# endif
+  }
+#endif
+}
 
 /*
- * nlopt tests:
- *  solver             y       cnt  time
- *  ln_praxis          9.3283  2055 0.0022
- *  ld_tnewton         9.3283    58 0.0009
- *  ld_tnewton_precond 9.3283    33 0.0008
- *  ld_mma             9.85733  100 0.00018
- *  ln_newuoa          9.3283    33 0.0014
- *  ln_neldermead      9.33134  501 0.00055
- *  ln_sbplx           11.1854 1647 0.0017
- *  ld_ccsaq           9.33496  123 0.00021
+ * Initial values come from the region itself, an exponential through the
+ * edges and a peak above it, unless a previous fit is given.
  */
-
 FitExpGauss::FitExpGauss(std::vector<uint32_t> const &a_hist, double a_max_y,
-    uint32_t a_left, uint32_t a_right):
+    uint32_t a_left, uint32_t a_right, FitParams *a_params):
   m_y(),
   m_phase(),
   m_tau(),
@@ -181,46 +476,51 @@ FitExpGauss::FitExpGauss(std::vector<uint32_t> const &a_hist, double a_max_y,
   m_mean(),
   m_std()
 {
-  auto opt = nlopt_create(NLOPT_LD_MMA, 6);
-  Region r;
-  r.vec = &a_hist;
-  r.left = a_left;
-  r.right = a_right;
-  r.itn = 0;
-  NLOPT_CALL(nlopt_set_min_objective, (opt, ExpGauss, &r));
-  NLOPT_CALL(nlopt_set_ftol_rel, (opt, 1e-5));
+  if (a_right >= a_hist.size() || a_right < a_left + 5) {
+    // Not enough bins to say anything, looks like a failed fit.
+    return;
+  }
+  Region r(a_hist, a_left, a_right, 6);
   double x[6];
-  auto x2 = 0.5 * (a_left + a_right);
-  x[OFS            ] = 0.0;
-  x[EXP_GAUSS_PHASE] = x2;
-  x[EXP_GAUSS_TAU  ] = -x2;
-  x[EXP_GAUSS_AMP  ] = a_max_y / 2;
-  x[EXP_GAUSS_MEAN ] = x2;
-  x[EXP_GAUSS_WIDTH] = 0.5 * (a_right - a_left);
-  double y;
-#if BENCHMARK
-  double t0;
-  {
-    timespec tp;
-    clock_gettime(CLOCK_MONOTONIC, &tp);
-    t0 = (double)tp.tv_sec + 1e-9 * (double)tp.tv_nsec;
+  if (a_params && a_params->is_set && ExpGaussValid(a_params->x)) {
+    memcpy(x, a_params->x, sizeof x);
+  } else {
+    double l_t, l_v, r_t, r_v;
+    EdgeMeans(r, &l_t, &l_v, &r_t, &r_v);
+    // exp[(t-x2) / x3] = edge difference at the higher edge.
+    auto tau = 0.25 * (r_t - l_t);
+    auto amp = std::max(std::abs(l_v - r_v), 1.0);
+    if (l_v > r_v) {
+      x[OFS] = r_v;
+      x[EXP_GAUSS_TAU] = -tau;
+      x[EXP_GAUSS_PHASE] = l_t + tau * log(amp);
+    } else {
+      x[OFS] = l_v;
+      x[EXP_GAUSS_TAU] = tau;
+      x[EXP_GAUSS_PHASE] = r_t - tau * log(amp);
+    }
+    std::vector<double> bg(r.n);
+    for (size_t i = 0; i < r.n; ++i) {
+      bg[i] = x[OFS] + exp((r.t[i] - x[EXP_GAUSS_PHASE]) /
+          x[EXP_GAUSS_TAU]);
+    }
+    GaussGuess(r, bg, a_max_y, &x[EXP_GAUSS_AMP], &x[EXP_GAUSS_MEAN],
+        &x[EXP_GAUSS_WIDTH]);
   }
+  double chi2;
+#if PLUTT_FIT_BENCH
+  double x0[6];
+  memcpy(x0, x, sizeof x);
+  auto t0 = BenchTime();
+  auto itn = Lm(&r, ExpGauss, ExpGaussValid, 6, x, &chi2);
+  Bench("exp_gauss", &r, ExpGauss, 6, x0, chi2, itn, BenchTime() - t0);
+#else
+  Lm(&r, ExpGauss, ExpGaussValid, 6, x, &chi2);
 #endif
-  NLOPT_CALL(nlopt_optimize, (opt, x, &y));
-#if BENCHMARK
-  double t1;
-  {
-    timespec tp;
-    clock_gettime(CLOCK_MONOTONIC, &tp);
-    t1 = (double)tp.tv_sec + 1e-9 * (double)tp.tv_nsec;
+  if (a_params) {
+    memcpy(a_params->x, x, sizeof x);
+    a_params->is_set = true;
   }
-  std::cout
-      << y << ' '
-      << r.itn << ' '
-      << t1-t0 << ' '
-      << '\n';
-#endif
-  nlopt_destroy(opt);
   m_y = x[OFS];
   m_phase = x[EXP_GAUSS_PHASE];
   m_tau = x[EXP_GAUSS_TAU];
@@ -229,90 +529,59 @@ FitExpGauss::FitExpGauss(std::vector<uint32_t> const &a_hist, double a_max_y,
   m_std = sqrt(x[EXP_GAUSS_WIDTH] / 2);
 }
 
+FitExpGauss::~FitExpGauss()
+{
+}
+
+double FitExpGauss::GetY() const { return m_y; }
+double FitExpGauss::GetExpPhase() const { return m_phase; }
+double FitExpGauss::GetExpTau() const { return m_tau; }
+double FitExpGauss::GetGaussAmp() const { return m_amp; }
+double FitExpGauss::GetGaussMean() const { return m_mean; }
+double FitExpGauss::GetGaussStd() const { return m_std; }
+
 FitGauss::FitGauss(std::vector<uint32_t> const &a_hist, double a_max_y,
-    uint32_t a_left, uint32_t a_right):
+    uint32_t a_left, uint32_t a_right, FitParams *a_params):
   m_y(),
   m_amp(),
   m_mean(),
   m_std()
 {
-  auto opt = nlopt_create(NLOPT_LD_MMA, 4);
-  Region r;
-  r.vec = &a_hist;
-  r.left = a_left;
-  r.right = a_right;
-  r.itn = 0;
-  NLOPT_CALL(nlopt_set_min_objective, (opt, Gauss, &r));
-  NLOPT_CALL(nlopt_set_ftol_rel, (opt, 1e-5));
+  if (a_right >= a_hist.size() || a_right < a_left + 3) {
+    return;
+  }
+  Region r(a_hist, a_left, a_right, 4);
   double x[4];
-  x[OFS] = 0.0;
-  x[GAUSS_AMP] = a_max_y;
-  x[GAUSS_MEAN] = 0.5 * (a_left + a_right);
-  x[GAUSS_WIDTH] = 0.5 * (a_right - a_left);
-  double y;
-#if BENCHMARK
-  double t0;
-  {
-    timespec tp;
-    clock_gettime(CLOCK_MONOTONIC, &tp);
-    t0 = (double)tp.tv_sec + 1e-9 * (double)tp.tv_nsec;
+  if (a_params && a_params->is_set && GaussValid(a_params->x)) {
+    memcpy(x, a_params->x, sizeof x);
+  } else {
+    double l_t, l_v, r_t, r_v;
+    EdgeMeans(r, &l_t, &l_v, &r_t, &r_v);
+    x[OFS] = std::min(l_v, r_v);
+    std::vector<double> bg(r.n, x[OFS]);
+    GaussGuess(r, bg, a_max_y, &x[GAUSS_AMP], &x[GAUSS_MEAN],
+        &x[GAUSS_WIDTH]);
   }
+  double chi2;
+#if PLUTT_FIT_BENCH
+  double x0[4];
+  memcpy(x0, x, sizeof x);
+  auto t0 = BenchTime();
+  auto itn = Lm(&r, Gauss, GaussValid, 4, x, &chi2);
+  Bench("gauss", &r, Gauss, 4, x0, chi2, itn, BenchTime() - t0);
+#else
+  Lm(&r, Gauss, GaussValid, 4, x, &chi2);
 #endif
-  NLOPT_CALL(nlopt_optimize, (opt, x, &y));
-#if BENCHMARK
-  double t1;
-  {
-    timespec tp;
-    clock_gettime(CLOCK_MONOTONIC, &tp);
-    t1 = (double)tp.tv_sec + 1e-9 * (double)tp.tv_nsec;
+  if (a_params) {
+    memcpy(a_params->x, x, sizeof x);
+    a_params->is_set = true;
   }
-  std::cout
-      << y << ' '
-      << r.itn << ' '
-      << t1-t0 << ' '
-      << '\n';
-#endif
-  nlopt_destroy(opt);
   m_y = x[OFS];
   m_amp = x[GAUSS_AMP];
   m_mean = x[GAUSS_MEAN];
   m_std = sqrt(x[GAUSS_WIDTH] / 2);
 }
 
-#else
-
-FitExpGauss::FitExpGauss(std::vector<uint32_t> const &, double, uint32_t,
-    uint32_t):
-  m_y(),
-  m_phase(),
-  m_tau(),
-  m_amp(),
-  m_mean(),
-  m_std()
-{
-}
-
-FitGauss::FitGauss(std::vector<uint32_t> const &, double, uint32_t, uint32_t):
-  m_y(),
-  m_amp(),
-  m_mean(),
-  m_std()
-{
-}
-
-#endif
-
-FitExpGauss::~FitExpGauss()
-{
-}
-
-double FitExpGauss::GetY() const { return m_y; }
-double FitExpGauss::GetExpPhase() const { return m_phase; }
-double FitExpGauss::GetExpTau() const { return m_tau; }
-double FitExpGauss::GetGaussAmp() const { return m_amp; }
-double FitExpGauss::GetGaussMean() const { return m_mean; }
-double FitExpGauss::GetGaussStd() const { return m_std; }
-
 FitGauss::~FitGauss()
 {
 }
@@ -20,12 +20,111 @@
  * MA  02110-1301  USA
  */
 
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <map>
 #include <string>
 #include <vector>
 #include <gui.hpp>
+#include <job_queue.hpp>
+#include <util.hpp>
+
+// Latch period for plots known to be hidden in all GUI:s.
+#define HIDDEN_LATCH_MS 2000
+// Helper jobs per latch, more than the job workers is pointless.
+#define LATCH_HELPER_NUM 4
+
+/*
+ * Latches a list of plots with help from the job workers and returns when
+ * all are done. Every plot has its own mutex and buffers, so no other
+ * synchronization is needed.
+ */
+class GuiCollection::LatchBatch {
+  public:
+    LatchBatch();
+    ~LatchBatch();
+    void Latch(std::vector<Gui::Plot *> const &);
+
+  private:
+    LatchBatch(LatchBatch const &);
+    LatchBatch &operator=(LatchBatch const &);
+    void Run();
+
+    class Helper: public Job {
+      public:
+        Helper(LatchBatch *);
+        void Run();
+
+      private:
+        Helper(Helper const &);
+        Helper &operator=(Helper const &);
+
+        LatchBatch *m_batch;
+    };
+    std::vector<Helper *> m_helper_vec;
+    std::vector<Gui::Plot *> const *m_plot_vec;
+    std::atomic<size_t> m_plot_i;
+};
+
+GuiCollection::LatchBatch::Helper::Helper(LatchBatch *a_batch):
+  Job(),
+  m_batch(a_batch)
+{
+}
+
+void GuiCollection::LatchBatch::Helper::Run()
+{
+  m_batch->Run();
+}
+
+GuiCollection::LatchBatch::LatchBatch():
+  m_helper_vec(),
+  m_plot_vec(),
+  m_plot_i()
+{
+  for (unsigned i = 0; i < LATCH_HELPER_NUM; ++i) {
+    m_helper_vec.push_back(new Helper(this));
+  }
+}
+
+GuiCollection::LatchBatch::~LatchBatch()
+{
+  for (auto it = m_helper_vec.begin(); m_helper_vec.end() != it; ++it) {
+    (*it)->Cancel();
+    delete *it;
+  }
+}
+
+void GuiCollection::LatchBatch::Latch(std::vector<Gui::Plot *> const &a_vec)
+{
+  m_plot_vec = &a_vec;
+  m_plot_i = 0;
+  if (a_vec.size() > 1) {
+    for (auto it = m_helper_vec.begin(); m_helper_vec.end() != it; ++it) {
+      (*it)->Queue();
+    }
+  }
+  Run();
+  // Barrier, nobody may draw a half-latched plot. Helpers that never got a
+  // worker are unqueued, running ones finish their last plot.
+  for (auto it = m_helper_vec.begin(); m_helper_vec.end() != it; ++it) {
+    (*it)->Cancel();
+  }
+  m_plot_vec = nullptr;
+}
+
+void GuiCollection::LatchBatch::Run()
+{
+  auto const &vec = *m_plot_vec;
+  for (;;) {
+    auto i = m_plot_i++;
+    if (i >= vec.size()) {
+      break;
+    }
+    vec[i]->Latch();
+  }
+}
 
 void Gui::Axis::Clear()
 {
@@ -59,21 +158,58 @@ Gui::~Gui()
 
 GuiCollection::Entry::Entry():
   plot(),
-  id_vec()
+  id_vec(),
+  t_latch()
 {
 }
 
 GuiCollection::Entry::Entry(Entry const &a_entry):
   plot(a_entry.plot),
-  id_vec(a_entry.id_vec)
+  id_vec(a_entry.id_vec),
+  t_latch(a_entry.t_latch)
+{
+}
+
+GuiCollection::GuiCollection():
+  m_gui_map(),
+  m_plot_vec(),
+  m_latch_vec(),
+  m_latch_batch(new LatchBatch)
 {
 }
 
+GuiCollection::~GuiCollection()
+{
+  delete m_latch_batch;
+}
+
 void GuiCollection::AddGui(Gui *a_gui)
 {
   m_gui_map.insert(std::make_pair(a_gui, m_gui_map.size()));
 }
 
+void GuiCollection::RemoveGui(Gui *a_gui)
+{
+  auto it = m_gui_map.find(a_gui);
+  if (m_gui_map.end() == it) {
+    return;
+  }
+  auto gui_i = it->second;
+  m_gui_map.erase(it);
+  // Keep GUI numbers dense so they still index the plot id lists.
+  for (it = m_gui_map.begin(); m_gui_map.end() != it; ++it) {
+    if (it->second > gui_i) {
+      --it->second;
+    }
+  }
+  for (auto it2 = m_plot_vec.begin(); m_plot_vec.end() != it2; ++it2) {
+    auto &id_vec = it2->id_vec;
+    if (gui_i < id_vec.size()) {
+      id_vec.erase(id_vec.begin() + gui_i);
+    }
+  }
+}
+
 #define FOR_GUI \
   for (auto it = m_gui_map.begin(); m_gui_map.end() != it; ++it)
 
@@ -90,10 +226,12 @@ uint32_t GuiCollection::AddPlot(std::string const &a_name, Gui::Plot *a_plot)
   m_plot_vec.push_back(Entry());
   auto &pe = m_plot_vec.back();
   pe.plot = a_plot;
+  // Indexed by the GUI number, not the map order.
+  pe.id_vec.resize(m_gui_map.size());
   FOR_GUI {
     auto gui = it->first;
-    auto id = gui->AddPlot(a_name, a_plot);
-    pe.id_vec.push_back(id);
+    auto gui_i = it->second;
+    pe.id_vec.at(gui_i) = gui->AddPlot(a_name, a_plot);
   }
   return (uint32_t)m_plot_vec.size() - 1;
 }
@@ -112,10 +250,32 @@ bool GuiCollection::DoClear(uint32_t a_id)
 
 bool GuiCollection::Draw(double a_event_rate)
 {
-  for (auto it = m_plot_vec.begin(); m_plot_vec.end() != it; ++it) {
-    auto plot = it->plot;
-    plot->Latch();
+  auto t_cur = Time_get_ms();
+  m_latch_vec.clear();
+  for (auto it2 = m_plot_vec.begin(); m_plot_vec.end() != it2; ++it2) {
+    auto &pe = *it2;
+    bool is_visible = false;
+    bool is_known = false;
+    FOR_GUI {
+      auto gui = it->first;
+      auto gui_i = it->second;
+      switch (gui->GetVisibility(pe.id_vec.at(gui_i))) {
+        case Gui::kHidden:
+          is_known = true;
+          break;
+        case Gui::kVisible:
+          is_visible = true;
+          break;
+        case Gui::kUnknown:
+          break;
+      }
+    }
+    if (is_visible || !is_known || t_cur >= pe.t_latch + HIDDEN_LATCH_MS) {
+      m_latch_vec.push_back(pe.plot);
+      pe.t_latch = t_cur;
+    }
   }
+  m_latch_batch->Latch(m_latch_vec);
   bool ok = true;
   FOR_GUI {
     auto gui = it->first;
@@ -138,26 +298,27 @@ void GuiCollection::DrawAnnular(Gui *a_gui, uint32_t a_id, Gui::Axis const
 
 void GuiCollection::DrawHist1(Gui *a_gui, uint32_t a_id, Gui::Axis const
     &a_axis, LinearTransform const &a_transform, bool a_is_log_y, bool
-    a_is_contour, std::vector<uint32_t> const &a_v, std::vector<Gui::Peak>
-    const &a_peak_vec)
+    a_is_contour, std::vector<uint32_t> const &a_v, Hist1Pyramid const
+    &a_pyramid, std::vector<Gui::Peak> const &a_peak_vec, std::vector<float>
+    const &a_bg_vec)
 {
   auto it = m_gui_map.find(a_gui);
   assert(m_gui_map.end() != it);
   auto gui_i = it->second;
   auto const &pe = m_plot_vec.at(a_id);
   a_gui->DrawHist1(pe.id_vec.at(gui_i), a_axis, a_transform, a_is_log_y,
-      a_is_contour, a_v, a_peak_vec);
+      a_is_contour, a_v, a_pyramid, a_peak_vec, a_bg_vec);
 }
 
 void GuiCollection::DrawHist2(Gui *a_gui, uint32_t a_id, Gui::Axis const
     &a_axis_x, Gui::Axis const &a_axis_y, LinearTransform const
     &a_transform_x, LinearTransform const &a_transform_y, bool a_is_log_z,
-    std::vector<uint32_t> const &a_v)
+    TiledCounts const &a_hist)
 {
   auto it = m_gui_map.find(a_gui);
   assert(m_gui_map.end() != it);
   auto gui_i = it->second;
   auto const &pe = m_plot_vec.at(a_id);
   a_gui->DrawHist2(pe.id_vec.at(gui_i), a_axis_x, a_axis_y, a_transform_x,
-      a_transform_y, a_is_log_z, a_v);
+      a_transform_y, a_is_log_z, a_hist);
 }
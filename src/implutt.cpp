@@ -28,15 +28,17 @@
 #include <SDL.h>
 
 #include <cassert>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <list>
-#include <map>
 #include <set>
 #include <sstream>
 #include <string>
 #include <vector>
 
+#include <tiled_counts.hpp>
 #include <ttf.hpp>
 #include <util.hpp>
 #include <implutt.hpp>
@@ -84,6 +86,14 @@
 
 #define TRUNC(x, min, max) \
     (x) < (min) ? (min) : (x) >= (max) ? (max) : (x)
+// 2D colour lookup: small integer counts map directly, the rest in buckets
+// of 2^LUT_MANT_BITS per octave between 2^LUT_EXP_MIN and 2^LUT_EXP_MAX.
+#define LUT_DIRECT_NUM 4096
+#define LUT_EXP_MIN -16
+#define LUT_EXP_MAX 32
+#define LUT_MANT_BITS 8
+// Glyph atlas side, repacked from scratch when full.
+#define GLYPH_ATLAS_SIZE 1024
 
 namespace ImPlutt {
 
@@ -93,6 +103,9 @@ namespace ImPlutt {
     Style g_style_i;
     std::set<Window *> g_window_set;
     bool g_do_quit;
+    // Scratch for text rendering.
+    std::vector<FontGlyph> g_glyph_vec;
+    std::vector<uint32_t> g_glyph_pixels;
 
     enum {
       STYLE_BG,
@@ -160,34 +173,11 @@ namespace ImPlutt {
   Level::Level(Rect const &a_rect):
     rect(a_rect),
     cursor(a_rect.x, a_rect.y),
-    max_h()
+    max_h(),
+    is_muted()
   {
   }
 
-  //
-  // Text texture cache.
-  //
-
-  TextKey::TextKey():
-    str(),
-    font_style(),
-    style_i(),
-    style_sub_i()
-  {
-  }
-
-  bool TextKey::operator()(TextKey const &a_l, TextKey const &a_r) const {
-#define CMP(field) \
-    if (a_l.field < a_r.field) return true; \
-    if (a_l.field > a_r.field) return false
-    int cmp = a_l.str.compare(a_r.str);
-    if (cmp) return cmp < 0;
-    CMP(font_style);
-    CMP(style_i);
-    CMP(style_sub_i);
-    return false;
-  }
-
   Window::Window(char const *a_title, int a_width, int a_height):
     m_window(),
     m_window_id(),
@@ -198,9 +188,19 @@ namespace ImPlutt {
     m_event_list(),
     m_pointer(),
     m_level_stack(),
-    m_text_tex_map(),
     m_do_close(),
-    m_tex_destroy_list()
+    m_glyph_tex(),
+    m_glyph_pen(),
+    m_glyph_row_h(),
+    m_glyph_rect_vec(),
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    m_glyph_vertex_vec(),
+    m_glyph_index_vec(),
+#endif
+    m_rect_vec(),
+    m_canvas(),
+    m_do_redraw(),
+    m_do_present()
   {
     // Find a position that causes little overlap.
     // Silly approach: Move the window in large steps, choose what causes the
@@ -286,6 +286,12 @@ namespace ImPlutt {
     SDL_CALL_VOID(SDL_SetTextureBlendMode,
         (m_checkmark_tex, SDL_BLENDMODE_BLEND));
 
+    SDL_CALL(m_glyph_tex, SDL_CreateTexture, (m_renderer,
+        SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, GLYPH_ATLAS_SIZE,
+        GLYPH_ATLAS_SIZE));
+    SDL_CALL_VOID(SDL_SetTextureBlendMode,
+        (m_glyph_tex, SDL_BLENDMODE_BLEND));
+
     g_window_set.insert(this);
   }
 
@@ -294,11 +300,11 @@ namespace ImPlutt {
     auto it = g_window_set.find(this);
     assert(g_window_set.end() != it);
     g_window_set.erase(it);
-    for (auto it2 = m_text_tex_map.begin(); m_text_tex_map.end() != it2;
-        ++it2) {
-      SDL_DestroyTexture(it2->second.tex);
-    }
+    SDL_DestroyTexture(m_glyph_tex);
     SDL_DestroyTexture(m_checkmark_tex);
+    if (m_canvas) {
+      SDL_DestroyTexture(m_canvas);
+    }
     SDL_DestroyRenderer(m_renderer);
     SDL_DestroyWindow(m_window);
   }
@@ -357,7 +363,9 @@ namespace ImPlutt {
       r.w = x2 - x1;
       r.h = y2 - y1;
     }
+    bool is_muted = !m_level_stack.empty() && LevelGet().is_muted;
     m_level_stack.push_back(Level(r));
+    LevelGet().is_muted = is_muted;
     SDL_Rect sdl_r;
     sdl_r.x = r.x;
     sdl_r.y = r.y;
@@ -419,6 +427,9 @@ namespace ImPlutt {
 
   void Window::DrawLineClipped(Pos const &a_p1, Pos const &a_p2)
   {
+    if (LevelGet().is_muted) {
+      return;
+    }
     // Metal crashes with crazy lines, let's clip ourselves.
     SDL_Rect r;
     SDL_RenderGetClipRect(m_renderer, &r);
@@ -498,6 +509,9 @@ namespace ImPlutt {
   void Window::RenderRect(Rect const &a_r, bool a_do_shadow)
   {
     auto const &l = LevelGet();
+    if (l.is_muted) {
+      return;
+    }
     SDL_Rect sdl_r;
     sdl_r.x = l.cursor.x + a_r.x;
     sdl_r.y = l.cursor.y + a_r.y;
@@ -515,9 +529,68 @@ namespace ImPlutt {
     }
   }
 
+  void Window::RenderRectsAdd(Rect const &a_r)
+  {
+    auto const &l = LevelGet();
+    SDL_Rect sdl_r;
+    sdl_r.x = l.cursor.x + a_r.x;
+    sdl_r.y = l.cursor.y + a_r.y;
+    sdl_r.w = a_r.w;
+    sdl_r.h = a_r.h;
+    m_rect_vec.push_back(sdl_r);
+  }
+
+  // Only for horizontal or vertical lines, which are thin rects.
+  void Window::RenderRectsAddLine(Pos const &a_p1, Pos const &a_p2)
+  {
+    assert(a_p1.x == a_p2.x || a_p1.y == a_p2.y);
+    Rect r;
+    r.x = std::min(a_p1.x, a_p2.x);
+    r.y = std::min(a_p1.y, a_p2.y);
+    r.w = std::abs(a_p2.x - a_p1.x) + 1;
+    r.h = std::abs(a_p2.y - a_p1.y) + 1;
+    RenderRectsAdd(r);
+  }
+
+  void Window::RenderRectsFlush()
+  {
+    if (LevelGet().is_muted) {
+      m_rect_vec.clear();
+      return;
+    }
+    // Like for lines, keep crazy coordinates away from the backend.
+    SDL_Rect clip;
+    SDL_RenderGetClipRect(m_renderer, &clip);
+    size_t j = 0;
+    for (size_t i = 0; i < m_rect_vec.size(); ++i) {
+      auto r = m_rect_vec[i];
+      if (clip.w > 0 && clip.h > 0) {
+        auto x1 = std::max(r.x, clip.x);
+        auto y1 = std::max(r.y, clip.y);
+        auto x2 = std::min(r.x + r.w, clip.x + clip.w);
+        auto y2 = std::min(r.y + r.h, clip.y + clip.h);
+        r.x = x1;
+        r.y = y1;
+        r.w = x2 - x1;
+        r.h = y2 - y1;
+      }
+      if (r.w > 0 && r.h > 0) {
+        m_rect_vec[j++] = r;
+      }
+    }
+    if (j > 0) {
+      SDL_CALL_VOID(SDL_RenderFillRects, (m_renderer, &m_rect_vec[0],
+          (int)j));
+    }
+    m_rect_vec.clear();
+  }
+
   void Window::RenderTexture(SDL_Texture *a_tex, Rect const &a_r)
   {
     auto &l = LevelGet();
+    if (l.is_muted) {
+      return;
+    }
     SDL_Rect sdl_r;
     sdl_r.x = l.cursor.x + a_r.x;
     sdl_r.y = l.cursor.y + a_r.y;
@@ -604,42 +677,117 @@ namespace ImPlutt {
         Pos(a_pos.x       , a_pos.y+a_size));
   }
 
+  // Returns where the glyph lives in the atlas, packing it if needed.
+  SDL_Rect Window::RenderGlyphGet(uint32_t a_id, unsigned a_w, unsigned a_h,
+      uint8_t const *a_bmap)
+  {
+    if (a_id < m_glyph_rect_vec.size() && m_glyph_rect_vec[a_id].w > 0) {
+      return m_glyph_rect_vec[a_id];
+    }
+    // 1px gap so neighbours never bleed.
+    auto w = (int)a_w + 1;
+    auto h = (int)a_h + 1;
+    if (w > GLYPH_ATLAS_SIZE || h > GLYPH_ATLAS_SIZE) {
+      std::cerr << "Glyph " << a_w << 'x' << a_h << " too large for atlas.\n";
+      throw std::runtime_error(__func__);
+    }
+    if (m_glyph_pen.x + w > GLYPH_ATLAS_SIZE) {
+      m_glyph_pen.x = 0;
+      m_glyph_pen.y += m_glyph_row_h;
+      m_glyph_row_h = 0;
+    }
+    if (m_glyph_pen.y + h > GLYPH_ATLAS_SIZE) {
+      // Full, draw what refers to the old packing and start over.
+      RenderGlyphFlush();
+      m_glyph_rect_vec.clear();
+      m_glyph_pen = Pos(0, 0);
+      m_glyph_row_h = 0;
+    }
+    SDL_Rect r;
+    r.x = m_glyph_pen.x;
+    r.y = m_glyph_pen.y;
+    r.w = (int)a_w;
+    r.h = (int)a_h;
+    // White with coverage as alpha, the text color is modulated in.
+    g_glyph_pixels.resize(a_w * a_h);
+    for (size_t i = 0; i < g_glyph_pixels.size(); ++i) {
+      g_glyph_pixels[i] = 0xffffff00 | a_bmap[i];
+    }
+    SDL_CALL_VOID(SDL_UpdateTexture, (m_glyph_tex, &r, g_glyph_pixels.data(),
+        (int)a_w * 4));
+    m_glyph_pen.x += w;
+    m_glyph_row_h = std::max(m_glyph_row_h, h);
+    if (a_id >= m_glyph_rect_vec.size()) {
+      SDL_Rect empty;
+      memset(&empty, 0, sizeof empty);
+      m_glyph_rect_vec.resize(a_id + 1, empty);
+    }
+    m_glyph_rect_vec[a_id] = r;
+    return r;
+  }
+
+  void Window::RenderGlyphFlush()
+  {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    if (!m_glyph_index_vec.empty()) {
+      SDL_CALL_VOID(SDL_RenderGeometry, (m_renderer, m_glyph_tex,
+          m_glyph_vertex_vec.data(), (int)m_glyph_vertex_vec.size(),
+          m_glyph_index_vec.data(), (int)m_glyph_index_vec.size()));
+    }
+    m_glyph_vertex_vec.clear();
+    m_glyph_index_vec.clear();
+#endif
+  }
+
   void Window::RenderText(char const *a_str, TextStyle a_font_style, int
       a_style_i, Pos const &a_ofs)
   {
-    // Check cache.
-    TextKey key;
-    key.str = a_str;
-    key.font_style = a_font_style;
-    key.style_i = g_style_i;
-    key.style_sub_i = a_style_i;
-    auto it = m_text_tex_map.find(key);
-    if (m_text_tex_map.end() == it) {
-      auto rgb = g_style[g_style_i][a_style_i];
-      FontSetBold(g_font, TEXT_BOLD == a_font_style);
-      auto printed = FontPrintf(g_font, a_str, rgb.r, rgb.g, rgb.b);
-      SDL_Surface *surf;
-      SDL_CALL(surf, SDL_CreateRGBSurfaceWithFormatFrom,
-          (printed.bmap.data(), (int)printed.size.w, (int)printed.size.h,
-           32, (int)printed.size.w * 4, SDL_PIXELFORMAT_RGBA8888));
-      TextTexture value;
-      SDL_CALL(value.tex, SDL_CreateTextureFromSurface, (m_renderer, surf));
-      value.r.x = printed.size.x;
-      value.r.y = printed.size.y;
-      value.r.w = surf->w;
-      value.r.h = surf->h;
-      SDL_FreeSurface(surf);
-      auto pair = m_text_tex_map.insert(std::make_pair(key, value));
-      it = pair.first;
-    }
-    auto &value = it->second;
-    Rect r;
-    r.x = value.r.x + a_ofs.x;
-    r.y = value.r.y + a_ofs.y;
-    r.w = value.r.w;
-    r.h = value.r.h;
-    RenderTexture(value.tex, r);
-    value.t_last = Time_get_ms();
+    auto const &l = LevelGet();
+    if (l.is_muted) {
+      return;
+    }
+    FontSetBold(g_font, TEXT_BOLD == a_font_style);
+    FontLayout(g_font, a_str, &g_glyph_vec);
+    auto rgb = g_style[g_style_i][a_style_i];
+#if !SDL_VERSION_ATLEAST(2, 0, 18)
+    SDL_CALL_VOID(SDL_SetTextureColorMod, (m_glyph_tex, rgb.r, rgb.g,
+        rgb.b));
+#endif
+    auto x0 = l.cursor.x + a_ofs.x;
+    auto y0 = l.cursor.y + a_ofs.y;
+    for (auto it = g_glyph_vec.begin(); g_glyph_vec.end() != it; ++it) {
+      if (!it->w || !it->h) {
+        continue;
+      }
+      auto src = RenderGlyphGet(it->id, it->w, it->h, it->bmap);
+      SDL_Rect dst;
+      dst.x = x0 + it->x;
+      dst.y = y0 + it->y;
+      dst.w = src.w;
+      dst.h = src.h;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+      auto i0 = (int)m_glyph_vertex_vec.size();
+      float const scale = 1.0f / GLYPH_ATLAS_SIZE;
+      for (unsigned k = 0; k < 4; ++k) {
+        auto dx = (k & 1) ? dst.w : 0;
+        auto dy = (k & 2) ? dst.h : 0;
+        SDL_Vertex v;
+        v.position.x = (float)(dst.x + dx);
+        v.position.y = (float)(dst.y + dy);
+        v.color = rgb;
+        v.tex_coord.x = (float)(src.x + dx) * scale;
+        v.tex_coord.y = (float)(src.y + dy) * scale;
+        m_glyph_vertex_vec.push_back(v);
+      }
+      int const c_quad[] = {0, 1, 2, 1, 3, 2};
+      for (unsigned k = 0; k < 6; ++k) {
+        m_glyph_index_vec.push_back(i0 + c_quad[k]);
+      }
+#else
+      SDL_CALL_VOID(SDL_RenderCopy, (m_renderer, m_glyph_tex, &src, &dst));
+#endif
+    }
+    RenderGlyphFlush();
   }
 
   Pos Window::RenderTextMeasure(char const *a_str, TextStyle a_style)
@@ -801,9 +949,12 @@ namespace ImPlutt {
         g_do_quit = true;
         break;
       case SDL_WINDOWEVENT:
-        if (SDL_WINDOWEVENT_CLOSE == e.sdl_ev.window.event &&
-            m_window_id == e.sdl_ev.window.windowID) {
-          m_do_close = true;
+        if (m_window_id == e.sdl_ev.window.windowID) {
+          if (SDL_WINDOWEVENT_CLOSE == e.sdl_ev.window.event) {
+            m_do_close = true;
+          }
+          // Exposed, resized, moved between screens etc.
+          m_do_redraw = true;
         }
         break;
     }
@@ -822,19 +973,45 @@ namespace ImPlutt {
     return g_do_quit;
   }
 
-  void Window::Begin()
+  void Window::Begin(bool a_is_cached)
   {
     // Just make sure it's not leaking.
     assert(m_event_list.size() < 1000);
     assert(m_level_stack.empty());
 
-    SDL_SetRenderDrawColor(m_renderer, 0, 0, 0, 0);
-    SDL_RenderClear(m_renderer);
-
     SDL_GetWindowSize(m_window, &m_wsize.x, &m_wsize.y);
     SDL_CALL_VOID(SDL_GetRendererOutputSize,
         (m_renderer, &m_rsize.x, &m_rsize.y));
 
+    // A cached window renders into a canvas which is kept between frames,
+    // any input may change any widget so then everything is redrawn.
+    if (a_is_cached && SDL_RenderTargetSupported(m_renderer)) {
+      int w = 0, h = 0;
+      if (m_canvas) {
+        SDL_QueryTexture(m_canvas, nullptr, nullptr, &w, &h);
+      }
+      if (w != m_rsize.x || h != m_rsize.y) {
+        if (m_canvas) {
+          SDL_DestroyTexture(m_canvas);
+          m_canvas = nullptr;
+        }
+        SDL_CALL(m_canvas, SDL_CreateTexture, (m_renderer,
+            SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, m_rsize.x,
+            m_rsize.y));
+        m_do_redraw = true;
+      }
+      SDL_CALL_VOID(SDL_SetRenderTarget, (m_renderer, m_canvas));
+      m_do_redraw |= !m_event_list.empty();
+    } else {
+      m_do_redraw = true;
+    }
+    m_do_present = m_do_redraw;
+
+    if (m_do_redraw) {
+      SDL_SetRenderDrawColor(m_renderer, 0, 0, 0, 0);
+      SDL_RenderClear(m_renderer);
+    }
+
     RenderColor(g_style[g_style_i][STYLE_BG]);
     Rect r;
     r.x = 0;
@@ -842,6 +1019,7 @@ namespace ImPlutt {
     r.w = m_rsize.x;
     r.h = m_rsize.y;
     LevelPush(r);
+    LevelGet().is_muted = !m_do_redraw;
     RenderRect(r, false);
   }
 
@@ -852,24 +1030,18 @@ namespace ImPlutt {
 
     m_event_list.clear();
 
-    SDL_RenderPresent(m_renderer);
-
-    // Destroy old unused textures.
-    for (auto it = m_text_tex_map.begin(); m_text_tex_map.end() != it;) {
-      auto it_next = it;
-      ++it_next;
-      auto &val = it->second;
-      if (val.t_last + 1000 < Time_get_ms()) {
-        m_tex_destroy_list.push_back(val.tex);
-        m_text_tex_map.erase(it);
+    if (m_canvas) {
+      SDL_CALL_VOID(SDL_SetRenderTarget, (m_renderer, nullptr));
+      if (m_do_present) {
+        SDL_CALL_VOID(SDL_RenderSetClipRect, (m_renderer, nullptr));
+        SDL_CALL_VOID(SDL_RenderCopy, (m_renderer, m_canvas, nullptr,
+            nullptr));
       }
-      it = it_next;
     }
-    for (auto it = m_tex_destroy_list.begin(); m_tex_destroy_list.end() != it;
-        ++it) {
-      SDL_DestroyTexture(*it);
+    if (m_do_present) {
+      SDL_RenderPresent(m_renderer);
     }
-    m_tex_destroy_list.clear();
+    m_do_redraw = false;
   }
 
   Pos Window::GetSize()
@@ -910,6 +1082,30 @@ namespace ImPlutt {
     LevelPush(r);
   }
 
+  // Returns true if the caller should draw the current level, which is then
+  // cleared unless the whole window is being redrawn anyway.
+  bool Window::Redraw(bool a_is_dirty)
+  {
+    auto &l = LevelGet();
+    if (m_do_redraw) {
+      return true;
+    }
+    if (!a_is_dirty) {
+      l.is_muted = true;
+      return false;
+    }
+    l.is_muted = false;
+    m_do_present = true;
+    RenderColor(g_style[g_style_i][STYLE_BG]);
+    SDL_Rect sdl_r;
+    sdl_r.x = l.rect.x;
+    sdl_r.y = l.rect.y;
+    sdl_r.w = l.rect.w;
+    sdl_r.h = l.rect.h;
+    SDL_CALL_VOID(SDL_RenderFillRect, (m_renderer, &sdl_r));
+    return true;
+  }
+
   void Window::Rewind()
   {
     LevelPop();
@@ -920,6 +1116,7 @@ namespace ImPlutt {
     r.w = m_rsize.x;
     r.h = m_rsize.y;
     LevelPush(r);
+    LevelGet().is_muted = !m_do_redraw;
   }
 
   //
@@ -1306,6 +1503,10 @@ namespace ImPlutt {
     window(),
     plot_state(),
     vec(),
+    prefix(),
+    prefix_version(),
+    prefix_bins_x(),
+    prefix_bins_y(),
     point(),
     width(),
     band_r()
@@ -1330,6 +1531,28 @@ namespace ImPlutt {
     Unproject();
   }
 
+  Hist2Texture::Hist2Texture():
+    tex(),
+    w(),
+    h(),
+    version(),
+    colormap(),
+    bins_x(),
+    bins_y(),
+    is_log(),
+    rect_w(),
+    rect_h(),
+    style_i()
+  {
+  }
+
+  Hist2Texture::~Hist2Texture()
+  {
+    if (tex) {
+      SDL_DestroyTexture(tex);
+    }
+  }
+
   void PlotState::CutClear()
   {
     if (cut.t > 0) {
@@ -1342,6 +1565,16 @@ namespace ImPlutt {
     }
   }
 
+  bool PlotState::IsTense() const
+  {
+    auto t = Time_get_ms();
+    return
+        t < cut.t + TENSION_TIMEOUT_MS ||
+        t < proj.t + TENSION_TIMEOUT_MS ||
+        t < zooming.x.t + TENSION_TIMEOUT_MS ||
+        t < zooming.y.t + TENSION_TIMEOUT_MS;
+  }
+
   bool PlotState::GoTo(UserState a_state)
   {
     if ((a_state & state_mask)) {
@@ -1382,6 +1615,7 @@ namespace ImPlutt {
     proj.window = nullptr;
     delete proj.plot_state;
     proj.plot_state = nullptr;
+    std::vector<double>().swap(proj.prefix);
     memset(&proj.band_r, 0, sizeof proj.band_r);
   }
 
@@ -2165,6 +2399,107 @@ namespace ImPlutt {
     return true;
   }
 
+  //
+  // Colour lookup for 2D plots.
+  //
+
+  namespace {
+    /*
+     * Count -> packed RGBA8888 for one 2D draw, instead of a log10, ramp
+     * index arithmetic and a checked lookup per bin. Integer counts below
+     * LUT_DIRECT_NUM are looked up directly, anything else by the float
+     * exponent and top mantissa bits, i.e. ~0.4% relative resolution which is
+     * finer than the colour ramps.
+     */
+    class ColorLut {
+      public:
+        ColorLut(Plot const *, size_t, double, double, bool);
+        uint32_t Get(uint32_t a_v) const
+        {
+          return a_v < m_direct.size() ? m_direct[a_v] : Bucket(a_v);
+        }
+        uint32_t Get(double a_v) const
+        {
+          return a_v > 0.0 ? Bucket(a_v) : m_bg;
+        }
+
+      private:
+        uint32_t Bucket(double a_v) const
+        {
+          auto f = (float)a_v;
+          uint32_t u;
+          memcpy(&u, &f, sizeof u);
+          auto e = (int)(u >> 23) - 127;
+          if (e < m_exp_min) {
+            return m_bucket.front();
+          }
+          if (e > m_exp_max) {
+            return m_bucket.back();
+          }
+          auto m = (u >> (23 - LUT_MANT_BITS)) & ((1 << LUT_MANT_BITS) - 1);
+          return m_bucket[((size_t)(e - m_exp_min) << LUT_MANT_BITS) | m];
+        }
+        static uint32_t Pack(uint8_t a_r, uint8_t a_g, uint8_t a_b)
+        {
+          return (uint32_t)a_r << 24 | (uint32_t)a_g << 16 |
+              (uint32_t)a_b << 8 | 255;
+        }
+        uint32_t m_bg;
+        int m_exp_min;
+        int m_exp_max;
+        std::vector<uint32_t> m_direct;
+        std::vector<uint32_t> m_bucket;
+    };
+
+    // Integer-only users never need buckets below LUT_DIRECT_NUM.
+    ColorLut::ColorLut(Plot const *a_plot, size_t a_colormap, double a_min,
+        double a_max, bool a_is_int):
+      m_bg(),
+      m_exp_min(),
+      m_exp_max(),
+      m_direct(),
+      m_bucket()
+    {
+      auto const &bg_col = g_style[g_style_i][STYLE_PLOT_BG];
+      m_bg = Pack(bg_col.r, bg_col.g, bg_col.b);
+
+      auto const &cmap = g_cmap_vec.at(a_colormap);
+      auto min_z = a_plot->LinOrLogFromLinZ(a_min);
+      auto max_z = a_plot->LinOrLogFromLinZ(a_max);
+      auto dz = std::max(max_z - min_z, 1.0);
+      auto ramp_max = (double)(cmap.ramp.size() - 1);
+      auto map = [&](double a_v) {
+        auto f = (a_plot->LinOrLogFromLinZ(a_v) - min_z) / dz;
+        f = std::max(0.0, std::min(f, 1.0));
+        auto const &rgb = cmap.ramp[(size_t)(ramp_max * f)];
+        return Pack(rgb.r, rgb.g, rgb.b);
+      };
+
+      auto direct_num = (size_t)std::min(a_max + 1.0, (double)LUT_DIRECT_NUM);
+      m_direct.resize(a_is_int ? std::max(direct_num, (size_t)1) : 0);
+      for (size_t i = 0; i < m_direct.size(); ++i) {
+        m_direct[i] = 0 == i ? m_bg : map((double)i);
+      }
+
+      int e;
+      frexp(std::max(a_max, 1.0), &e);
+      m_exp_max = std::min(e - 1, LUT_EXP_MAX);
+      if (a_is_int) {
+        frexp((double)LUT_DIRECT_NUM, &e);
+        m_exp_min = e - 1;
+      } else {
+        m_exp_min = LUT_EXP_MIN;
+      }
+      m_exp_max = std::max(m_exp_max, m_exp_min);
+      m_bucket.resize((size_t)(m_exp_max - m_exp_min + 1) << LUT_MANT_BITS);
+      for (size_t i = 0; i < m_bucket.size(); ++i) {
+        auto m = (double)(i & ((1 << LUT_MANT_BITS) - 1)) + 0.5;
+        auto x = 1.0 + m / (1 << LUT_MANT_BITS);
+        m_bucket[i] = map(ldexp(x, m_exp_min + (int)(i >> LUT_MANT_BITS)));
+      }
+    }
+  }
+
   //
   // Annular.
   //
@@ -2190,12 +2525,8 @@ namespace ImPlutt {
       min_t = std::min(min_t, v);
       max_t = std::max(max_t, v);
     }
-    auto min_z = a_plot->LinOrLogFromLinZ(min_t);
-    auto max_z = a_plot->LinOrLogFromLinZ(max_t);
-    auto dz = std::max(max_z - min_z, 1.0);
-
-    auto const &cmap = g_cmap_vec.at(0);
-    auto const &bg_col = g_style[g_style_i][STYLE_PLOT_BG];
+    ColorLut lut(a_plot, 0, (double)min_t, (double)max_t,
+        std::numeric_limits<T>::is_integer);
 
     RenderColor(g_style[g_style_i][STYLE_PLOT_BG]);
     RenderRect(r, false);
@@ -2219,20 +2550,12 @@ namespace ImPlutt {
         p[1].y = a_plot->PosFromPointY(r1 * sin(p0));
         p[2].y = a_plot->PosFromPointY(r1 * sin(p1));
         p[3].y = a_plot->PosFromPointY(r0 * sin(p1));
-        auto v = (double)a_vec.at(k++);
+        auto rgba = lut.Get(a_vec[k++]);
         SDL_Color col;
+        col.r = (uint8_t)(rgba >> 24);
+        col.g = (uint8_t)(rgba >> 16);
+        col.b = (uint8_t)(rgba >> 8);
         col.a = 255;
-        if (v > 0.0) {
-          v = a_plot->LinOrLogFromLinZ(v);
-          auto f = (v - min_z) / dz;
-          auto const ramp_i = (size_t)((double)(cmap.ramp.size() - 1) * f);
-          auto const &rgb = cmap.ramp.at(ramp_i);
-          col.r = rgb.r;
-          col.g = rgb.g;
-          col.b = rgb.b;
-        } else {
-          col = bg_col;
-        }
         RenderColor(col);
         RenderTriangle(&p[0], &p[1], &p[2]);
         RenderTriangle(&p[0], &p[2], &p[3]);
@@ -2249,15 +2572,16 @@ namespace ImPlutt {
 #define PLOT_TMPL(T) \
   void Window::PlotHist1(Plot const *a_plot, \
       double a_min, double a_max, \
-      std::vector<T> const &a_vec, size_t a_bins, bool a_is_contour)
+      std::vector<T> const &a_vec, size_t a_bins, bool a_is_contour, \
+      Hist1Pyramid const *a_pyramid)
   template <typename T> PLOT_TMPL(T)
   {
     auto const &r = a_plot->m_rect_graph;
     RenderColor(g_style[g_style_i][STYLE_PLOT_BG]);
     RenderRect(r, false);
 
-    // TODO: Plot texture and render that, faster? Does it matter?
-
+    // Everything is batched into rects, lines are axis-aligned anyway, so a
+    // plot costs a couple of draw calls rather than one per bin or column.
     RenderColor(g_style[g_style_i][STYLE_PLOT_FG]);
     // Figure out how many pixels the histogram covers.
     auto left = a_plot->PosFromPointX(a_min);
@@ -2281,13 +2605,13 @@ namespace ImPlutt {
             // Draw the left edge if it's away from the view edge.
             Pos p1(pos_x_prev, pos_y_prev);
             Pos p2(pos_x_prev, h);
-            RenderLine(p1, p2);
+            RenderRectsAddLine(p1, p2);
           }
           {
             // Top.
             Pos p1(pos_x_prev, h);
             Pos p2(pos_x, h);
-            RenderLine(p1, p2);
+            RenderRectsAddLine(p1, p2);
           }
         } else {
           Rect r_col;
@@ -2295,7 +2619,7 @@ namespace ImPlutt {
           r_col.y = h;
           r_col.w = pos_x - pos_x_prev;
           r_col.h = r.h - h;
-          RenderRect(r_col, false);
+          RenderRectsAdd(r_col);
         }
         pos_x_prev = pos_x;
         pos_y_prev = h;
@@ -2305,8 +2629,9 @@ namespace ImPlutt {
         // edge of the view.
         Pos p1(pos_x_prev, pos_y_prev);
         Pos p2(pos_x_prev, 0);
-        RenderLine(p1, p2);
+        RenderRectsAddLine(p1, p2);
       }
+      RenderRectsFlush();
     } else {
       // Fewer pixels than bins:
       //  Contour: draw vertical min to max in covered bins, including the
@@ -2322,6 +2647,7 @@ namespace ImPlutt {
         int max;
       };
       std::vector<Blurred> blurred((size_t)r.w);
+      bool is_pyramid = a_pyramid && a_pyramid->GetSize() == a_bins;
       size_t i0 = (size_t)(
           (double)a_bins * (a_plot->PointFromPosX(0) - a_min)
           / (a_max - a_min));
@@ -2331,17 +2657,22 @@ namespace ImPlutt {
             (a_max - a_min));
         assert(i0 < i1);
 
-        double sum = a_vec.at(i0);
-        double min = sum;
-        double max = sum;
-        for (auto i = i0 + 1; i < i1; ++i) {
-          auto v = (double)a_vec.at(i);
-          sum += v;
-          min = std::min(min, v);
-          max = std::max(max, v);
+        double v_min;
+        double v_max;
+        if (is_pyramid) {
+          // O(log bins) per column instead of all bins under it.
+          uint32_t min, max;
+          a_pyramid->Query(i0, std::min(i1, a_bins), &min, &max);
+          v_min = min;
+          v_max = max;
+        } else {
+          v_min = v_max = (double)a_vec.at(i0);
+          for (auto i = i0 + 1; i < i1; ++i) {
+            auto v = (double)a_vec.at(i);
+            v_min = std::min(v_min, v);
+            v_max = std::max(v_max, v);
+          }
         }
-        auto v_min = min;
-        auto v_max = max;
 
         auto h_min = a_plot->PosFromPointY(v_min);
         auto h_max = a_plot->PosFromPointY(v_max);
@@ -2353,7 +2684,7 @@ namespace ImPlutt {
 
           Pos p1(pi, y1);
           Pos p2(pi, y2);
-          RenderLine(p1, p2);
+          RenderRectsAddLine(p1, p2);
 
           contour_prev.min = h_max;
           contour_prev.max = h_min;
@@ -2364,7 +2695,7 @@ namespace ImPlutt {
           r_col.y = h_min;
           r_col.w = 1;
           r_col.h = r.h - h_min;
-          RenderRect(r_col, false);
+          RenderRectsAdd(r_col);
 
           auto &b = blurred.at((size_t)pi);
           b.min = h_min;
@@ -2373,6 +2704,7 @@ namespace ImPlutt {
 
         i0 = i1;
       }
+      RenderRectsFlush();
       if (a_is_contour) {
       } else {
         // Draw blurred min-max columns on top of the solid rects.
@@ -2387,8 +2719,9 @@ namespace ImPlutt {
           r_col.y = b.max;
           r_col.w = 1;
           r_col.h = b.min - b.max;
-          RenderRect(r_col, false);
+          RenderRectsAdd(r_col);
         }
+        RenderRectsFlush();
         a_plot->m_window->RenderTransparent(false);
       }
     }
@@ -2400,122 +2733,155 @@ namespace ImPlutt {
   // 2D histo.
   //
 
-#define PLOT_TMPL(T) \
-  void Window::PlotHist2(Plot *a_plot, size_t a_colormap, \
-      Point const &a_min, Point const &a_max, \
-      std::vector<T> const &a_vec, size_t a_bins_y, size_t a_bins_x, \
-      std::vector<uint8_t> &a_pixels)
-  template <typename T> PLOT_TMPL(T)
+  namespace {
+    // Sums the rectangle [a_x0,a_x1)x[a_y0,a_y1) into one output per column,
+    // or per row, visiting only touched tiles.
+    void BandSum(TiledCounts const &a_hist, size_t a_x0, size_t a_x1, size_t
+        a_y0, size_t a_y1, bool a_per_column, std::vector<float> *a_out)
+    {
+      a_out->assign(a_per_column ? a_hist.GetWidth() : a_hist.GetHeight(),
+          0.0f);
+      auto tile_w = a_hist.GetTileWidth();
+      auto tile_h = a_hist.GetTileHeight();
+      std::vector<uint32_t> tile(tile_w * tile_h);
+      for (auto y = a_y0; y < a_y1;) {
+        auto ny = std::min(tile_h - (y & (tile_h - 1)), a_y1 - y);
+        for (auto x = a_x0; x < a_x1;) {
+          auto nx = std::min(tile_w - (x & (tile_w - 1)), a_x1 - x);
+          if (a_hist.HasTile(x, y)) {
+            a_hist.CopyRect(x, y, nx, ny, tile.data());
+            auto p = tile.data();
+            for (size_t i = 0; i < ny; ++i) {
+              for (size_t j = 0; j < nx; ++j) {
+                (*a_out)[a_per_column ? x + j : y + i] += (float)*p++;
+              }
+            }
+          }
+          x += nx;
+        }
+        y += ny;
+      }
+    }
+  }
+
+  void Window::PlotHist2(Plot *a_plot, size_t a_colormap,
+      Point const &a_min, Point const &a_max, TiledCounts const &a_hist,
+      uint64_t a_version, Hist2Texture *a_tex)
   {
-    if (!a_bins_y || !a_bins_x) {
+    auto bins_x = a_hist.GetWidth();
+    auto bins_y = a_hist.GetHeight();
+    if (!bins_y || !bins_x) {
       return;
     }
-    assert(a_bins_y * a_bins_x <= a_vec.size());
 
     auto const &rect = a_plot->m_rect_graph;
 
-    T min_t = a_vec[0];
-    T max_t = a_vec[0];
-    for (size_t ofs = 1; ofs < a_bins_y * a_bins_x; ++ofs) {
-      auto v = a_vec[ofs];
-      min_t = std::min(min_t, v);
-      max_t = std::max(max_t, v);
-    }
-    auto min_z = a_plot->LinOrLogFromLinZ(min_t);
-    auto max_z = a_plot->LinOrLogFromLinZ(max_t);
-    auto dz = std::max(max_z - min_z, 1.0);
-
-    auto const &cmap = g_cmap_vec.at(a_colormap);
-
-    auto const &bg_col = g_style[g_style_i][STYLE_PLOT_BG];
-    size_t w, h;
-    if ((size_t)rect.w >= a_bins_x && (size_t)rect.h >= a_bins_y) {
-      w = a_bins_x;
-      h = a_bins_y;
-      // More pixels than bins, let SDL scale the texture.
-      auto bytes = w * h * 4;
-      if (a_pixels.size() < bytes) {
-        a_pixels.resize(bytes);
+    // Zooming and panning only move the texture, the pixels depend on this.
+    if (!a_tex->tex ||
+        a_tex->version != a_version ||
+        a_tex->colormap != a_colormap ||
+        a_tex->bins_x != bins_x ||
+        a_tex->bins_y != bins_y ||
+        a_tex->is_log != a_plot->m_state->is_log.is_on ||
+        a_tex->rect_w != rect.w ||
+        a_tex->rect_h != rect.h ||
+        a_tex->style_i != g_style_i) {
+      a_tex->version = a_version;
+      a_tex->colormap = a_colormap;
+      a_tex->bins_x = bins_x;
+      a_tex->bins_y = bins_y;
+      a_tex->is_log = a_plot->m_state->is_log.is_on;
+      a_tex->rect_w = rect.w;
+      a_tex->rect_h = rect.h;
+      a_tex->style_i = g_style_i;
+
+      uint32_t min_v, max_v;
+      a_hist.GetMinMax(&min_v, &max_v);
+      size_t w, h;
+      bool is_scaled = (size_t)rect.w >= bins_x && (size_t)rect.h >=
+          bins_y;
+      if (is_scaled) {
+        // More pixels than bins, let SDL scale the texture.
+        w = bins_x;
+        h = bins_y;
+      } else {
+        // <1px/bin, do nearest-neighbour filtering.
+        w = std::min((size_t)rect.w, bins_x);
+        h = std::min((size_t)rect.h, bins_y);
       }
-      uint8_t *p = &a_pixels.at(0);
-      for (size_t i = 0; i < h; ++i) {
-        auto t = &a_vec.at((h - i - 1) * w);
-        for (size_t j = 0; j < w; ++j) {
-          *p++ = 255;
-          auto v = (double)*t++;
-          if (v > 0.0) {
-            v = a_plot->LinOrLogFromLinZ(v);
-            auto f = (v - min_z) / dz;
-            auto const ramp_i = (size_t)(
-                (double)(cmap.ramp.size() - 1) * f);
-            auto const &rgb = cmap.ramp.at(ramp_i);
-            *p++ = rgb.b;
-            *p++ = rgb.g;
-            *p++ = rgb.r;
-          } else {
-            *p++ = bg_col.b;
-            *p++ = bg_col.g;
-            *p++ = bg_col.r;
-          }
+      if (!a_tex->tex || a_tex->w != w || a_tex->h != h) {
+        if (a_tex->tex) {
+          SDL_DestroyTexture(a_tex->tex);
+          a_tex->tex = nullptr;
         }
+        SDL_CALL(a_tex->tex, SDL_CreateTexture, (m_renderer,
+            SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, (int)w,
+            (int)h));
+        a_tex->w = w;
+        a_tex->h = h;
       }
-    } else {
-      // <1px/bin, do nearest-neighbour filtering.
-      w = std::min((size_t)rect.w, a_bins_x);
-      h = std::min((size_t)rect.h, a_bins_y);
-      auto bytes = w * h * 4;
-      if (a_pixels.size() < bytes) {
-        a_pixels.resize(bytes);
-      }
-      uint8_t *p = &a_pixels.at(0);
-      size_t i0 = 0;
-      for (size_t y = 0; y < h; ++y) {
-        auto i1 = a_bins_y * (y + 1) / (size_t)h;
-        assert(i1 <= a_bins_y);
-        auto i2 = i0 == i1 ? i1 + 1 : i1;
-        size_t j0 = 0;
-        for (size_t x = 0; x < w; ++x) {
-          auto j1 = a_bins_x * (x + 1) / (size_t)w;
-          assert(j1 <= a_bins_x);
-          auto j2 = j0 == j1 ? j1 + 1 : j1;
-          *p++ = 255;
-          double v = 0.0;
-          unsigned n = 0;
-          auto ofs = (a_bins_y - i2) * a_bins_x + j0;
-          for (auto i = i0; i < i2; ++i) {
-            for (auto j = j0; j < j2; ++j) {
-              v += a_vec.at(ofs++);
-              ++n;
+      void *pixels;
+      int pitch;
+      SDL_CALL_VOID(SDL_LockTexture, (a_tex->tex, nullptr, &pixels,
+          &pitch));
+      if (is_scaled) {
+        // At most one bin per pixel, so a row at a time is cheap.
+        ColorLut lut(a_plot, a_colormap, min_v, max_v, true);
+        std::vector<uint32_t> row(w);
+        for (size_t i = 0; i < h; ++i) {
+          auto p = (uint32_t *)((uint8_t *)pixels + i * (size_t)pitch);
+          a_hist.CopyRect(0, h - i - 1, w, 1, row.data());
+          for (size_t j = 0; j < w; ++j) {
+            p[j] = lut.Get(row[j]);
+          }
+        }
+      } else {
+        // Bin averages are not integers.
+        ColorLut lut(a_plot, a_colormap, min_v, max_v, false);
+        // Every pixel covers whole bins, map bins to pixels and sum touched
+        // tiles only, untouched ones add nothing. Texture rows go top-down.
+        std::vector<uint32_t> px(bins_x), py(bins_y);
+        std::vector<uint32_t> nx(w), ny(h);
+        for (size_t j = 0; j < bins_x; ++j) {
+          px[j] = (uint32_t)(((j + 1) * w - 1) / bins_x);
+          ++nx[px[j]];
+        }
+        for (size_t i = 0; i < bins_y; ++i) {
+          py[i] = (uint32_t)(((bins_y - i) * h - 1) / bins_y);
+          ++ny[py[i]];
+        }
+        std::vector<double> sum(w * h);
+        auto tile_w = a_hist.GetTileWidth();
+        auto tile_h = a_hist.GetTileHeight();
+        std::vector<uint32_t> tile(tile_w * tile_h);
+        for (size_t y0 = 0; y0 < bins_y; y0 += tile_h) {
+          auto th = std::min(tile_h, bins_y - y0);
+          for (size_t x0 = 0; x0 < bins_x; x0 += tile_w) {
+            if (!a_hist.HasTile(x0, y0)) {
+              continue;
+            }
+            auto tw = std::min(tile_w, bins_x - x0);
+            a_hist.CopyRect(x0, y0, tw, th, tile.data());
+            auto t = tile.data();
+            for (size_t i = 0; i < th; ++i) {
+              auto s = &sum[py[y0 + i] * w];
+              for (size_t j = 0; j < tw; ++j) {
+                s[px[x0 + j]] += t[j];
+              }
+              t += tw;
             }
-            ofs += a_bins_x - (j2 - j0);
           }
-          v /= n;
-          if (v > 0.0) {
-            v = a_plot->LinOrLogFromLinZ(v);
-            auto f = (v - min_z) / dz;
-            auto const ramp_i = (size_t)(
-                (double)(cmap.ramp.size() - 1) * f);
-            auto const &rgb = cmap.ramp.at(ramp_i);
-            *p++ = rgb.b;
-            *p++ = rgb.g;
-            *p++ = rgb.r;
-          } else {
-            *p++ = bg_col.b;
-            *p++ = bg_col.g;
-            *p++ = bg_col.r;
+        }
+        for (size_t y = 0; y < h; ++y) {
+          auto p = (uint32_t *)((uint8_t *)pixels + y * (size_t)pitch);
+          auto s = &sum[y * w];
+          for (size_t x = 0; x < w; ++x) {
+            p[x] = lut.Get(s[x] / (nx[x] * ny[y]));
           }
-          j0 = j1;
         }
-        i0 = i1;
       }
+      SDL_UnlockTexture(a_tex->tex);
     }
-    SDL_Surface *surf;
-    SDL_CALL(surf, SDL_CreateRGBSurfaceWithFormatFrom,
-        (&a_pixels[0], (int)w, (int)h, 32, (int)w * 4,
-         SDL_PIXELFORMAT_RGBA8888));
-    SDL_Texture *tex;
-    SDL_CALL(tex, SDL_CreateTextureFromSurface, (m_renderer, surf));
-    SDL_FreeSurface(surf);
     // Scale a_min/a_max into a_plot->m_min/m_max.
     Rect r;
     r.w = (int)(
@@ -2528,8 +2894,7 @@ namespace ImPlutt {
     );
     r.x = a_plot->PosFromPointX(a_min.x);
     r.y = a_plot->PosFromPointY(a_max.y);
-    RenderTexture(tex, r);
-    m_tex_destroy_list.push_back(tex);
+    RenderTexture(a_tex->tex, r);
 
     auto state = a_plot->m_state;
     if (state->proj.window) {
@@ -2541,29 +2906,51 @@ namespace ImPlutt {
       if (PlotState::PROJ_X == state->proj.state) {
         min_x = a_plot->m_min.x;
         max_x = a_plot->m_max.x;
-        int i = (int)((state->proj.point.y - a_min.y) * (double)a_bins_y /
+        int i = (int)((state->proj.point.y - a_min.y) * (double)bins_y /
             (a_max.y - a_min.y));
         int i0 = i - state->proj.width / 2;
         i0 = std::max(i0, 0);
         int i1 = i0 + state->proj.width;
-        i1 = std::min(i1, (int)a_bins_y);
+        i1 = std::min(i1, (int)bins_y);
         i0 = i1 - state->proj.width;
         i0 = std::max(i0, 0);
-        if (a_bins_x > state->proj.vec.size()) {
-          state->proj.vec.resize(a_bins_x);
-        }
-        for (size_t j = 0; j < a_bins_x; ++j) {
-          state->proj.vec.at(j) = 0;
-        }
-        auto ap = &a_vec.at((size_t)i0 * a_bins_x);
-        for (i = i0; i < i1; ++i) {
-          for (size_t j = 0; j < a_bins_x; ++j) {
-            state->proj.vec.at(j) += (float)*ap++;
+        if (a_hist.IsSparse()) {
+          BandSum(a_hist, 0, bins_x, (size_t)i0, (size_t)i1, true,
+              &state->proj.vec);
+        } else {
+          // prefix[i * bins_x + j] = sum of rows < i in column j.
+          auto &prefix = state->proj.prefix;
+          if (prefix.empty() ||
+              state->proj.prefix_version != a_version ||
+              state->proj.prefix_bins_x != bins_x ||
+              state->proj.prefix_bins_y != bins_y) {
+            prefix.resize((bins_y + 1) * bins_x);
+            std::vector<uint32_t> row(bins_x);
+            auto pp = &prefix[0];
+            for (size_t j = 0; j < bins_x; ++j) {
+              pp[j] = 0.0;
+            }
+            for (size_t k = 0; k < bins_y; ++k) {
+              a_hist.CopyRect(0, k, bins_x, 1, row.data());
+              for (size_t j = 0; j < bins_x; ++j) {
+                pp[bins_x + j] = pp[j] + (double)row[j];
+              }
+              pp += bins_x;
+            }
+            state->proj.prefix_version = a_version;
+            state->proj.prefix_bins_x = bins_x;
+            state->proj.prefix_bins_y = bins_y;
+          }
+          state->proj.vec.resize(bins_x);
+          auto p0 = &prefix[(size_t)i0 * bins_x];
+          auto p1 = &prefix[(size_t)i1 * bins_x];
+          for (size_t j = 0; j < bins_x; ++j) {
+            state->proj.vec[j] = (float)(p1[j] - p0[j]);
           }
         }
-        auto y0 = a_min.y + (a_max.y - a_min.y) * i0 / (int)a_bins_y;
+        auto y0 = a_min.y + (a_max.y - a_min.y) * i0 / (int)bins_y;
         auto yy0 = a_plot->PosFromPointY(y0);
-        auto y1 = a_min.y + (a_max.y - a_min.y) * i1 / (int)a_bins_y;
+        auto y1 = a_min.y + (a_max.y - a_min.y) * i1 / (int)bins_y;
         auto yy1 = a_plot->PosFromPointY(y1);
         state->proj.band_r.y = yy0;
         state->proj.band_r.h = yy1 - yy0;
@@ -2571,28 +2958,48 @@ namespace ImPlutt {
         min_x = a_plot->m_min.y;
         max_x = a_plot->m_max.y;
         int j = (int)((state->proj.point.x - a_plot->m_min.x) *
-            (double)a_bins_x / (a_plot->m_max.x - a_plot->m_min.x));
+            (double)bins_x / (a_plot->m_max.x - a_plot->m_min.x));
         int j0 = j - state->proj.width / 2;
         j0 = std::max(j0, 0);
         int j1 = j0 + state->proj.width;
-        j1 = std::min(j1, (int)a_bins_x);
+        j1 = std::min(j1, (int)bins_x);
         j0 = j1 - state->proj.width;
         j0 = std::max(j0, 0);
-        if (a_bins_y > state->proj.vec.size()) {
-          state->proj.vec.resize(a_bins_y);
-        }
-        for (size_t i = 0; i < a_bins_y; ++i) {
-          state->proj.vec.at(i) = 0;
-        }
-        auto ap = &a_vec.at((size_t)j0);
-        for (size_t i = 0; i < a_bins_y; ++i) {
-          for (j = j0; j < j1; ++j) {
-            state->proj.vec.at(i) += (float)*ap++;
+        if (a_hist.IsSparse()) {
+          BandSum(a_hist, (size_t)j0, (size_t)j1, 0, bins_y, false,
+              &state->proj.vec);
+        } else {
+          // prefix[i * (bins_x + 1) + j] = sum of columns < j in row i.
+          auto &prefix = state->proj.prefix;
+          if (prefix.empty() ||
+              state->proj.prefix_version != a_version ||
+              state->proj.prefix_bins_x != bins_x ||
+              state->proj.prefix_bins_y != bins_y) {
+            prefix.resize(bins_y * (bins_x + 1));
+            std::vector<uint32_t> row(bins_x);
+            auto pp = &prefix[0];
+            for (size_t i = 0; i < bins_y; ++i) {
+              a_hist.CopyRect(0, i, bins_x, 1, row.data());
+              *pp = 0.0;
+              for (size_t k = 0; k < bins_x; ++k) {
+                pp[1] = pp[0] + (double)row[k];
+                ++pp;
+              }
+              ++pp;
+            }
+            state->proj.prefix_version = a_version;
+            state->proj.prefix_bins_x = bins_x;
+            state->proj.prefix_bins_y = bins_y;
+          }
+          state->proj.vec.resize(bins_y);
+          auto pp = &prefix[0];
+          for (size_t i = 0; i < bins_y; ++i) {
+            state->proj.vec[i] = (float)(pp[j1] - pp[j0]);
+            pp += bins_x + 1;
           }
-          ap += a_bins_x - (size_t)(j1 - j0);
         }
-        state->proj.band_r.x += rect.w * j0 / (int)a_bins_x;
-        state->proj.band_r.w = rect.w * (j1 - j0) / (int)a_bins_x + 1;
+        state->proj.band_r.x += rect.w * j0 / (int)bins_x;
+        state->proj.band_r.w = rect.w * (j1 - j0) / (int)bins_x + 1;
       } else {
         throw std::runtime_error(__func__);
       }
@@ -2614,8 +3021,6 @@ namespace ImPlutt {
       win->End();
     }
   }
-  PLOT_TMPL_INSTANTIATE;
-#undef PLOT_TMPL
 
   //
   // Poly-line.
@@ -0,0 +1,164 @@
+/*
+ * plutt, a scriptable monitor for experimental data.
+ *
+ * Copyright (C) 2025
+ * Hans Toshihide Toernqvist <hans.tornqvist@chalmers.se>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+#include <algorithm>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <job_queue.hpp>
+
+// Cap on workers, the input and event threads need cores too.
+#define JOB_THREADS_MAX 4
+
+class JobQueue {
+  public:
+    JobQueue();
+    ~JobQueue();
+    void Cancel(Job *);
+    void Push(Job *);
+
+  private:
+    JobQueue(JobQueue const &);
+    JobQueue &operator=(JobQueue const &);
+    void Worker();
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::list<Job *> m_job_list;
+    std::vector<std::thread> m_thread_vec;
+    bool m_is_running;
+};
+
+namespace {
+  JobQueue g_job_queue;
+}
+
+JobQueue::JobQueue():
+  m_mutex(),
+  m_cv(),
+  m_job_list(),
+  m_thread_vec(),
+  m_is_running()
+{
+}
+
+JobQueue::~JobQueue()
+{
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_is_running = false;
+  }
+  m_cv.notify_all();
+  for (auto it = m_thread_vec.begin(); m_thread_vec.end() != it; ++it) {
+    it->join();
+  }
+}
+
+void JobQueue::Cancel(Job *a_job)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_job_list.remove(a_job);
+  a_job->m_is_queued = false;
+  m_cv.wait(lock, [a_job]{ return !a_job->m_is_running; });
+}
+
+void JobQueue::Push(Job *a_job)
+{
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (a_job->m_is_queued) {
+      return;
+    }
+    if (m_thread_vec.empty()) {
+      // Start lazily, most configs never need it.
+      auto core_num = std::thread::hardware_concurrency();
+      auto thread_num = core_num > 3 ? core_num - 3 : 1;
+      thread_num = std::min(thread_num, (unsigned)JOB_THREADS_MAX);
+      m_is_running = true;
+      for (unsigned i = 0; i < thread_num; ++i) {
+        m_thread_vec.push_back(std::thread(&JobQueue::Worker, this));
+      }
+    }
+    a_job->m_is_queued = true;
+    m_job_list.push_back(a_job);
+  }
+  m_cv.notify_all();
+}
+
+void JobQueue::Worker()
+{
+  for (;;) {
+    Job *job;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      // Jobs queued again while running wait for the running instance.
+      auto it = m_job_list.end();
+      m_cv.wait(lock, [this, &it]{
+          if (!m_is_running) {
+            return true;
+          }
+          for (it = m_job_list.begin(); m_job_list.end() != it; ++it) {
+            if (!(*it)->m_is_running) {
+              return true;
+            }
+          }
+          return false;
+      });
+      if (!m_is_running) {
+        break;
+      }
+      job = *it;
+      m_job_list.erase(it);
+      // Can be queued again while running, to pick up newer input.
+      job->m_is_queued = false;
+      job->m_is_running = true;
+    }
+    job->Run();
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      job->m_is_running = false;
+    }
+    m_cv.notify_all();
+  }
+}
+
+Job::Job():
+  m_is_queued(),
+  m_is_running()
+{
+}
+
+Job::~Job()
+{
+}
+
+void Job::Cancel()
+{
+  g_job_queue.Cancel(this);
+}
+
+void Job::Queue()
+{
+  g_job_queue.Push(this);
+}
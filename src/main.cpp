@@ -96,6 +96,7 @@ namespace {
   char const *g_arg0;
   char const *g_conf_path;
   char const *g_dot_path;
+  char const *g_state_path;
   long g_jobs;
   Input *g_input;
 #if PLUTT_ROOT
@@ -118,12 +119,15 @@ namespace {
       std::cout << "\n";
     }
     std::cout << "Usage: " "plutt" // << g_arg0 <<
-        " -f config [-h] [-d output-file] [-g gui] " //"[-j jobs] "
+        " -f config [-h] [-d output-file] [-g gui] [-s state-file] "
+        //"[-j jobs] "
         "input...\n";
     std::cout << "\n";
     std::cout << " -f   plutt config file.\n";
     std::cout << " -h   print usage statement.\n";
     std::cout << " -d   generate dot file from nodes.\n";
+    std::cout << " -s   load/save calibration states (pedestals, fine-times)"
+        " from/to file.\n";
     std::cout << " -g   activate GUI's (comma-separated if several):";
 #if PLUTT_SDL2
     std::cout << " sdl";
@@ -246,10 +250,6 @@ int main(int argc, char **argv)
 #if PLUTT_SDL2
   with += "SDL2+freetype2";
 #endif
-#if PLUTT_NLOPT
-  if (!with.empty()) with += ',';
-  with += "nlopt";
-#endif
 #if PLUTT_ROOT
   if (!with.empty()) with += ',';
   with += "ROOT";
@@ -270,7 +270,7 @@ int main(int argc, char **argv)
   unsigned gui_type = GUI_NONE;
   (void)gui_type;
   int c;
-  while ((c = getopt(argc, argv, "d:hf:g:j:o:x" ROOT_ARGOPT UCESB_ARGOPT)) !=
+  while ((c = getopt(argc, argv, "d:hf:g:j:o:s:x" ROOT_ARGOPT UCESB_ARGOPT)) !=
       -1) {
     switch (c) {
       case 'd':
@@ -352,6 +352,9 @@ int main(int argc, char **argv)
         input_type = INPUT_UCESB;
         break;
 #endif
+      case 's':
+        g_state_path = optarg;
+        break;
       case 'x':
         input_type = INPUT_HAX;
         break;
@@ -414,6 +417,9 @@ int main(int argc, char **argv)
   // of arrays.
   // The ctor sets g_config by itself, nice hack bro.
   new Config(g_conf_path, g_dot_path);
+  if (g_state_path) {
+    g_config->StateLoad(g_state_path);
+  }
   switch (input_type) {
 #if PLUTT_ROOT
     case INPUT_ROOT_FILES:
@@ -521,6 +527,10 @@ int main(int argc, char **argv)
   thread_input.join();
   thread_event.join();
 
+  // Data threads are done, safe to save the final node states.
+  g_config->StateSave();
+  g_config->MultOverPrint();
+
 #if PLUTT_SDL2
   if (GUI_SDL & gui_type) {
     delete sdl_gui;
@@ -22,6 +22,7 @@
 
 #include <cassert>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <map>
 #include <string>
@@ -40,25 +41,26 @@ BitfieldArg::BitfieldArg(std::string const &a_loc, NodeValue *a_node, uint32_t
 NodeBitfield::Field::Field():
   node(),
   bits(),
-  value(),
-  i(),
-  vi()
+  ofs(),
+  value()
 {
 }
 
 NodeBitfield::Field::Field(NodeValue *a_node, uint32_t a_bits):
   node(a_node),
   bits(a_bits),
-  value(),
-  i(),
-  vi()
+  ofs(),
+  value()
 {
 }
 
 NodeBitfield::NodeBitfield(std::string const &a_loc, BitfieldArg *a_arg_list):
   NodeValue(a_loc),
   m_source_vec(),
-  m_value()
+  m_value(),
+  m_word_vec(),
+  m_merge(),
+  m_run_vec()
 {
   // The parser built the arg list in reverse order!
   unsigned n = 0;
@@ -72,6 +74,24 @@ NodeBitfield::NodeBitfield(std::string const &a_loc, BitfieldArg *a_arg_list):
     delete a_arg_list;
     a_arg_list = next;
   }
+  uint32_t ofs = 0;
+  for (auto it = m_source_vec.begin(); m_source_vec.end() != it; ++it) {
+    it->ofs = ofs;
+    ofs += it->bits;
+  }
+}
+
+uint64_t NodeBitfield::GetPart(Field const &a_field, uint32_t a_vi)
+{
+  uint64_t part = a_field.value->GetV()[a_vi].u64;
+  auto mask = (1ULL << a_field.bits) - 1;
+  if (part > mask) {
+    std::cerr << a_field.node->GetLocStr() <<
+        ": Value=" << std::hex << part <<
+        " larger than # bits=" << std::dec << a_field.bits << "!\n";
+    throw std::runtime_error(__func__);
+  }
+  return part << a_field.ofs;
 }
 
 Value const &NodeBitfield::GetValue(uint32_t a_ret_i)
@@ -90,60 +110,110 @@ void NodeBitfield::Process(uint64_t a_evid)
       std::cerr << "Bitfield signals must have integer type!\n";
       throw std::runtime_error(__func__);
     }
-    it->i = 0;
-    it->vi = 0;
   }
 
   m_value.Clear();
   m_value.SetType(Input::kUint64);
 
-  for (;;) {
-    uint32_t min_i = UINT32_MAX;
-    for (auto it = m_source_vec.begin(); m_source_vec.end() != it; ++it) {
-      // Get min channel.
-      auto const &vmi = it->value->GetID();
-      if (it->i < vmi.size()) {
-        auto mi = vmi[it->i];
-        min_i = std::min(min_i, mi);
+  if (ProcessSameLayout()) {
+    return;
+  }
+
+  m_merge.Clear();
+  for (auto it = m_source_vec.begin(); m_source_vec.end() != it; ++it) {
+    m_merge.Add(it->value);
+  }
+  while (m_merge.Next(&m_run_vec)) {
+    if (1 == m_run_vec.size()) {
+      // Only one source, every hit is a word of its own.
+      auto const &run = m_run_vec.front();
+      auto const &field = m_source_vec[run.src];
+      auto const &vmi = field.value->GetID();
+      auto const &vme = field.value->GetEnd();
+      auto vi = 0 == run.i0 ? 0 : vme[run.i0 - 1];
+      for (auto i = run.i0; i < run.i1; ++i) {
+        for (; vi < vme[i]; ++vi) {
+          Input::Scalar s;
+          s.u64 = GetPart(field, vi);
+          m_value.Push(vmi[i], s);
+        }
       }
+      continue;
     }
-    if (UINT32_MAX == min_i) {
-      break;
-    }
-    uint64_t val = 0;
-    uint32_t ofs = 0;
-    for (auto it = m_source_vec.begin(); m_source_vec.end() != it; ++it,
-        ofs += it->bits) {
-      auto const &vmi = it->value->GetID();
-      if (it->i >= vmi.size()) {
-        continue;
-      }
-      auto mi = vmi[it->i];
-      if (mi != min_i) {
-        continue;
-      }
-      auto me = it->value->GetEnd()[it->i];
-      if (it->vi >= me) {
-        continue;
+    // Word k takes hit k from every source that has it.
+    auto const &run0 = m_run_vec.front();
+    auto mi = m_source_vec[run0.src].value->GetID()[run0.i0];
+    for (uint32_t k = 0;; ++k) {
+      uint64_t val = 0;
+      bool has_hit = false;
+      for (auto it = m_run_vec.begin(); m_run_vec.end() != it; ++it) {
+        auto const &field = m_source_vec[it->src];
+        auto const &vme = field.value->GetEnd();
+        auto vi = (0 == it->i0 ? 0 : vme[it->i0 - 1]) + k;
+        if (vi < vme[it->i0]) {
+          val |= GetPart(field, vi);
+          has_hit = true;
+        }
       }
-      auto const &vv = it->value->GetV();
-      assert(it->vi < vv.size());
-      uint64_t part = vv[it->vi].u64;
-      auto mask = (1ULL << it->bits) - 1;
-      if (part > mask) {
-        std::cerr << it->node->GetLocStr() <<
-            ": Value=" << std::hex << part <<
-            " larger than # bits=" << std::dec << it->bits << "!\n";
-        throw std::runtime_error(__func__);
+      if (!has_hit) {
+        break;
       }
-      val |= part << ofs;
-      ++it->vi;
-      if (it->vi == me) {
-        ++it->i;
+      Input::Scalar s;
+      s.u64 = val;
+      m_value.Push(mi, s);
+    }
+  }
+}
+
+// Usually all sources come from the same module and share channels and
+// multiplicities, then words are packed array-wise with shifts and ORs that
+// the compiler vectorizes, and the range check is a single OR-reduction.
+bool NodeBitfield::ProcessSameLayout()
+{
+  if (m_source_vec.empty()) {
+    return true;
+  }
+  auto const &val0 = *m_source_vec.front().value;
+  auto const &vmi0 = val0.GetID();
+  auto const &vme0 = val0.GetEnd();
+  auto n = vmi0.size();
+  for (auto it = m_source_vec.begin() + 1; m_source_vec.end() != it; ++it) {
+    auto const &vmi = it->value->GetID();
+    auto const &vme = it->value->GetEnd();
+    if (vmi.size() != n ||
+        0 != memcmp(vmi.begin(), vmi0.begin(), n * sizeof *vmi.begin()) ||
+        0 != memcmp(vme.begin(), vme0.begin(), n * sizeof *vme.begin())) {
+      return false;
+    }
+  }
+  if (0 == n) {
+    return true;
+  }
+
+  auto v_num = vme0[n - 1];
+  Input::Scalar zero;
+  zero.u64 = 0;
+  m_word_vec.assign(v_num, zero);
+  auto *w = m_word_vec.data();
+  uint64_t over = 0;
+  for (auto it = m_source_vec.begin(); m_source_vec.end() != it; ++it) {
+    auto const *v = it->value->GetV().begin();
+    auto const inv_mask = ~((1ULL << it->bits) - 1);
+    auto const ofs = it->ofs;
+    for (uint32_t j = 0; j < v_num; ++j) {
+      auto part = v[j].u64;
+      over |= part & inv_mask;
+      w[j].u64 |= part << ofs;
+    }
+  }
+  if (over) {
+    // Find the culprit for the complaint.
+    for (auto it = m_source_vec.begin(); m_source_vec.end() != it; ++it) {
+      for (uint32_t j = 0; j < v_num; ++j) {
+        GetPart(*it, j);
       }
     }
-    Input::Scalar s;
-    s.u64 = val;
-    m_value.Push(min_i, s);
   }
+  m_value.PushLayout(val0, w);
+  return true;
 }
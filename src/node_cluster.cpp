@@ -20,21 +20,61 @@
  * MA  02110-1301  USA
  */
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cmath>
-#include <set>
 #include <iostream>
 #include <map>
 #include <string>
 #include <vector>
 #include <node_cluster.hpp>
 
-NodeCluster::NodeCluster(std::string const &a_loc, NodeValue *a_child):
+// Up to this many clusters insertion sort beats everything else.
+#define CLUSTER_SORT_SMALL 32
+
+namespace {
+
+  // Highest energy first, ties broken on position to stay deterministic.
+  template <typename T> bool ClusterBefore(T const &a_l, T const &a_r)
+  {
+    if (a_l.e != a_r.e) return a_l.e > a_r.e;
+    if (a_l.y != a_r.y) return a_l.y < a_r.y;
+    return a_l.x < a_r.x;
+  }
+
+  template <typename T> void ClusterSort(std::vector<T> *a_vec)
+  {
+    auto &v = *a_vec;
+    if (v.size() > CLUSTER_SORT_SMALL) {
+      std::sort(v.begin(), v.end(), ClusterBefore<T>);
+      return;
+    }
+    for (size_t i = 1; i < v.size(); ++i) {
+      auto c = v[i];
+      auto j = i;
+      for (; j > 0 && ClusterBefore(c, v[j - 1]); --j) {
+        v[j] = v[j - 1];
+      }
+      v[j] = c;
+    }
+  }
+
+}
+
+NodeCluster::NodeCluster(std::string const &a_loc, NodeValue *a_child,
+    uint32_t a_gap, uint32_t a_width):
   NodeValue(a_loc),
   m_child(a_child),
+  m_gap(a_gap),
+  m_width(a_width),
   m_clu(),
-  m_eta()
+  m_eta(),
+  m_cluster_vec(),
+  m_parent_vec(),
+  m_row_vec(),
+  m_row_hit_vec(),
+  m_label_grid()
 {
   m_clu.SetType(Input::kDouble);
   m_eta.SetType(Input::kDouble);
@@ -61,62 +101,181 @@ void NodeCluster::Process(uint64_t a_evid)
   m_eta.Clear();
 
   auto const &val = m_child->GetValue();
-  auto const &miv = val.GetID();
-  auto const &mev = val.GetEnd();
-  auto const &v = val.GetV();
-  if (miv.empty()) {
+  if (val.GetID().empty()) {
     return;
   }
 
-  // Keep temp set so the output gets sorted.
-  struct Entry {
-    double x;
-    double e;
-  };
-  auto cmp = [](Entry const &a_l, Entry const &a_r) {
-    return a_l.e > a_r.e;
-  };
-  std::set<Entry, decltype(cmp)> sorted_set(cmp);
-  uint32_t mi_prev = UINT32_MAX / 2;
-  // The next few will be inited, but not all compilers figure that out.
-  double sum_x = 0.0;
-  double sum_e = 0.0;
+  m_cluster_vec.clear();
+  if (m_width) {
+    Process2D(val);
+  } else {
+    Process1D(val);
+  }
+  ClusterSort(&m_cluster_vec);
+
+  for (auto it = m_cluster_vec.begin(); m_cluster_vec.end() != it; ++it) {
+    auto mi = (uint32_t)it->x;
+    if (m_width) {
+      mi += (uint32_t)it->y * m_width;
+    }
+    Input::Scalar s;
+    s.dbl = it->e;
+    m_clu.Push(mi, s);
+    s.dbl = it->x - floor(it->x);
+    m_eta.Push(mi, s);
+    if (m_width) {
+      s.dbl = it->y - floor(it->y);
+      m_eta.Push(mi, s);
+    }
+  }
+}
+
+void NodeCluster::Process1D(Value const &a_val)
+{
+  auto const &miv = a_val.GetID();
+  auto const &mev = a_val.GetEnd();
+  auto const &v = a_val.GetV();
+
+  Cluster c;
+  c.x = 0.0;
+  c.y = 0.0;
+  c.e = 0.0;
+  uint32_t mi_prev = 0;
   uint32_t v_i = 0;
   for (uint32_t i = 0; i < miv.size(); ++i) {
-    auto mi = miv.at(i);
-    if (mi_prev + 1 != mi) {
-      if (sum_e > 0) {
+    auto mi = miv[i];
+    if (i > 0 && mi - mi_prev > 1 + m_gap) {
+      if (c.e > 0) {
         // Create previous cluster.
-        Entry entry;
-        entry.x = sum_x / sum_e;
-        entry.e = sum_e;
-        sorted_set.insert(entry);
+        c.x /= c.e;
+        m_cluster_vec.push_back(c);
       }
-      sum_x = 0.0;
-      sum_e = 0.0;
+      c.x = 0.0;
+      c.e = 0.0;
     }
     // Keep clusterizing.
-    auto vv = v.at(v_i).GetDouble(val.GetType());
-    sum_x += mi * vv;
-    sum_e += vv;
-    v_i = mev.at(i);
+    auto vv = v[v_i].GetDouble(a_val.GetType());
+    c.x += mi * vv;
+    c.e += vv;
+    v_i = mev[i];
     mi_prev = mi;
   }
-  if (sum_e > 0) {
+  if (c.e > 0) {
     // Create remaining cluster.
-    Entry entry;
-    entry.x = sum_x / sum_e;
-    entry.e = sum_e;
-    sorted_set.insert(entry);
+    c.x /= c.e;
+    m_cluster_vec.push_back(c);
   }
+}
 
-  // Move sorted set to value.
-  for (auto it = sorted_set.begin(); sorted_set.end() != it; ++it) {
-    auto mi = (uint32_t)it->x;
-    Input::Scalar s;
-    s.dbl = it->e;
-    m_clu.Push(mi, s);
-    s.dbl = it->x - floor(it->x);
-    m_eta.Push(mi, s);
+void NodeCluster::Process2D(Value const &a_val)
+{
+  auto const &miv = a_val.GetID();
+  auto const &mev = a_val.GetEnd();
+  auto const &v = a_val.GetV();
+  auto n = (uint32_t)miv.size();
+  auto w = m_width;
+  auto d = 1 + m_gap;
+
+  // Ids are sorted, so rows come in order. Only occupied rows get a line
+  // in the label grid, and only the d + 1 latest are in reach, so the grid
+  // is a ring of at most d + 1 lines no matter how far apart the ids are.
+  m_row_vec.clear();
+  m_row_hit_vec.clear();
+  for (uint32_t i = 0; i < n; ++i) {
+    auto r = miv[i] / w;
+    if (m_row_vec.empty() || m_row_vec.back() != r) {
+      m_row_vec.push_back(r);
+      m_row_hit_vec.push_back(i);
+    }
+  }
+  m_row_hit_vec.push_back(n);
+  size_t ring = std::min(m_row_vec.size(), (size_t)d + 1);
+  if (m_label_grid.size() < ring * w) {
+    m_label_grid.resize(ring * w);
+  }
+  if (m_parent_vec.size() < n) {
+    m_parent_vec.resize(n);
+  }
+
+  // Union-find, only looking back at already labelled pixels.
+  size_t k = 0;
+  for (uint32_t i = 0; i < n; ++i) {
+    auto r = miv[i] / w;
+    auto c = miv[i] % w;
+    while (m_row_vec[k] != r) {
+      ++k;
+      if (k >= ring) {
+        // The line is reused, clear the row that went out of reach.
+        auto k_old = k - ring;
+        for (auto j = m_row_hit_vec[k_old]; j < m_row_hit_vec[k_old + 1];
+            ++j) {
+          m_label_grid[(k % ring) * w + miv[j] % w] = 0;
+        }
+      }
+    }
+    m_parent_vec[i] = i;
+    auto r0 = r > d ? r - d : 0;
+    auto c0 = c > d ? c - d : 0;
+    auto c1 = std::min(c + d, w - 1);
+    // Walk back over the occupied rows within reach.
+    for (auto kk = k + 1; kk > 0 && m_row_vec[kk - 1] >= r0; --kk) {
+      auto row = &m_label_grid[((kk - 1) % ring) * w];
+      auto c_end = kk - 1 == k ? c : c1 + 1;
+      for (auto cc = c0; cc < c_end; ++cc) {
+        auto label = row[cc];
+        if (label) {
+          auto a = Root(i);
+          auto b = Root(label - 1);
+          if (a != b) {
+            // Keep the lowest index as root.
+            m_parent_vec[std::max(a, b)] = std::min(a, b);
+          }
+        }
+      }
+    }
+    m_label_grid[(k % ring) * w + c] = i + 1;
+  }
+
+  // Sum per root, roots come before their members.
+  m_cluster_vec.resize(n);
+  uint32_t v_i = 0;
+  k = 0;
+  for (uint32_t i = 0; i < n; ++i) {
+    while (m_row_vec[k] != miv[i] / w) {
+      ++k;
+    }
+    auto root = Root(i);
+    auto &c = m_cluster_vec[root];
+    if (root == i) {
+      c.x = 0.0;
+      c.y = 0.0;
+      c.e = 0.0;
+    }
+    auto vv = v[v_i].GetDouble(a_val.GetType());
+    c.x += (miv[i] % w) * vv;
+    c.y += (miv[i] / w) * vv;
+    c.e += vv;
+    v_i = mev[i];
+    m_label_grid[(k % ring) * w + miv[i] % w] = 0;
+  }
+  uint32_t j = 0;
+  for (uint32_t i = 0; i < n; ++i) {
+    auto c = m_cluster_vec[i];
+    if (m_parent_vec[i] == i && c.e > 0) {
+      c.x /= c.e;
+      c.y /= c.e;
+      m_cluster_vec[j++] = c;
+    }
+  }
+  m_cluster_vec.resize(j);
+}
+
+uint32_t NodeCluster::Root(uint32_t a_i)
+{
+  while (m_parent_vec[a_i] != a_i) {
+    // Path halving.
+    m_parent_vec[a_i] = m_parent_vec[m_parent_vec[a_i]];
+    a_i = m_parent_vec[a_i];
   }
+  return a_i;
 }
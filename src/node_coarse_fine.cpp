@@ -35,6 +35,8 @@ NodeCoarseFine::NodeCoarseFine(std::string const &a_loc, NodeValue *a_coarse,
   m_fine(a_fine),
   m_fine_range(a_fine_range),
   m_cal_fine(),
+  m_fine_buf(),
+  m_ft_buf(),
   m_value()
 {
 }
@@ -69,16 +71,35 @@ void NodeCoarseFine::Process(uint64_t a_evid)
     NODE_ASSERT(mi, ==, val_f.GetID()[i]);
     auto me = val_c.GetEnd()[i];
     NODE_ASSERT(me, ==, val_f.GetEnd()[i]);
-    for (; vi < me; ++vi) {
-      auto c = (uint32_t)val_c.GetV().at(vi).u64;
-      auto f = (uint32_t)val_f.GetV().at(vi).u64;
-      if (mi >= m_cal_fine.size()) {
-        m_cal_fine.resize(mi + 1);
-      }
-      double ft = m_cal_fine.at(mi).Get(f);
+    // Gather the channel and convert it in one go.
+    m_fine_buf.clear();
+    for (uint32_t j = vi; j < me; ++j) {
+      m_fine_buf.push_back((uint32_t)val_f.GetV()[j].u64);
+    }
+    m_ft_buf.resize(m_fine_buf.size());
+    m_cal_fine.GetMany(mi, m_fine_buf.data(), m_fine_buf.size(),
+        m_ft_buf.data());
+    for (uint32_t j = 0; vi < me; ++vi, ++j) {
+      auto c = (uint32_t)val_c.GetV()[vi].u64;
       Input::Scalar time;
-      time.dbl = m_fine_range * ((c + 1) - ft);
+      time.dbl = m_fine_range * ((c + 1) - m_ft_buf[j]);
       m_value.Push(mi, time);
     }
   }
 }
+
+char const *NodeCoarseFine::StateKind() const
+{
+  return "coarse_fine";
+}
+
+bool NodeCoarseFine::StateLoad(std::vector<uint8_t> const &a_blob)
+{
+  size_t ofs = 0;
+  return m_cal_fine.StateLoad(a_blob, &ofs) && a_blob.size() == ofs;
+}
+
+void NodeCoarseFine::StateSave(std::vector<uint8_t> *a_blob) const
+{
+  m_cal_fine.StateSave(a_blob);
+}
@@ -20,6 +20,7 @@
  * MA  02110-1301  USA
  */
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <iostream>
@@ -32,7 +33,9 @@ NodeFilterRange::NodeFilterRange(std::string const &a_loc, CondVec const
     &a_cond_vec, std::vector<NodeValue *> const &a_src_vec):
   NodeValue(a_loc),
   m_cond_vec(a_cond_vec),
-  m_arg_vec()
+  m_arg_vec(),
+  m_dbl(),
+  m_mask()
 {
   for (auto it = a_src_vec.begin(); a_src_vec.end() != it; ++it) {
     m_arg_vec.push_back(Arg());
@@ -62,42 +65,99 @@ void NodeFilterRange::Process(uint64_t a_evid)
     it->value->SetType(val.GetType());
   }
 
+  if (m_cond_vec.empty()) {
+    return;
+  }
+
+  // Validate layouts once, every condition must cover the channels of the
+  // first one with equal ends.
   auto const &val0 = m_cond_vec.begin()->node->GetValue();
   auto const &miv0 = val0.GetID();
   auto const &mev0 = val0.GetEnd();
-  uint32_t vi = 0;
-  for (uint32_t i = 0; i < miv0.size(); ++i) {
-    auto mi0 = miv0[i];
-    auto me0 = mev0[i];
-    for (; vi < me0; ++vi) {
-      bool ok = true;
-      for (auto it = m_cond_vec.begin(); m_cond_vec.end() != it; ++it) {
-        auto const &val = it->node->GetValue();
-        auto const &miv = val.GetID();
-        auto const &mev = val.GetEnd();
-        auto mi = miv.at(i);
-        auto me = mev.at(i);
-        NODE_ASSERT(mi, ==, mi0);
-        NODE_ASSERT(me, ==, me0);
-        // TODO: This double conversion should work the same for the values
-        // and the limits, but should maybe do this properly?
-        auto dbl = val.GetV(vi, false);
-        ok &= it->lower_le ? it->lower <= dbl : it->lower < dbl;
-        ok &= it->upper_le ? dbl <= it->upper : dbl < it->upper;
+  auto const n0 = (uint32_t)miv0.size();
+  auto const v_num = 0 == n0 ? 0 : mev0[n0 - 1];
+  for (auto it = m_cond_vec.begin(); m_cond_vec.end() != it; ++it) {
+    auto const &val = it->node->GetValue();
+    NODE_ASSERT(val.GetID().size(), >=, n0);
+    for (uint32_t i = 0; i < n0; ++i) {
+      NODE_ASSERT(val.GetID()[i], ==, miv0[i]);
+      NODE_ASSERT(val.GetEnd()[i], ==, mev0[i]);
+    }
+  }
+
+  m_mask.assign(v_num, 1);
+  for (auto it = m_cond_vec.begin(); m_cond_vec.end() != it; ++it) {
+    MaskCond(*it, v_num);
+  }
+
+  for (auto it = m_arg_vec.begin(); m_arg_vec.end() != it; ++it) {
+    auto const &val = it->node->GetValue();
+    auto const &miv = val.GetID();
+    // We _should_ have equal layout, but don't crash if we don't...
+    auto n = std::min(n0, (uint32_t)miv.size());
+    auto const &mev = val.GetEnd();
+    for (uint32_t i = 0; i < n; ++i) {
+      NODE_ASSERT(miv[i], ==, miv0[i]);
+      // The mask is laid out as the conditions, so hits must match too.
+      NODE_ASSERT(mev[i], ==, mev0[i]);
+    }
+    it->value->PushMasked(val, n, m_mask.data());
+  }
+}
+
+void NodeFilterRange::MaskCond(FilterRangeCond const &a_cond, uint32_t
+    a_v_num)
+{
+  // TODO: This double conversion should work the same for the values
+  // and the limits, but should maybe do this properly?
+  auto const &val = a_cond.node->GetValue();
+  m_dbl.resize(a_v_num);
+  auto const *v = val.GetV().begin();
+  switch (val.GetType()) {
+    case Input::kUint64:
+      for (uint32_t j = 0; j < a_v_num; ++j) {
+        m_dbl[j] = (double)v[j].u64;
+      }
+      break;
+    case Input::kInt64:
+      for (uint32_t j = 0; j < a_v_num; ++j) {
+        m_dbl[j] = (double)v[j].i64;
+      }
+      break;
+    case Input::kDouble:
+      for (uint32_t j = 0; j < a_v_num; ++j) {
+        m_dbl[j] = v[j].dbl;
       }
-      if (ok) {
-        for (auto it = m_arg_vec.begin(); m_arg_vec.end() != it; ++it) {
-          auto const &val = it->node->GetValue();
-	  auto const &miv = val.GetID();
-	  // We _should_ have equal layout, but don't crash if we don't...
-	  if (i < miv.size()) {
-            auto mi = miv.at(i);
-            NODE_ASSERT(mi, ==, mi0);
-            auto const &s = val.GetV().at(vi);
-            it->value->Push(mi, s);
-	  }
-        }
+      break;
+    case Input::kNone:
+      if (a_v_num > 0) {
+        throw std::runtime_error(__func__);
       }
+      return;
+  }
+
+  // Branch-free compares over the whole array, the compiler vectorizes
+  // these, with the inclusiveness picked outside the loops.
+  auto const *d = m_dbl.data();
+  auto *m = m_mask.data();
+  auto const lower = a_cond.lower;
+  auto const upper = a_cond.upper;
+  if (a_cond.lower_le) {
+    for (uint32_t j = 0; j < a_v_num; ++j) {
+      m[j] &= (uint8_t)(lower <= d[j]);
+    }
+  } else {
+    for (uint32_t j = 0; j < a_v_num; ++j) {
+      m[j] &= (uint8_t)(lower < d[j]);
+    }
+  }
+  if (a_cond.upper_le) {
+    for (uint32_t j = 0; j < a_v_num; ++j) {
+      m[j] &= (uint8_t)(d[j] <= upper);
+    }
+  } else {
+    for (uint32_t j = 0; j < a_v_num; ++j) {
+      m[j] &= (uint8_t)(d[j] < upper);
     }
   }
 }
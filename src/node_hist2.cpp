@@ -106,6 +106,17 @@ void NodeHist2::Process(uint64_t a_evid)
 
     auto size_min = std::min(vec_x.size(), vec_y.size());
 
+    if (m_permutate && m_cut_producer.IsEmpty() && !g_output) {
+      // Nobody needs to see individual pairs, fill the outer product of the
+      // per-axis bin counts.
+      m_visual_hist2.PrefillOuter(val_x.GetType(), vec_x, val_y.GetType(),
+          vec_y);
+      m_visual_hist2.Fit();
+      m_visual_hist2.FillOuter(val_x.GetType(), vec_x, val_y.GetType(),
+          vec_y);
+      return;
+    }
+
     // Pre-fill.
     if (m_permutate) {
       for (auto ity = vec_y.begin(); vec_y.end() != ity; ++ity) {
@@ -134,7 +145,7 @@ void NodeHist2::Process(uint64_t a_evid)
         for (uint32_t j = 0; j < vec_x.size(); ++j) {
           auto const &x = vec_x.at(j);
           if (g_output) {
-            g_output->Fill(m_out_x, val_x.GetV(i, true));
+            g_output->Fill(m_out_x, val_x.GetV(j, true));
             g_output->Fill(m_out_y, val_y.GetV(i, true));
           }
           m_visual_hist2.Fill(val_x.GetType(), x, val_y.GetType(), y);
@@ -26,6 +26,7 @@
 #include <map>
 #include <string>
 #include <vector>
+#include <channel.hpp>
 #include <node_match_id.hpp>
 
 NodeMatchId::NodeMatchId(std::string const &a_loc, NodeValue *a_l,
@@ -34,7 +35,8 @@ NodeMatchId::NodeMatchId(std::string const &a_loc, NodeValue *a_l,
   m_node_l(a_l),
   m_node_r(a_r),
   m_val_l(),
-  m_val_r()
+  m_val_r(),
+  m_pair_vec()
 {
 }
 
@@ -64,28 +66,9 @@ void NodeMatchId::Process(uint64_t a_evid)
   m_val_l.SetType(val_l.GetType());
   m_val_r.SetType(val_r.GetType());
 
-  uint32_t i_l = 0;
-  uint32_t i_r = 0;
-  while (i_l < val_l.GetID().size() && i_r < val_r.GetID().size()) {
-    auto mi_l = val_l.GetID()[i_l];
-    auto mi_r = val_r.GetID()[i_r];
-    if (mi_l < mi_r) {
-      ++i_l;
-    } else if (mi_l > mi_r) {
-      ++i_r;
-    } else {
-#define MATCH_INDEX_PUSH(sub) do {\
-      auto me_0 = 0 == i_##sub ? 0 : val_##sub.GetEnd().at(i_##sub - 1);\
-      auto me_1 = val_##sub.GetEnd().at(i_##sub);\
-      for (; me_0 < me_1; ++me_0) {\
-        m_val_##sub.Push(mi_##sub, val_##sub.GetV()[me_0]);\
-      }\
-    } while (0)
-      MATCH_INDEX_PUSH(l);
-      MATCH_INDEX_PUSH(r);
-
-      ++i_l;
-      ++i_r;
-    }
+  ChannelIntersect(val_l, val_r, &m_pair_vec);
+  for (auto it = m_pair_vec.begin(); m_pair_vec.end() != it; ++it) {
+    m_val_l.PushChannels(val_l, it->l, it->l + 1);
+    m_val_r.PushChannels(val_r, it->r, it->r + 1);
   }
 }
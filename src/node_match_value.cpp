@@ -35,7 +35,8 @@ NodeMatchValue::NodeMatchValue(std::string const &a_loc, NodeValue *a_l,
   m_node_r(a_r),
   m_cutoff(a_cutoff),
   m_val_l(),
-  m_val_r()
+  m_val_r(),
+  m_pair_vec()
 {
 }
 
@@ -65,58 +66,50 @@ void NodeMatchValue::Process(uint64_t a_evid)
   m_val_l.SetType(val_l.GetType());
   m_val_r.SetType(val_r.GetType());
 
-  uint32_t i_l = 0;
-  uint32_t i_r = 0;
-  while (i_l < val_l.GetID().size() && i_r < val_r.GetID().size()) {
+  ChannelIntersect(val_l, val_r, &m_pair_vec);
+  for (auto it = m_pair_vec.begin(); m_pair_vec.end() != it; ++it) {
+    auto i_l = it->l;
+    auto i_r = it->r;
     auto mi_l = val_l.GetID()[i_l];
     auto mi_r = val_r.GetID()[i_r];
-    if (mi_l < mi_r) {
-      ++i_l;
-    } else if (mi_l > mi_r) {
-      ++i_r;
-    } else {
 
-      auto me_l0 = 0 == i_l ? 0 : val_l.GetEnd().at(i_l - 1);
-      auto me_l1 = val_l.GetEnd().at(i_l);
+    auto me_l0 = 0 == i_l ? 0 : val_l.GetEnd().at(i_l - 1);
+    auto me_l1 = val_l.GetEnd().at(i_l);
 
-      auto me_r0 = 0 == i_r ? 0 : val_r.GetEnd().at(i_r - 1);
-      auto me_r1 = val_r.GetEnd().at(i_r);
+    auto me_r0 = 0 == i_r ? 0 : val_r.GetEnd().at(i_r - 1);
+    auto me_r1 = val_r.GetEnd().at(i_r);
 
-      while (me_l0 < me_l1 && me_r0 < me_r1) {
-        auto v_l = val_l.GetV()[me_l0];
-        auto v_r = val_r.GetV()[me_r0];
+    while (me_l0 < me_l1 && me_r0 < me_r1) {
+      auto v_l = val_l.GetV()[me_l0];
+      auto v_r = val_r.GetV()[me_r0];
 
-        auto d = std::abs(v_r.dbl - v_l.dbl);
-        if (d < m_cutoff) {
-          // Match!
-          m_val_l.Push(mi_l, v_l);
-          m_val_r.Push(mi_r, v_r);
-          ++me_l0;
+      auto d = std::abs(v_r.dbl - v_l.dbl);
+      if (d < m_cutoff) {
+        // Match!
+        m_val_l.Push(mi_l, v_l);
+        m_val_r.Push(mi_r, v_r);
+        ++me_l0;
+        ++me_r0;
+      } else {
+        if (me_l0 + 1 == me_l1) {
           ++me_r0;
+        } else if (me_r0 + 1 == me_r1) {
+          ++me_l0;
         } else {
-          if (me_l0 + 1 == me_l1) {
-            ++me_r0;
-          } else if (me_r0 + 1 == me_r1) {
+          // Let's assume values come in sorted order, but we don't know the
+          // direction! (Eg. vftx2 and tamex3 are opposite.) So, peek at the
+          // next value and see which gets closer.
+          auto vn_l = val_l.GetV()[me_l0 + 1];
+          auto vn_r = val_r.GetV()[me_r0 + 1];
+          auto dl = std::abs(vn_l.dbl - v_r.dbl);
+          auto dr = std::abs(vn_r.dbl - v_l.dbl);
+          if (dl < dr) {
             ++me_l0;
           } else {
-            // Let's assume values come in sorted order, but we don't know the
-            // direction! (Eg. vftx2 and tamex3 are opposite.) So, peek at the
-            // next value and see which gets closer.
-            auto vn_l = val_l.GetV()[me_l0 + 1];
-            auto vn_r = val_r.GetV()[me_r0 + 1];
-            auto dl = std::abs(vn_l.dbl - v_r.dbl);
-            auto dr = std::abs(vn_r.dbl - v_l.dbl);
-            if (dl < dr) {
-              ++me_l0;
-            } else {
-              ++me_r0;
-            }
+            ++me_r0;
           }
         }
       }
-
-      ++i_l;
-      ++i_r;
     }
   }
 }
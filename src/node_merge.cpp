@@ -36,24 +36,22 @@ MergeArg::MergeArg(std::string const &a_loc, NodeValue *a_node):
 
 NodeMerge::Field::Field():
   node(),
-  value(),
-  i(),
-  vi()
+  value()
 {
 }
 
 NodeMerge::Field::Field(NodeValue *a_node):
   node(a_node),
-  value(),
-  i(),
-  vi()
+  value()
 {
 }
 
 NodeMerge::NodeMerge(std::string const &a_loc, MergeArg *a_arg_list):
   NodeValue(a_loc),
   m_source_vec(),
-  m_value()
+  m_value(),
+  m_merge(),
+  m_run_vec()
 {
   // The parser built the arg list in reverse order!
   unsigned n = 0;
@@ -89,8 +87,6 @@ void NodeMerge::Process(uint64_t a_evid)
       throw std::runtime_error(__func__);
     }
     type = it_type;
-    it->i = 0;
-    it->vi = 0;
   }
 
   m_value.Clear();
@@ -99,34 +95,13 @@ void NodeMerge::Process(uint64_t a_evid)
   }
   m_value.SetType(type);
 
-  for (;;) {
-    uint32_t min_i = UINT32_MAX;
-    for (auto it = m_source_vec.begin(); m_source_vec.end() != it; ++it) {
-      // Get min channel.
-      auto const &vmi = it->value->GetID();
-      if (it->i < vmi.size()) {
-        auto mi = vmi[it->i];
-        min_i = std::min(min_i, mi);
-      }
-    }
-    if (UINT32_MAX == min_i) {
-      break;
-    }
-    for (auto it = m_source_vec.begin(); m_source_vec.end() != it; ++it) {
-      auto const &vmi = it->value->GetID();
-      if (it->i >= vmi.size()) {
-        continue;
-      }
-      auto mi = vmi[it->i];
-      if (mi != min_i) {
-        continue;
-      }
-      auto me = it->value->GetEnd()[it->i];
-      auto const &vv = it->value->GetV();
-      for (; it->vi < me; ++it->vi) {
-        m_value.Push(mi, vv[it->vi]);
-      }
-      ++it->i;
+  m_merge.Clear();
+  for (auto it = m_source_vec.begin(); m_source_vec.end() != it; ++it) {
+    m_merge.Add(it->value);
+  }
+  while (m_merge.Next(&m_run_vec)) {
+    for (auto it = m_run_vec.begin(); m_run_vec.end() != it; ++it) {
+      m_value.PushChannels(*m_source_vec[it->src].value, it->i0, it->i1);
     }
   }
 }
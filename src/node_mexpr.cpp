@@ -37,7 +37,8 @@ NodeMExpr::NodeMExpr(std::string const &a_loc, NodeValue *a_l, NodeValue *a_r,
   m_d(a_d),
   m_mix(),
   m_op(a_op),
-  m_value()
+  m_value(),
+  m_pair_vec()
 {
   if (a_l && a_r) {
     m_mix = 0;
@@ -79,8 +80,13 @@ void NodeMExpr::Process(uint64_t a_evid)
   m_value.Clear();
   m_value.SetType(Input::kDouble);
 
+  if (0 == m_mix) {
+    ChannelIntersect(*val_l, *val_r, &m_pair_vec);
+  }
+
   uint32_t i_l = 0;
   uint32_t i_r = 0;
+  size_t pair_i = 0;
   for (;;) {
     uint32_t mi;
     uint32_t me_l = 0;
@@ -88,20 +94,13 @@ void NodeMExpr::Process(uint64_t a_evid)
     uint32_t vi_l = 0;
     uint32_t vi_r = 0;
     if (0 == m_mix) {
-      if (i_l >= val_l->GetID().size() ||
-          i_r >= val_r->GetID().size()) {
+      if (pair_i >= m_pair_vec.size()) {
         break;
       }
-      auto mi_l = val_l->GetID()[i_l];
-      auto mi_r = val_r->GetID()[i_r];
-      if (mi_l < mi_r) {
-        ++i_l;
-        continue;
-      } else if (mi_r < mi_l) {
-        ++i_r;
-        continue;
-      }
-      mi = mi_l;
+      i_l = m_pair_vec[pair_i].l;
+      i_r = m_pair_vec[pair_i].r;
+      ++pair_i;
+      mi = val_l->GetID()[i_l];
       me_l = val_l->GetEnd()[i_l];
       me_r = val_r->GetEnd()[i_r];
       vi_l = 0 == i_l ? 0 : val_l->GetEnd()[i_l - 1];
@@ -28,42 +28,15 @@
 #include <string>
 #include <vector>
 #include <util.hpp>
+#include <checkpoint.hpp>
 #include <node_tpat.hpp>
 #include <node_pedestal.hpp>
 
 #define STATS_MAX 10000
-
-void NodePedestal::StatPage::Add(double a_v)
-{
-  // Welford's online algorithm.
-  ++num;
-  auto delta = a_v - mean;
-  mean += delta / num;
-  auto delta2 = a_v - mean;
-  M2 += delta * delta2;
-  // We can spend some time in here, because we should be collecting
-  // pedestals off-spill or on special triggers where less happens in
-  // other detectors.
-  if (num > 1) {
-    var = M2 / (num - 1);
-  }
-}
-
-void NodePedestal::Stats::Get(double *a_mean, double *a_var)
-{
-  uint32_t num = 0;
-  double mean_sum = 0.0;
-  double var_sum = 0.0;
-  for (size_t j = 0; j < LENGTH(page); ++j) {
-    auto const &p = page[j];
-    num += p.num > 0;
-    mean_sum += p.mean;
-    var_sum += p.var;
-  }
-  num += 0 == num;
-  *a_mean = mean_sum / num;
-  *a_var = var_sum / num;
-}
+// Cached mean/sigma are refreshed after this many adds to a channel, or
+// for every add while the write page is young, or on a timer.
+#define REFRESH_NUM 100
+#define REFRESH_MS 1000
 
 NodePedestal::NodePedestal(std::string const &a_loc, NodeValue *a_child,
     double a_cutoff, NodeValue *a_tpat):
@@ -73,7 +46,15 @@ NodePedestal::NodePedestal(std::string const &a_loc, NodeValue *a_child,
   m_tpat(a_tpat),
   m_value(),
   m_sigma(),
-  m_stats()
+  m_page_num(),
+  m_page_mean(),
+  m_page_M2(),
+  m_write_i(),
+  m_mean(),
+  m_std(),
+  m_stale(),
+  m_refresh_ms(Time_get_ms()),
+  m_dbl()
 {
   m_value.SetType(Input::kDouble);
   m_sigma.SetType(Input::kDouble);
@@ -115,46 +96,181 @@ void NodePedestal::Process(uint64_t a_evid)
     // Try to size stats by looking at the last index.
     StatsFit(vmi.back());
   }
+
+  // Convert all values once, with the type switch outside the loops.
+  auto const v_num = vmi.empty() ? 0 : vme[vmi.size() - 1];
+  m_dbl.resize(v_num);
+  auto const *v = val.GetV().begin();
+  switch (val.GetType()) {
+    case Input::kUint64:
+      for (uint32_t j = 0; j < v_num; ++j) {
+        m_dbl[j] = (double)(int64_t)v[j].u64;
+      }
+      break;
+    case Input::kInt64:
+      for (uint32_t j = 0; j < v_num; ++j) {
+        m_dbl[j] = (double)v[j].i64;
+      }
+      break;
+    case Input::kDouble:
+      for (uint32_t j = 0; j < v_num; ++j) {
+        m_dbl[j] = v[j].dbl;
+      }
+      break;
+    case Input::kNone:
+      if (v_num > 0) {
+        throw std::runtime_error(__func__);
+      }
+      break;
+  }
+  auto const *d = m_dbl.data();
+
   uint32_t v_i = 0;
   for (uint32_t i = 0; i < vmi.size(); ++i) {
     auto const mi = vmi[i];
     auto const me = vme[i];
     StatsFit(mi);
-    auto &s = m_stats.at(mi);
-    auto &s_write = s.page[s.write_i];
-    for (; v_i < me; ++v_i) {
-      auto v = val.GetV(v_i, true);
-      if (do_accounting) {
-        s_write.Add(v);
+    if (do_accounting) {
+      for (uint32_t j = v_i; j < me; ++j) {
+        StatsAdd(mi, d[j]);
       }
-      double mean, var;
-      s.Get(&mean, &var);
-      if (var > 0) {
-        Input::Scalar scl;
-        auto std = sqrt(var);
-        auto e = v - mean;
-        if (e > m_cutoff * std) {
+    }
+    // One pass with constant mean and threshold over the channel.
+    auto const mean = m_mean[mi];
+    auto const std = m_std[mi];
+    if (std > 0) {
+      auto const thr = m_cutoff * std;
+      Input::Scalar scl_std;
+      scl_std.dbl = std;
+      for (; v_i < me; ++v_i) {
+        auto e = d[v_i] - mean;
+        if (e > thr) {
+          Input::Scalar scl;
           scl.dbl = e;
           m_value.Push(mi, scl);
         }
-        scl.dbl = std;
-        m_sigma.Push(mi, scl);
+        m_sigma.Push(mi, scl_std);
       }
     }
-    if (STATS_MAX <= s_write.num) {
-      s.write_i ^= 1;
-      auto &s_new = s.page[s.write_i];
-      s_new.num = 0;
-      s_new.mean = 0.0;
-      s_new.M2 = 0.0;
-      s_new.var = 0.0;
+    v_i = me;
+  }
+
+  if (do_accounting) {
+    auto t = Time_get_ms();
+    if (t > m_refresh_ms + REFRESH_MS) {
+      for (uint32_t ch = 0; ch < m_stale.size(); ++ch) {
+        if (m_stale[ch]) {
+          StatsRefresh(ch);
+        }
+      }
+      m_refresh_ms = t;
     }
   }
 }
 
+char const *NodePedestal::StateKind() const
+{
+  return "pedestal";
+}
+
+bool NodePedestal::StateLoad(std::vector<uint8_t> const &a_blob)
+{
+  size_t ofs = 0;
+  std::vector<uint32_t> page_num;
+  std::vector<double> page_mean;
+  std::vector<double> page_M2;
+  std::vector<uint8_t> write_i;
+  if (!StateGetVec(a_blob, &ofs, &page_num) ||
+      !StateGetVec(a_blob, &ofs, &page_mean) ||
+      !StateGetVec(a_blob, &ofs, &page_M2) ||
+      !StateGetVec(a_blob, &ofs, &write_i) ||
+      a_blob.size() != ofs) {
+    return false;
+  }
+  auto n = write_i.size();
+  if (page_num.size() != 2 * n ||
+      page_mean.size() != 2 * n ||
+      page_M2.size() != 2 * n) {
+    return false;
+  }
+  for (auto it = write_i.begin(); write_i.end() != it; ++it) {
+    if (*it > 1) {
+      return false;
+    }
+  }
+  m_page_num.swap(page_num);
+  m_page_mean.swap(page_mean);
+  m_page_M2.swap(page_M2);
+  m_write_i.swap(write_i);
+  m_mean.assign(n, 0.0);
+  m_std.assign(n, 0.0);
+  m_stale.assign(n, 0);
+  for (uint32_t ch = 0; ch < n; ++ch) {
+    StatsRefresh(ch);
+  }
+  return true;
+}
+
+void NodePedestal::StateSave(std::vector<uint8_t> *a_blob) const
+{
+  StatePutVec(a_blob, m_page_num);
+  StatePutVec(a_blob, m_page_mean);
+  StatePutVec(a_blob, m_page_M2);
+  StatePutVec(a_blob, m_write_i);
+}
+
+void NodePedestal::StatsAdd(uint32_t a_mi, double a_v)
+{
+  // Welford's online algorithm.
+  auto const w = 2 * a_mi + m_write_i[a_mi];
+  auto num = ++m_page_num[w];
+  auto delta = a_v - m_page_mean[w];
+  m_page_mean[w] += delta / num;
+  auto delta2 = a_v - m_page_mean[w];
+  m_page_M2[w] += delta * delta2;
+  ++m_stale[a_mi];
+  if (STATS_MAX <= num) {
+    // Swap pages, the reset page starts young and refreshes often.
+    StatsRefresh(a_mi);
+    m_write_i[a_mi] ^= 1;
+    auto const w_new = 2 * a_mi + m_write_i[a_mi];
+    m_page_num[w_new] = 0;
+    m_page_mean[w_new] = 0.0;
+    m_page_M2[w_new] = 0.0;
+  } else if (num <= REFRESH_NUM || REFRESH_NUM <= m_stale[a_mi]) {
+    StatsRefresh(a_mi);
+  }
+}
+
 void NodePedestal::StatsFit(uint32_t a_mi)
 {
-  if (a_mi >= m_stats.size()) {
-    m_stats.resize(a_mi + 1);
+  if (a_mi >= m_stale.size()) {
+    size_t n = a_mi + 1;
+    m_page_num.resize(2 * n);
+    m_page_mean.resize(2 * n);
+    m_page_M2.resize(2 * n);
+    m_write_i.resize(n);
+    m_mean.resize(n);
+    m_std.resize(n);
+    m_stale.resize(n);
   }
 }
+
+void NodePedestal::StatsRefresh(uint32_t a_mi)
+{
+  uint32_t num = 0;
+  double mean_sum = 0.0;
+  double var_sum = 0.0;
+  for (uint32_t j = 2 * a_mi; j < 2 * a_mi + 2; ++j) {
+    auto const n = m_page_num[j];
+    num += n > 0;
+    mean_sum += m_page_mean[j];
+    if (n > 1) {
+      var_sum += m_page_M2[j] / (n - 1);
+    }
+  }
+  num += 0 == num;
+  m_mean[a_mi] = mean_sum / num;
+  m_std[a_mi] = sqrt(var_sum / num);
+  m_stale[a_mi] = 0;
+}
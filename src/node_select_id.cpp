@@ -26,6 +26,7 @@
 #include <map>
 #include <string>
 #include <vector>
+#include <channel.hpp>
 #include <node_select_id.hpp>
 
 NodeSelectId::NodeSelectId(std::string const &a_loc, NodeValue *a_child,
@@ -55,18 +56,7 @@ void NodeSelectId::Process(uint64_t a_evid)
   auto const &val = m_child->GetValue();
   m_value.SetType(val.GetType());
 
-  auto const &vmi = val.GetID();
-  auto const &vme = val.GetEnd();
-  auto const &vv = val.GetV();
-
-  for (uint32_t i = 0; i < vmi.size(); ++i) {
-    auto mi = vmi[i];
-    if (m_first <= mi && mi <= m_last) {
-      auto me_0 = 0 == i ? 0 : vme[i - 1];
-      auto me_1 = vme[i];
-      for (; me_0 < me_1; ++me_0) {
-        m_value.Push(mi, vv[me_0]);
-      }
-    }
-  }
+  uint32_t i0, i1;
+  ChannelRange(val, m_first, m_last, &i0, &i1);
+  m_value.PushChannels(val, i0, i1);
 }
@@ -21,6 +21,7 @@
  * MA  02110-1301  USA
  */
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
@@ -41,7 +42,10 @@ NodeSignal::NodeSignal(Config &a_config, std::string const &a_name):
   m_value(),
   m_id(),
   m_end(),
-  m_v()
+  m_v(),
+  m_mult_max(UINT32_MAX),
+  m_mult_skip(),
+  m_mult_over_num()
 {
 }
 
@@ -91,6 +95,17 @@ Value const &NodeSignal::GetValue(uint32_t a_ret_i)
   return m_value;
 }
 
+uint64_t NodeSignal::MultOverGet() const
+{
+  return m_mult_over_num;
+}
+
+void NodeSignal::MultMaxSet(uint32_t a_max, bool a_skip)
+{
+  m_mult_max = a_max;
+  m_mult_skip = a_skip;
+}
+
 void NodeSignal::Process(uint64_t a_evid)
 {
   m_value.Clear();
@@ -110,6 +125,20 @@ void NodeSignal::Process(uint64_t a_evid)
     return; \
   } \
 } while (0)
+#define SIGNAL_MULT_GUARD(mult) \
+  auto mult_lim = (uint32_t)(mult); \
+  if (mult_lim > m_mult_max) { \
+    ++m_mult_over_num; \
+    m_config->MultOver(); \
+    if (0 == (m_mult_over_num & (m_mult_over_num - 1))) { \
+      std::cerr << GetLocStr() << ':' << m_name << ": Multiplicity " << \
+          mult_lim << " > " << m_mult_max << ", " << \
+          (m_mult_skip ? "skipped" : "truncated") << " (" << \
+          m_mult_over_num << " events).\n"; \
+    } \
+    if (m_mult_skip) return; \
+    mult_lim = m_mult_max; \
+  }
 #define IF_VALUE_NOP(v)
 #define IF_VALUE_INVALID(v) if (!std::isnan(v.dbl) && !std::isinf(v.dbl))
   if (m_end) {
@@ -119,6 +148,7 @@ void NodeSignal::Process(uint64_t a_evid)
     FETCH_SIGNAL_DATA(v);
     SIGNAL_LEN_CHECK(len_id, ==, len_end);
     SIGNAL_LEN_CHECK(len_id, <=, len_v);
+    SIGNAL_MULT_GUARD(0 == len_id ? 0 : (uint32_t)p_end[len_id - 1].u64);
     m_value.SetType(m_v->type);
     uint32_t v_i = 0;
     switch (m_v->type) {
@@ -126,7 +156,7 @@ void NodeSignal::Process(uint64_t a_evid)
       case Input::input_type: \
         for (uint32_t i_ = 0; i_ < len_id; ++i_) { \
           auto id = (uint32_t)p_id[i_].u64; \
-          auto end = (uint32_t)p_end[i_].u64; \
+          auto end = std::min((uint32_t)p_end[i_].u64, mult_lim); \
           for (; v_i < end; ++v_i) { \
             auto v_ = p_v[v_i]; \
             IF_VALUE_##kind(v_) { \
@@ -147,11 +177,12 @@ void NodeSignal::Process(uint64_t a_evid)
     FETCH_SIGNAL_DATA(id);
     FETCH_SIGNAL_DATA(v);
     SIGNAL_LEN_CHECK(len_id, ==, len_v);
+    SIGNAL_MULT_GUARD(len_id);
     m_value.SetType(m_v->type);
     switch (m_v->type) {
 #define COPY_S_HIT(input_type, kind) \
     case Input::input_type: \
-      for (uint32_t i_ = 0; i_ < len_id; ++i_) { \
+      for (uint32_t i_ = 0; i_ < mult_lim; ++i_) { \
         auto mi = (uint32_t)p_id[i_].u64; \
         auto v_ = p_v[i_]; \
         IF_VALUE_##kind(v_) { \
@@ -169,11 +200,12 @@ void NodeSignal::Process(uint64_t a_evid)
   } else if (m_v) {
     // Scalar or simple array.
     FETCH_SIGNAL_DATA(v);
+    SIGNAL_MULT_GUARD(len_v);
     m_value.SetType(m_v->type);
     switch (m_v->type) {
 #define COPY_SCALAR(input_type, kind) \
       case Input::input_type: \
-        for (uint32_t i_ = 0; i_ < len_v; ++i_) { \
+        for (uint32_t i_ = 0; i_ < mult_lim; ++i_) { \
           auto v_ = p_v[i_]; \
           IF_VALUE_##kind(v_) { \
             m_value.Push(0, v_); \
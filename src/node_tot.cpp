@@ -35,7 +35,8 @@ NodeTot::NodeTot(std::string const &a_loc, NodeValue *a_l, NodeValue *a_t,
   m_l(a_l),
   m_t(a_t),
   m_range(a_range),
-  m_value()
+  m_value(),
+  m_pair_vec()
 {
 }
 
@@ -58,38 +59,26 @@ void NodeTot::Process(uint64_t a_evid)
   NODE_ASSERT(val_l.GetType(), ==, val_t.GetType());
   m_value.SetType(Input::kDouble);
 
-  uint32_t i_l = 0;
-  uint32_t i_t = 0;
-  uint32_t vi_l = 0;
-  uint32_t vi_t = 0;
-  while (i_l < val_l.GetID().size() && i_t < val_t.GetID().size()) {
+  ChannelIntersect(val_l, val_t, &m_pair_vec);
+  for (auto it = m_pair_vec.begin(); m_pair_vec.end() != it; ++it) {
+    auto i_l = it->l;
+    auto i_t = it->r;
     auto mi_l = val_l.GetID()[i_l];
-    auto mi_t = val_t.GetID()[i_t];
+    auto vi_l = 0 == i_l ? 0 : val_l.GetEnd()[i_l - 1];
+    auto vi_t = 0 == i_t ? 0 : val_t.GetEnd()[i_t - 1];
     auto me_l = val_l.GetEnd()[i_l];
     auto me_t = val_t.GetEnd()[i_t];
-    if (mi_l < mi_t) {
-      ++i_l;
-      vi_l = me_l;
-    } else if (mi_l > mi_t) {
-      ++i_t;
-      vi_t = me_t;
-    } else {
-      while (vi_l < me_l && vi_t < me_t) {
-        double l = val_l.GetV(vi_l, false);
-        double t = val_t.GetV(vi_t, false);
-        double d = SubModDbl(t, l, m_range);
-        if (d > 0) {
-          Input::Scalar diff;
-          diff.dbl = d;
-          m_value.Push(mi_l, diff);
-          ++vi_l;
-        }
-        ++vi_t;
+    while (vi_l < me_l && vi_t < me_t) {
+      double l = val_l.GetV(vi_l, false);
+      double t = val_t.GetV(vi_t, false);
+      double d = SubModDbl(t, l, m_range);
+      if (d > 0) {
+        Input::Scalar diff;
+        diff.dbl = d;
+        m_value.Push(mi_l, diff);
+        ++vi_l;
       }
-      ++i_l;
-      ++i_t;
-      vi_l = me_l;
-      vi_t = me_t;
+      ++vi_t;
     }
   }
 }
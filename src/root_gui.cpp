@@ -22,9 +22,11 @@
 
 #if PLUTT_ROOT_HTTP
 
+#include <algorithm>
 #include <iostream>
 #include <list>
 #include <sstream>
+#include <vector>
 #include <cmath>
 
 #include <TCanvas.h>
@@ -38,6 +40,7 @@
 #include <TText.h>
 
 #include <root_gui.hpp>
+#include <tiled_counts.hpp>
 #include <util.hpp>
 
 class RootGui::Bind: public TNamed
@@ -54,6 +57,7 @@ class RootGui::Bind: public TNamed
     }
     void SetDrawOption(Option_t *) {
       m_plot_wrap->is_log ^= true;
+      m_plot_wrap->do_draw = true;
     }
 
   private:
@@ -90,9 +94,13 @@ RootGui::PlotWrap::PlotWrap():
   h1(),
   h2(),
   poly(),
+  bg_gr(),
   gr_vec(),
   tx_vec(),
+  version(),
   do_clear(),
+  // Draw once even if never filled, to get empty axes.
+  do_draw(true),
   is_log_set(),
   is_log()
 {
@@ -209,8 +217,12 @@ bool RootGui::DoClear(uint32_t a_id)
 
 bool RootGui::Draw(double a_event_rate)
 {
-  std::cout << "\rEvent-rate: " << a_event_rate << "              " <<
-      std::flush;
+  std::cout << "\rEvent-rate: " << a_event_rate;
+  auto pathological = Pathological_get();
+  if (pathological) {
+    std::cout << "  Pathological: " << pathological;
+  }
+  std::cout << "              " << std::flush;
   for (auto it = m_page_vec.begin(); m_page_vec.end() != it; ++it) {
     auto page = *it;
     auto &vec = page->plot_wrap_vec;
@@ -224,13 +236,27 @@ bool RootGui::Draw(double a_event_rate)
     int i = 1;
     for (auto it2 = vec.begin(); vec.end() != it2; ++it2) {
       auto plot_wrap = *it2;
-      page->canvas->cd(i++);
+      auto pad_i = i++;
+      auto version = plot_wrap->plot->GetVersion();
+      if (!plot_wrap->do_draw && plot_wrap->version == version) {
+        // The ROOT objects already hold the latest latch.
+        continue;
+      }
+      plot_wrap->version = version;
+      plot_wrap->do_draw = false;
+      page->canvas->cd(pad_i);
       plot_wrap->plot->Draw(this);
     }
   }
   return !gSystem->ProcessEvents();
 }
 
+Gui::Visibility RootGui::GetVisibility(uint32_t)
+{
+  // No idea what the web clients are looking at.
+  return kUnknown;
+}
+
 void RootGui::DrawAnnular(uint32_t a_id, Axis const &a_axis_r, double a_r_min,
     double a_r_max, Axis const &a_axis_p, double a_phi0, bool a_is_log_z,
     std::vector<uint32_t> const &a_v)
@@ -305,7 +331,8 @@ void RootGui::DrawAnnular(uint32_t a_id, Axis const &a_axis_r, double a_r_min,
 // TODO: Use axis transform.
 void RootGui::DrawHist1(uint32_t a_id, Axis const &a_axis, LinearTransform
     const &a_transform, bool a_is_log_y, bool a_is_contour,
-    std::vector<uint32_t> const &a_v, std::vector<Peak> const &a_peak_vec)
+    std::vector<uint32_t> const &a_v, Hist1Pyramid const &,
+    std::vector<Peak> const &a_peak_vec, std::vector<float> const &a_bg_vec)
 {
   auto page_i = a_id >> 16;
   auto plot_i = a_id & 0xffff;
@@ -339,6 +366,18 @@ void RootGui::DrawHist1(uint32_t a_id, Axis const &a_axis, LinearTransform
   }
   plot->h1->ResetStats();
 
+  // Background graph.
+  if (!a_bg_vec.empty() && a_bg_vec.size() == a_axis.bins) {
+    auto &gr = plot->bg_gr;
+    gr.Set((int)a_bg_vec.size());
+    gr.SetLineColor(kBlue);
+    auto scale = (a_axis.max - a_axis.min) / a_axis.bins;
+    for (int i = 0; i < gr.GetN(); ++i) {
+      gr.SetPoint(i, a_axis.min + (i + 0.5) * scale, a_bg_vec.at((size_t)i));
+    }
+    gr.Draw("L");
+  }
+
   // Fit-peak graph.
   plot->gr_vec.resize(a_peak_vec.size());
   plot->tx_vec.resize(a_peak_vec.size());
@@ -383,7 +422,7 @@ void RootGui::DrawHist1(uint32_t a_id, Axis const &a_axis, LinearTransform
 // TODO: Use axis transform.
 void RootGui::DrawHist2(uint32_t a_id, Axis const &a_axis_x, Axis const
     &a_axis_y, LinearTransform const &a_tranform_x, LinearTransform const
-    &a_transform_y, bool a_is_log_z, std::vector<uint32_t> const &a_v)
+    &a_transform_y, bool a_is_log_z, TiledCounts const &a_hist)
 {
   auto page_i = a_id >> 16;
   auto plot_i = a_id & 0xffff;
@@ -417,10 +456,28 @@ void RootGui::DrawHist2(uint32_t a_id, Axis const &a_axis_x, Axis const
         (int)a_axis_y.bins, a_axis_y.min, a_axis_y.max);
     plot->h2->Draw("colz");
   }
-  size_t k = 0;
-  for (size_t i = 0; i < a_axis_y.bins; ++i) {
-    for (size_t j = 0; j < a_axis_x.bins; ++j) {
-      plot->h2->SetBinContent(1 + (int)j, 1 + (int)i, a_v.at(k++));
+  // Untouched tiles stay 0.
+  plot->h2->Reset();
+  auto tile_w = a_hist.GetTileWidth();
+  auto tile_h = a_hist.GetTileHeight();
+  std::vector<uint32_t> tile(tile_w * tile_h);
+  for (size_t y0 = 0; y0 < a_hist.GetHeight(); y0 += tile_h) {
+    auto ny = std::min(tile_h, a_hist.GetHeight() - y0);
+    for (size_t x0 = 0; x0 < a_hist.GetWidth(); x0 += tile_w) {
+      if (!a_hist.HasTile(x0, y0)) {
+        continue;
+      }
+      auto nx = std::min(tile_w, a_hist.GetWidth() - x0);
+      a_hist.CopyRect(x0, y0, nx, ny, tile.data());
+      auto p = tile.data();
+      for (size_t i = 0; i < ny; ++i) {
+        for (size_t j = 0; j < nx; ++j) {
+          auto v = *p++;
+          if (v) {
+            plot->h2->SetBinContent(1 + (int)(x0 + j), 1 + (int)(y0 + i), v);
+          }
+        }
+      }
     }
   }
   plot->h2->ResetStats();
@@ -38,7 +38,9 @@ SdlGui::PlotWrap::PlotWrap():
   plot(),
   is_log_set(),
   plot_state(0),
-  pixels()
+  hist2_tex(),
+  version(),
+  is_tense()
 {
 }
 
@@ -51,7 +53,8 @@ SdlGui::Page::Page():
 SdlGui::SdlGui(char const *a_title, unsigned a_width, unsigned a_height):
   m_window(new ImPlutt::Window(a_title, (int)a_width, (int)a_height)),
   m_page_vec(),
-  m_page_sel()
+  m_page_sel(),
+  m_status_prev()
 {
 }
 
@@ -109,7 +112,8 @@ bool SdlGui::Draw(double a_event_rate)
     return true;
   }
 
-  m_window->Begin();
+  // Only plots and the status line that changed are redrawn when idle.
+  m_window->Begin(true);
 
   // Fetch selected page.
   if (m_page_vec.size() > 1) {
@@ -134,6 +138,10 @@ bool SdlGui::Draw(double a_event_rate)
   } else {
     oss << a_event_rate * 1e-3 << "k";
   }
+  auto pathological = Pathological_get();
+  if (pathological) {
+    oss << "  Pathological: " << pathological;
+  }
   auto size1 = m_window->TextMeasure(ImPlutt::Window::TEXT_BOLD,
       oss.str().c_str());
 
@@ -162,7 +170,16 @@ bool SdlGui::Draw(double a_event_rate)
     for (auto it2 = vec.begin(); vec.end() != it2; ++it2) {
       auto plot_wrap = *it2;
       m_window->Push(elem_rect);
-      plot_wrap->plot->Draw(this);
+      auto version = plot_wrap->plot->GetVersion();
+      auto is_tense = plot_wrap->plot_state.IsTense();
+      // Projections live in their own window which is drawn by the plot.
+      if (m_window->Redraw(version != plot_wrap->version ||
+          is_tense != plot_wrap->is_tense ||
+          plot_wrap->plot_state.proj.window)) {
+        plot_wrap->plot->Draw(this);
+        plot_wrap->version = version;
+      }
+      plot_wrap->is_tense = is_tense;
       m_window->Pop();
       if (cols == ++i) {
         m_window->Newline();
@@ -175,25 +192,47 @@ bool SdlGui::Draw(double a_event_rate)
   m_window->Newline();
   m_window->HorizontalLine();
 
-  ImPlutt::Rect r;
-  r.x = 0;
-  r.y = 0;
-  r.w = 20 * h;
-  r.h = h;
-  m_window->Push(r);
+  ImPlutt::Rect r_line;
+  r_line.x = 0;
+  r_line.y = 0;
+  r_line.w = m_window->GetSize().x;
+  r_line.h = h;
+  m_window->Push(r_line);
 
-  m_window->Advance(ImPlutt::Pos(h, 0));
-  m_window->Text(ImPlutt::Window::TEXT_BOLD, oss.str().c_str());
+  auto status_line = oss.str() + status;
+  if (m_window->Redraw(status_line != m_status_prev)) {
+    m_status_prev = status_line;
 
-  m_window->Pop();
+    ImPlutt::Rect r;
+    r.x = 0;
+    r.y = 0;
+    r.w = 20 * h;
+    r.h = h;
+    m_window->Push(r);
+
+    m_window->Advance(ImPlutt::Pos(h, 0));
+    m_window->Text(ImPlutt::Window::TEXT_BOLD, oss.str().c_str());
 
-  m_window->Text(ImPlutt::Window::TEXT_BOLD, status.c_str());
+    m_window->Pop();
+
+    m_window->Text(ImPlutt::Window::TEXT_BOLD, status.c_str());
+  }
+
+  m_window->Pop();
 
   m_window->End();
 
   return true;
 }
 
+Gui::Visibility SdlGui::GetVisibility(uint32_t a_id)
+{
+  // Only the selected page is drawn.
+  auto page = m_page_vec.at(a_id >> 16);
+  return page == (m_page_sel ? m_page_sel : m_page_vec.front()) ?
+      kVisible : kHidden;
+}
+
 void SdlGui::DrawAnnular(uint32_t a_id, Axis const &a_axis_r, double a_r_min,
     double a_r_max, Axis const &a_axis_p, double a_phi0, bool a_is_log_z,
     std::vector<uint32_t> const &a_v)
@@ -226,7 +265,8 @@ void SdlGui::DrawAnnular(uint32_t a_id, Axis const &a_axis_r, double a_r_min,
 
 void SdlGui::DrawHist1(uint32_t a_id, Axis const &a_axis, LinearTransform
     const &a_transform, bool a_is_log_y, bool a_is_contour,
-    std::vector<uint32_t> const &a_v, std::vector<Peak> const &a_peak_vec)
+    std::vector<uint32_t> const &a_v, Hist1Pyramid const &a_pyramid,
+    std::vector<Peak> const &a_peak_vec, std::vector<float> const &a_bg_vec)
 {
   auto page = m_page_vec.at(a_id >> 16);
   auto plot_wrap = page->plot_wrap_vec.at(a_id & 0xffff);
@@ -255,7 +295,21 @@ void SdlGui::DrawHist1(uint32_t a_id, Axis const &a_axis, LinearTransform
 
   m_window->PlotHist1(&plot,
       minx, maxx,
-      a_v, (size_t)a_axis.bins, a_is_contour);
+      a_v, (size_t)a_axis.bins, a_is_contour, &a_pyramid);
+
+  // Background, at most about one point per pixel.
+  if (!a_bg_vec.empty() && a_bg_vec.size() == a_v.size()) {
+    auto step = std::max<size_t>(1,
+        a_bg_vec.size() / (size_t)std::max(size.x, 1));
+    std::vector<ImPlutt::Point> l;
+    l.reserve(a_bg_vec.size() / step + 1);
+    auto scale = (maxx - minx) / (double)a_bg_vec.size();
+    for (size_t i = 0; i < a_bg_vec.size(); i += step) {
+      l.push_back(ImPlutt::Point(minx + ((double)i + 0.5) * scale,
+          a_bg_vec[i]));
+    }
+    m_window->PlotLines(&plot, l);
+  }
 
   // Draw fits.
   for (auto it = a_peak_vec.begin(); a_peak_vec.end() != it; ++it) {
@@ -290,7 +344,7 @@ void SdlGui::DrawHist1(uint32_t a_id, Axis const &a_axis, LinearTransform
 
 void SdlGui::DrawHist2(uint32_t a_id, Axis const &a_axis_x, Axis const
     &a_axis_y, LinearTransform const &a_transform_x, LinearTransform const
-    &a_transform_y, bool a_is_log_z, std::vector<uint32_t> const &a_v)
+    &a_transform_y, bool a_is_log_z, TiledCounts const &a_hist)
 {
   auto page = m_page_vec.at(a_id >> 16);
   auto plot_wrap = page->plot_wrap_vec.at(a_id & 0xffff);
@@ -317,8 +371,7 @@ void SdlGui::DrawHist2(uint32_t a_id, Axis const &a_axis_x, Axis const
   m_window->PlotHist2(&plot, 0,
       ImPlutt::Point(minx, miny),
       ImPlutt::Point(maxx, maxy),
-      a_v, a_axis_y.bins, a_axis_x.bins,
-      plot_wrap->pixels);
+      a_hist, plot_wrap->plot->GetVersion(), &plot_wrap->hist2_tex);
 }
 
 #endif
@@ -0,0 +1,438 @@
+/*
+ * plutt, a scriptable monitor for experimental data.
+ *
+ * Copyright (C) 2025
+ * Hans Toshihide Toernqvist <hans.tornqvist@chalmers.se>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <tiled_counts.hpp>
+
+// Max bins per tile, small enough that promoting a tile is cheap.
+#define TILE_BITS 12
+// Histograms with at least this many bins allocate tiles lazily.
+#define SPARSE_MIN_BINS (1U << 20)
+
+namespace {
+  // Smallest power of 2 >= a_n, capped.
+  unsigned TileBits(size_t a_n, unsigned a_max)
+  {
+    unsigned bits = 0;
+    while (bits < a_max && ((size_t)1 << bits) < a_n) {
+      ++bits;
+    }
+    return bits;
+  }
+}
+
+TiledCounts::Tile::Tile():
+  width(WIDTH_16),
+  v16(),
+  v32(),
+  v64()
+{
+}
+
+TiledCounts::TiledCounts():
+  m_width(),
+  m_height(),
+  m_tile_w_bits(TILE_BITS),
+  m_tile_h_bits(),
+  m_tiles_x(),
+  m_tile_size(),
+  m_is_sparse(),
+  m_tile_vec()
+{
+}
+
+void TiledCounts::Add(TiledCounts const &a_src)
+{
+  assert(m_width == a_src.m_width);
+  assert(m_height == a_src.m_height);
+  for (size_t i = 0; i < m_tile_vec.size(); ++i) {
+    auto const &src = a_src.m_tile_vec[i];
+    if (!TileIsAlloc(src)) {
+      continue;
+    }
+    auto &dst = m_tile_vec[i];
+    if (!TileIsAlloc(dst)) {
+      TileAlloc(&dst);
+    }
+    for (size_t j = 0; j < m_tile_size; ++j) {
+      auto v = TileGet(src, j);
+      if (v) {
+        TileSet(&dst, j, TileGet(dst, j) + v);
+      }
+    }
+  }
+}
+
+void TiledCounts::Add(size_t a_x, size_t a_y, uint64_t a_v)
+{
+  assert(a_x < m_width);
+  assert(a_y < m_height);
+  auto &t = m_tile_vec[TileIndex(a_x, a_y)];
+  if (!TileIsAlloc(t)) {
+    TileAlloc(&t);
+  }
+  auto j = BinIndex(a_x, a_y);
+  TileSet(&t, j, TileGet(t, j) + a_v);
+}
+
+void TiledCounts::Clear()
+{
+  m_tile_vec.clear();
+  m_width = 0;
+  m_height = 0;
+  m_tiles_x = 0;
+}
+
+void TiledCounts::Copy(std::vector<uint32_t> *a_dst) const
+{
+  auto size = GetSize();
+  if (a_dst->size() != size) {
+    a_dst->resize(size);
+  }
+  CopyRect(0, 0, m_width, m_height, a_dst->data());
+}
+
+void TiledCounts::CopyRect(size_t a_x, size_t a_y, size_t a_w, size_t a_h,
+    uint32_t *a_dst) const
+{
+  assert(a_x + a_w <= m_width);
+  assert(a_y + a_h <= m_height);
+  auto tile_w = GetTileWidth();
+  auto mask_h = GetTileHeight() - 1;
+  for (size_t y = a_y; y < a_y + a_h; ++y) {
+    auto ofs_y = (y & mask_h) << m_tile_w_bits;
+    for (size_t x = a_x; x < a_x + a_w;) {
+      auto const &t = m_tile_vec[TileIndex(x, y)];
+      auto j = x & (tile_w - 1);
+      auto n = std::min(tile_w - j, a_x + a_w - x);
+      if (!TileIsAlloc(t)) {
+        memset(a_dst, 0, n * sizeof *a_dst);
+      } else {
+        auto ofs = ofs_y + j;
+        switch (t.width) {
+          case WIDTH_16:
+            for (size_t k = 0; k < n; ++k) {
+              a_dst[k] = t.v16[ofs + k];
+            }
+            break;
+          case WIDTH_32:
+            memcpy(a_dst, &t.v32[ofs], n * sizeof t.v32[0]);
+            break;
+          case WIDTH_64:
+            for (size_t k = 0; k < n; ++k) {
+              a_dst[k] = (uint32_t)std::min(t.v64[ofs + k],
+                  (uint64_t)UINT32_MAX);
+            }
+            break;
+        }
+      }
+      a_dst += n;
+      x += n;
+    }
+  }
+}
+
+uint64_t TiledCounts::Get(size_t a_x, size_t a_y) const
+{
+  assert(a_x < m_width);
+  assert(a_y < m_height);
+  return TileGet(m_tile_vec[TileIndex(a_x, a_y)], BinIndex(a_x, a_y));
+}
+
+size_t TiledCounts::GetHeight() const
+{
+  return m_height;
+}
+
+void TiledCounts::GetMinMax(uint32_t *a_min, uint32_t *a_max) const
+{
+  uint64_t min = UINT64_MAX;
+  uint64_t max = 0;
+  auto tile_w = GetTileWidth();
+  auto tile_h = GetTileHeight();
+  for (size_t i = 0; i < m_tile_vec.size(); ++i) {
+    auto const &t = m_tile_vec[i];
+    if (!TileIsAlloc(t)) {
+      min = 0;
+      continue;
+    }
+    // Edge tiles have padding which is never counted.
+    auto x0 = (i % m_tiles_x) << m_tile_w_bits;
+    auto y0 = (i / m_tiles_x) << m_tile_h_bits;
+    auto nx = std::min(tile_w, m_width - x0);
+    auto ny = std::min(tile_h, m_height - y0);
+    for (size_t r = 0; r < ny; ++r) {
+      auto ofs = r << m_tile_w_bits;
+      for (size_t j = 0; j < nx; ++j) {
+        auto v = TileGet(t, ofs + j);
+        min = std::min(min, v);
+        max = std::max(max, v);
+      }
+    }
+  }
+  if (UINT64_MAX == min) {
+    min = 0;
+  }
+  *a_min = (uint32_t)std::min(min, (uint64_t)UINT32_MAX);
+  *a_max = (uint32_t)std::min(max, (uint64_t)UINT32_MAX);
+}
+
+size_t TiledCounts::GetMemSize() const
+{
+  size_t size = m_tile_vec.size() * sizeof m_tile_vec[0];
+  for (auto it = m_tile_vec.begin(); m_tile_vec.end() != it; ++it) {
+    size += it->v16.size() * sizeof it->v16[0];
+    size += it->v32.size() * sizeof it->v32[0];
+    size += it->v64.size() * sizeof it->v64[0];
+  }
+  return size;
+}
+
+size_t TiledCounts::GetSize() const
+{
+  return m_width * m_height;
+}
+
+size_t TiledCounts::GetTileHeight() const
+{
+  return (size_t)1 << m_tile_h_bits;
+}
+
+size_t TiledCounts::GetTileWidth() const
+{
+  return (size_t)1 << m_tile_w_bits;
+}
+
+size_t TiledCounts::GetWidth() const
+{
+  return m_width;
+}
+
+void TiledCounts::Halve()
+{
+  // Tiles are not demoted, they are likely to fill up again.
+  for (auto it = m_tile_vec.begin(); m_tile_vec.end() != it; ++it) {
+    auto &t = *it;
+    for (auto it2 = t.v16.begin(); t.v16.end() != it2; ++it2) {
+      *it2 >>= 1;
+    }
+    for (auto it2 = t.v32.begin(); t.v32.end() != it2; ++it2) {
+      *it2 >>= 1;
+    }
+    for (auto it2 = t.v64.begin(); t.v64.end() != it2; ++it2) {
+      *it2 >>= 1;
+    }
+  }
+}
+
+bool TiledCounts::HasTile(size_t a_x, size_t a_y) const
+{
+  return TileIsAlloc(m_tile_vec.at(TileIndex(a_x, a_y)));
+}
+
+void TiledCounts::Inc(size_t a_x, size_t a_y)
+{
+  assert(a_x < m_width);
+  assert(a_y < m_height);
+  auto &t = m_tile_vec.at(TileIndex(a_x, a_y));
+  auto j = BinIndex(a_x, a_y);
+  if (WIDTH_16 == t.width) {
+    if (t.v16.empty()) {
+      TileAlloc(&t);
+    }
+    auto &v = t.v16[j];
+    if (v < UINT16_MAX) {
+      ++v;
+      return;
+    }
+    TilePromote(&t);
+  }
+  if (WIDTH_32 == t.width) {
+    auto &v = t.v32[j];
+    if (v < UINT32_MAX) {
+      ++v;
+      return;
+    }
+    TilePromote(&t);
+  }
+  ++t.v64[j];
+}
+
+bool TiledCounts::IsSparse() const
+{
+  return m_is_sparse;
+}
+
+void TiledCounts::Resize(size_t a_width, size_t a_height)
+{
+  m_width = a_width;
+  m_height = a_height;
+  // Small histograms get small tiles, so they don't pay for more than the
+  // plain counters would.
+  if (a_height > 1) {
+    m_tile_w_bits = TileBits(a_width, TILE_BITS / 2);
+    m_tile_h_bits = TileBits(a_height, TILE_BITS / 2);
+  } else {
+    m_tile_w_bits = TileBits(a_width, TILE_BITS);
+    m_tile_h_bits = 0;
+  }
+  auto tile_w = GetTileWidth();
+  auto tile_h = GetTileHeight();
+  m_tiles_x = (a_width + tile_w - 1) / tile_w;
+  auto tiles_y = (a_height + tile_h - 1) / tile_h;
+  m_tile_size = tile_w * tile_h;
+  if (tile_h <= 1 && 1 == m_tiles_x) {
+    // A single 1D tile needs no power-of-2 padding.
+    m_tile_size = a_width;
+  }
+  m_is_sparse = GetSize() >= SPARSE_MIN_BINS;
+  m_tile_vec.resize(m_tiles_x * tiles_y);
+  Zero();
+}
+
+void TiledCounts::Set(std::vector<uint32_t> const &a_src, size_t a_width,
+    size_t a_height)
+{
+  assert(a_src.size() == a_width * a_height);
+  Resize(a_width, a_height);
+  size_t i = 0;
+  for (size_t y = 0; y < a_height; ++y) {
+    for (size_t x = 0; x < a_width; ++x) {
+      auto v = a_src[i++];
+      if (v) {
+        Add(x, y, v);
+      }
+    }
+  }
+}
+
+void TiledCounts::Sub(TiledCounts const &a_src)
+{
+  assert(m_width == a_src.m_width);
+  assert(m_height == a_src.m_height);
+  for (size_t i = 0; i < m_tile_vec.size(); ++i) {
+    auto const &src = a_src.m_tile_vec[i];
+    if (!TileIsAlloc(src)) {
+      continue;
+    }
+    auto &dst = m_tile_vec[i];
+    for (size_t j = 0; j < m_tile_size; ++j) {
+      auto v = TileGet(src, j);
+      if (v) {
+        auto d = TileGet(dst, j);
+        assert(d >= v);
+        TileSet(&dst, j, d - v);
+      }
+    }
+  }
+}
+
+void TiledCounts::Zero()
+{
+  for (auto it = m_tile_vec.begin(); m_tile_vec.end() != it; ++it) {
+    TileZero(&*it, !m_is_sparse);
+  }
+}
+
+size_t TiledCounts::BinIndex(size_t a_x, size_t a_y) const
+{
+  auto mask_w = GetTileWidth() - 1;
+  auto mask_h = GetTileHeight() - 1;
+  return (a_y & mask_h) << m_tile_w_bits | (a_x & mask_w);
+}
+
+size_t TiledCounts::TileIndex(size_t a_x, size_t a_y) const
+{
+  return (a_y >> m_tile_h_bits) * m_tiles_x + (a_x >> m_tile_w_bits);
+}
+
+void TiledCounts::TileAlloc(Tile *a_t) const
+{
+  a_t->width = WIDTH_16;
+  a_t->v16.assign(m_tile_size, 0);
+}
+
+uint64_t TiledCounts::TileGet(Tile const &a_t, size_t a_j)
+{
+  switch (a_t.width) {
+    case WIDTH_16: return a_t.v16.empty() ? 0 : a_t.v16[a_j];
+    case WIDTH_32: return a_t.v32[a_j];
+    case WIDTH_64: return a_t.v64[a_j];
+  }
+  return 0;
+}
+
+bool TiledCounts::TileIsAlloc(Tile const &a_t)
+{
+  return WIDTH_16 != a_t.width || !a_t.v16.empty();
+}
+
+void TiledCounts::TilePromote(Tile *a_t)
+{
+  switch (a_t->width) {
+    case WIDTH_16:
+      a_t->v32.assign(a_t->v16.begin(), a_t->v16.end());
+      std::vector<uint16_t>().swap(a_t->v16);
+      a_t->width = WIDTH_32;
+      break;
+    case WIDTH_32:
+      a_t->v64.assign(a_t->v32.begin(), a_t->v32.end());
+      std::vector<uint32_t>().swap(a_t->v32);
+      a_t->width = WIDTH_64;
+      break;
+    case WIDTH_64:
+      break;
+  }
+}
+
+void TiledCounts::TileSet(Tile *a_t, size_t a_j, uint64_t a_v)
+{
+  if (WIDTH_16 == a_t->width && a_v > UINT16_MAX) {
+    TilePromote(a_t);
+  }
+  if (WIDTH_32 == a_t->width && a_v > UINT32_MAX) {
+    TilePromote(a_t);
+  }
+  switch (a_t->width) {
+    case WIDTH_16: a_t->v16[a_j] = (uint16_t)a_v; break;
+    case WIDTH_32: a_t->v32[a_j] = (uint32_t)a_v; break;
+    case WIDTH_64: a_t->v64[a_j] = a_v; break;
+  }
+}
+
+// Also demotes the tile, a fresh start is likely to stay small. Sparse
+// storage frees the tile entirely.
+void TiledCounts::TileZero(Tile *a_t, bool a_do_alloc) const
+{
+  a_t->width = WIDTH_16;
+  if (a_do_alloc) {
+    a_t->v16.assign(m_tile_size, 0);
+  } else {
+    std::vector<uint16_t>().swap(a_t->v16);
+  }
+  std::vector<uint32_t>().swap(a_t->v32);
+  std::vector<uint64_t>().swap(a_t->v64);
+}
@@ -77,7 +77,9 @@ struct GlyphKey {
 };
 struct GlyphValue {
   GlyphValue():
+    id(),
     bmap(),
+    bmap_bold(),
     x(),
     y(),
     w(),
@@ -86,7 +88,10 @@ struct GlyphValue {
     t_last()
   {
   }
+  uint32_t id;
   std::vector<uint8_t> bmap;
+  // Smeared one pixel to the right, made on demand.
+  std::vector<uint8_t> bmap_bold;
   int x;
   int y;
   unsigned w;
@@ -96,12 +101,6 @@ struct GlyphValue {
 };
 std::map<GlyphKey, GlyphValue, GlyphKey> g_glyph_map;
 
-FontPrinted::FontPrinted():
-  size(),
-  bmap()
-{
-}
-
 Font *FontLoad(char const *a_path)
 {
   auto f = new Font;
@@ -136,6 +135,7 @@ GlyphValue *GetRenderedGlyph(Font *a_f, int a_size, unsigned a_index)
     auto ret = g_glyph_map.insert(std::make_pair(key, GlyphValue()));
     it = ret.first;
     auto &value = it->second;
+    value.id = (uint32_t)g_glyph_map.size() - 1;
     // Render it to our own bitmap.
     value.x = slot->bitmap_left;
     value.y = -slot->bitmap_top;
@@ -197,15 +197,12 @@ FontSize FontMeasure(Font *a_f, char const *a_str)
   return s;
 }
 
-FontPrinted FontPrintf(Font *a_f, char const *a_str, uint8_t a_r, uint8_t a_g,
-    uint8_t a_b)
+void FontLayout(Font *a_f, char const *a_str, std::vector<FontGlyph>
+    *a_vec)
 {
   unsigned boldness = a_f->is_bold ? 1 : 0;
-  auto ascender = a_f->face->size->metrics.ascender >> 6;
-  FontPrinted fp;
-  // TODO: This is a waste...
-  fp.size = FontMeasure(a_f, a_str);
-  fp.bmap.resize(4 * fp.size.w * fp.size.h);
+  auto ascender = (int)(a_f->face->size->metrics.ascender >> 6);
+  a_vec->clear();
   int x = 0;
   auto has_kerning = FT_HAS_KERNING(a_f->face);
   unsigned index_prev = 0;
@@ -220,34 +217,38 @@ FontPrinted FontPrintf(Font *a_f, char const *a_str, uint8_t a_r, uint8_t a_g,
       x += (int)delta.x >> 6;
     }
     auto glyph = GetRenderedGlyph(a_f, a_f->size, index_curr);
-    auto w = glyph->w + boldness;
-    uint8_t const *srcp = glyph->bmap.data();
-    for (unsigned i = 0; i < glyph->h; ++i) {
-      auto yy = glyph->y + (int)i + ascender;
-      for (unsigned j = 0; j < w; ++j) {
-        auto xx = x + glyph->x + (int)j - fp.size.x;
-        auto dst_ofs = 4 * (size_t)(yy * (int)fp.size.w + xx);
-        unsigned v;
-        if (!a_f->is_bold) {
-          v = *srcp++;
-        } else if (j == 0) {
-          v = *srcp++;
-        } else if (j + 1 == w) {
-          v = srcp[-1];
-        } else {
-          v = srcp[-1] + srcp[0];
-          v = std::min(v, 255U);
-          ++srcp;
+    if (a_f->is_bold && glyph->bmap_bold.empty() && glyph->w > 0) {
+      auto w = glyph->w + 1;
+      glyph->bmap_bold.resize(w * glyph->h);
+      uint8_t const *srcp = glyph->bmap.data();
+      size_t dst_ofs = 0;
+      for (unsigned i = 0; i < glyph->h; ++i) {
+        for (unsigned j = 0; j < w; ++j) {
+          unsigned v;
+          if (j == 0) {
+            v = *srcp++;
+          } else if (j + 1 == w) {
+            v = srcp[-1];
+          } else {
+            v = srcp[-1] + srcp[0];
+            v = std::min(v, 255U);
+            ++srcp;
+          }
+          glyph->bmap_bold[dst_ofs++] = (uint8_t)v;
         }
-        fp.bmap.at(dst_ofs + 0) = (uint8_t)v;
-        fp.bmap.at(dst_ofs + 1) = a_r;
-        fp.bmap.at(dst_ofs + 2) = a_g;
-        fp.bmap.at(dst_ofs + 3) = a_b;
       }
     }
+    FontGlyph g;
+    g.id = 2 * glyph->id + boldness;
+    g.x = x + glyph->x;
+    g.y = glyph->y + ascender;
+    g.w = glyph->w > 0 ? glyph->w + boldness : 0;
+    g.h = glyph->h;
+    g.bmap = a_f->is_bold ? glyph->bmap_bold.data() : glyph->bmap.data();
+    a_vec->push_back(g);
     x += glyph->advance_x;
+    index_prev = index_curr;
   }
-  return fp;
 }
 
 void FontSetBold(Font *a_f, bool a_yes)
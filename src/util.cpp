@@ -29,10 +29,12 @@
 #include <cstdarg>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <mutex>
 #include <string>
 #include <vector>
 
+#include <tiled_counts.hpp>
 #include <util.hpp>
 
 namespace {
@@ -219,6 +221,122 @@ std::vector<uint32_t> Rebin1(std::vector<uint32_t> const &a_hist,
   return nh;
 }
 
+namespace {
+
+struct Rebin2Map {
+  Rebin2Map(
+      size_t a_binsx_old, double a_minx_old, double a_maxx_old,
+      size_t a_binsy_old, double a_miny_old, double a_maxy_old,
+      size_t a_binsx_new, double a_minx_new, double a_maxx_new,
+      size_t a_binsy_new, double a_miny_new, double a_maxy_new):
+    minx_old(a_minx_old),
+    miny_old(a_miny_old),
+    minx_new(a_minx_new),
+    miny_new(a_miny_new),
+    binsx_new(a_binsx_new),
+    binsy_new(a_binsy_new),
+    x_from_j((a_maxx_old - a_minx_old) / (double)a_binsx_old),
+    nj_from_x((double)a_binsx_new / (a_maxx_new - a_minx_new)),
+    y_from_i((a_maxy_old - a_miny_old) / (double)a_binsy_old),
+    ni_from_y((double)a_binsy_new / (a_maxy_new - a_miny_new))
+  {
+  }
+  double minx_old;
+  double miny_old;
+  double minx_new;
+  double miny_new;
+  size_t binsx_new;
+  size_t binsy_new;
+  double x_from_j;
+  double nj_from_x;
+  double y_from_i;
+  double ni_from_y;
+};
+
+// Spreads the counts of old cell (i,j) over new cells, calls
+// a_add(new_i, new_j, counts) for every piece.
+template <typename Add> void Rebin2Cell(Rebin2Map const &a_map, size_t a_i,
+    size_t a_j, double a_v, Add const &a_add)
+{
+  double y_l = a_map.miny_old + a_map.y_from_i * (double)(a_i + 0);
+  double y_r = a_map.miny_old + a_map.y_from_i * (double)(a_i + 1);
+
+  double fy_l = a_map.ni_from_y * (y_l - a_map.miny_new);
+  double fy_r = a_map.ni_from_y * (y_r - a_map.miny_new);
+
+  auto i_l = (int)floor(fy_l);
+  auto i_r = (int)ceil(fy_r - 1);
+  i_r = std::min(i_r, (int)a_map.binsy_new - 1);
+
+  double x_l = a_map.minx_old + a_map.x_from_j * (double)(a_j + 0);
+  double x_r = a_map.minx_old + a_map.x_from_j * (double)(a_j + 1);
+
+  double fx_l = a_map.nj_from_x * (x_l - a_map.minx_new);
+  double fx_r = a_map.nj_from_x * (x_r - a_map.minx_new);
+
+  auto j_l = (int)floor(fx_l);
+  auto j_r = (int)ceil(fx_r - 1);
+  j_r = std::min(j_r, (int)a_map.binsx_new - 1);
+
+  // TODO: This whole thing is so nasty, can it be optimized?
+  auto v = a_v;
+  if (i_l < 0) {
+    // Fast-forward to y=0.
+    v = (uint32_t)(v * (1 - -fy_l / (fy_r - fy_l)));
+    fy_l = 0;
+    i_l = 0;
+  }
+  if (j_l < 0) {
+    // Fast-forward to x=0.
+    v = (uint32_t)(v * (1 - -fx_l / (fx_r - fx_l)));
+    fx_l = 0;
+    j_l = 0;
+  }
+  // Used to keep track of rounding errors.
+  double vs = 0.0;
+  double ivs = 0.0;
+  int last_i = -1;
+  int last_j = -1;
+  // Spread the source cell over destination cells.
+  double fy = fy_l;
+  for (auto ii = i_l; ii <= i_r; ++ii) {
+    auto ny = floor(fy + 1);
+    ny = std::min(ny, fy_r);
+    auto sy = (ny - fy) / (fy_r - fy_l);
+    double fx = fx_l;
+    for (auto jj = j_l; jj <= j_r; ++jj) {
+      auto nx = floor(fx + 1);
+      nx = std::min(nx, fx_r);
+      auto sx = (nx - fx) / (fx_r - fx_l);
+      auto dv = v * sy * sx;
+      auto idv = (uint32_t)dv;
+      vs += dv;
+      ivs += idv;
+      if (vs + 1 > ivs) {
+        // If the integer deltas lose counts, recover.
+        auto d = floor(vs) - floor(ivs);
+        idv += (uint32_t)d;
+        ivs += d;
+      }
+      assert(ii >= 0);
+      assert(ii < (int)a_map.binsy_new);
+      assert(jj >= 0);
+      assert(jj < (int)a_map.binsx_new);
+      a_add((size_t)ii, (size_t)jj, idv);
+      last_i = ii;
+      last_j = jj;
+      fx = nx;
+    }
+    fy = ny;
+  }
+  if (last_i >= 0 && last_i < (int)a_map.binsy_new &&
+      last_j >= 0 && last_j < (int)a_map.binsx_new) {
+    a_add((size_t)last_i, (size_t)last_j, (uint32_t)(v - ivs));
+  }
+}
+
+}
+
 std::vector<uint32_t> Rebin2(std::vector<uint32_t> const &a_hist,
     size_t a_binsx_old, double a_minx_old, double a_maxx_old,
     size_t a_binsy_old, double a_miny_old, double a_maxy_old,
@@ -227,173 +345,253 @@ std::vector<uint32_t> Rebin2(std::vector<uint32_t> const &a_hist,
 {
   assert(a_hist.size() == a_binsx_old * a_binsy_old);
   std::vector<uint32_t> nh(a_binsx_new * a_binsy_new);
-  auto x_from_j = (a_maxx_old - a_minx_old) / (double)a_binsx_old;
-  auto nj_from_x = (double)a_binsx_new / (a_maxx_new - a_minx_new);
-  auto y_from_i = (a_maxy_old - a_miny_old) / (double)a_binsy_old;
-  auto ni_from_y = (double)a_binsy_new / (a_maxy_new - a_miny_new);
+  Rebin2Map map(
+      a_binsx_old, a_minx_old, a_maxx_old,
+      a_binsy_old, a_miny_old, a_maxy_old,
+      a_binsx_new, a_minx_new, a_maxx_new,
+      a_binsy_new, a_miny_new, a_maxy_new);
+  auto add = [&nh, a_binsx_new](size_t a_i, size_t a_j, uint32_t a_dv) {
+    nh.at(a_i * a_binsx_new + a_j) += a_dv;
+  };
   for (size_t i = 0; i < a_binsy_old; ++i) {
-    double y_l = a_miny_old + y_from_i * (double)(i + 0);
-    double y_r = a_miny_old + y_from_i * (double)(i + 1);
-
-    double fy_l = ni_from_y * (y_l - a_miny_new);
-    double fy_r = ni_from_y * (y_r - a_miny_new);
-
-    auto i_l = (int)floor(fy_l);
-    auto i_r = (int)ceil(fy_r - 1);
-    i_r = std::min(i_r, (int)a_binsy_new - 1);
-
     for (size_t j = 0; j < a_binsx_old; ++j) {
-      double x_l = a_minx_old + x_from_j * (double)(j + 0);
-      double x_r = a_minx_old + x_from_j * (double)(j + 1);
-
-      double fx_l = nj_from_x * (x_l - a_minx_new);
-      double fx_r = nj_from_x * (x_r - a_minx_new);
-
-      auto j_l = (int)floor(fx_l);
-      auto j_r = (int)ceil(fx_r - 1);
-      j_r = std::min(j_r, (int)a_binsx_new - 1);
-
-      // TODO: This whole thing is so nasty, can it be optimized?
-      auto v = (double)a_hist.at(i * a_binsx_old + j);
-      if (i_l < 0) {
-        // Fast-forward to y=0.
-        v = (uint32_t)(v * (1 - -fy_l / (fy_r - fy_l)));
-        fy_l = 0;
-        i_l = 0;
-      }
-      if (j_l < 0) {
-        // Fast-forward to y=0.
-        v = (uint32_t)(v * (1 - -fx_l / (fx_r - fx_l)));
-        fx_l = 0;
-        j_l = 0;
+      Rebin2Cell(map, i, j, (double)a_hist.at(i * a_binsx_old + j), add);
+    }
+  }
+  return nh;
+}
+
+TiledCounts Rebin2(TiledCounts const &a_hist,
+    double a_minx_old, double a_maxx_old,
+    double a_miny_old, double a_maxy_old,
+    size_t a_binsx_new, double a_minx_new, double a_maxx_new,
+    size_t a_binsy_new, double a_miny_new, double a_maxy_new)
+{
+  auto binsx_old = a_hist.GetWidth();
+  auto binsy_old = a_hist.GetHeight();
+  TiledCounts nh;
+  nh.Resize(a_binsx_new, a_binsy_new);
+  Rebin2Map map(
+      binsx_old, a_minx_old, a_maxx_old,
+      binsy_old, a_miny_old, a_maxy_old,
+      a_binsx_new, a_minx_new, a_maxx_new,
+      a_binsy_new, a_miny_new, a_maxy_new);
+  auto add = [&nh](size_t a_i, size_t a_j, uint32_t a_dv) {
+    if (a_dv) {
+      nh.Add(a_j, a_i, a_dv);
+    }
+  };
+  // Only visit tiles that were ever touched.
+  auto tile_w = a_hist.GetTileWidth();
+  auto tile_h = a_hist.GetTileHeight();
+  for (size_t y0 = 0; y0 < binsy_old; y0 += tile_h) {
+    for (size_t x0 = 0; x0 < binsx_old; x0 += tile_w) {
+      if (!a_hist.HasTile(x0, y0)) {
+        continue;
       }
-      // Used to keep track of rounding errors.
-      double vs = 0.0;
-      double ivs = 0.0;
-      int last_i = -1;
-      int last_j = -1;
-      // Spread the source cell over destination cells.
-      double fy = fy_l;
-      for (auto ii = i_l; ii <= i_r; ++ii) {
-        auto ny = floor(fy + 1);
-        ny = std::min(ny, fy_r);
-        auto sy = (ny - fy) / (fy_r - fy_l);
-        auto ofs = (size_t)(ii * (int)a_binsx_new + j_l);
-        double fx = fx_l;
-        for (auto jj = j_l; jj <= j_r; ++jj) {
-          auto nx = floor(fx + 1);
-          nx = std::min(nx, fx_r);
-          auto sx = (nx - fx) / (fx_r - fx_l);
-          auto dv = v * sy * sx;
-          auto idv = (uint32_t)dv;
-          vs += dv;
-          ivs += idv;
-          if (vs + 1 > ivs) {
-            // If the integer deltas lose counts, recover.
-            auto d = floor(vs) - floor(ivs);
-            idv += (uint32_t)d;
-            ivs += d;
+      auto y1 = std::min(y0 + tile_h, binsy_old);
+      auto x1 = std::min(x0 + tile_w, binsx_old);
+      for (auto i = y0; i < y1; ++i) {
+        for (auto j = x0; j < x1; ++j) {
+          auto v = a_hist.Get(j, i);
+          if (v) {
+            Rebin2Cell(map, i, j, (double)v, add);
           }
-          assert(ii >= 0);
-          assert(ii < (int)a_binsy_new);
-          assert(jj >= 0);
-          assert(jj < (int)a_binsx_new);
-          nh.at(ofs) += idv;
-          last_i = ii;
-          last_j = jj;
-          ++ofs;
-          fx = nx;
         }
-        fy = ny;
-      }
-      if (last_i >= 0 && last_i < (int)a_binsy_new &&
-          last_j >= 0 && last_j < (int)a_binsx_new) {
-        nh.at((size_t)last_i * a_binsx_new + (size_t)last_j) +=
-            (uint32_t)(v - ivs);
       }
     }
   }
   return nh;
 }
 
-std::vector<float> Snip(std::vector<uint32_t> const &a_v, uint32_t a_exp)
+Hist1Pyramid::Hist1Pyramid():
+  m_level_vec()
+{
+}
+
+// Level k+1 pairs up level k, the last entry of an odd level stands alone.
+// Vectors are kept between builds to not reallocate every latch.
+void Hist1Pyramid::Build(std::vector<uint32_t> const &a_v)
 {
-  std::vector<float> buf0(a_v.size());
-  std::vector<float> buf1(a_v.size());
-  float *v[] = {&buf0[0], &buf1[0]};
-  // Simplified LLS.
+  size_t level_num = 0;
+  for (auto n = a_v.size(); n > 0; n = n > 1 ? (n + 1) / 2 : 0) {
+    ++level_num;
+  }
+  m_level_vec.resize(level_num);
+  if (0 == level_num) {
+    return;
+  }
+  auto &l0 = m_level_vec[0];
+  l0.resize(a_v.size());
   for (size_t i = 0; i < a_v.size(); ++i) {
-    v[1][i] = v[0][i] = (float)log(a_v[i] + 2);
+    l0[i].min = l0[i].max = a_v[i];
+  }
+  for (size_t k = 1; k < level_num; ++k) {
+    auto const &src = m_level_vec[k - 1];
+    auto &dst = m_level_vec[k];
+    dst.resize((src.size() + 1) / 2);
+    for (size_t i = 0; i < src.size() / 2; ++i) {
+      auto const &a = src[2 * i];
+      auto const &b = src[2 * i + 1];
+      dst[i].min = std::min(a.min, b.min);
+      dst[i].max = std::max(a.max, b.max);
+    }
+    if (src.size() & 1) {
+      dst.back() = src.back();
+    }
   }
+}
+
+size_t Hist1Pyramid::GetSize() const
+{
+  return m_level_vec.empty() ? 0 : m_level_vec[0].size();
+}
+
+// Min/max of bins [a_i0, a_i1), must be non-empty.
+void Hist1Pyramid::Query(size_t a_i0, size_t a_i1, uint32_t *a_min, uint32_t
+    *a_max) const
+{
+  assert(a_i0 < a_i1 && a_i1 <= GetSize());
+  uint32_t min = UINT32_MAX;
+  uint32_t max = 0;
+  for (size_t k = 0; a_i0 < a_i1; ++k) {
+    auto const &level = m_level_vec[k];
+    if (a_i0 & 1) {
+      min = std::min(min, level[a_i0].min);
+      max = std::max(max, level[a_i0].max);
+      ++a_i0;
+    }
+    if (a_i1 & 1) {
+      --a_i1;
+      min = std::min(min, level[a_i1].min);
+      max = std::max(max, level[a_i1].max);
+    }
+    a_i0 >>= 1;
+    a_i1 >>= 1;
+  }
+  *a_min = min;
+  *a_max = max;
+}
+
+namespace {
+  /*
+   * Cheap stand-in for the log in LLS: the bits of a positive float are a
+   * piecewise linear log2 (scaled and offset), monotonic and exactly
+   * invertible, and the filtering can then run on plain ints.
+   */
+  uint32_t SnipLog(uint32_t a_v)
+  {
+    float f = (float)a_v + 2.0f;
+    uint32_t u;
+    memcpy(&u, &f, sizeof u);
+    return u;
+  }
+
+  float SnipExp(uint32_t a_u)
+  {
+    float f;
+    memcpy(&f, &a_u, sizeof f);
+    return f - 2.0f;
+  }
+
+  void SnipPrepare(std::vector<uint32_t> const &a_v, SnipBuf *a_buf)
+  {
+    auto n = a_v.size();
+    a_buf->v[0].resize(n);
+    a_buf->v[1].resize(n);
+    auto src = a_v.data();
+    auto dst = a_buf->v[0].data();
+    for (size_t i = 0; i < n; ++i) {
+      dst[i] = SnipLog(src[i]);
+    }
+  }
+
+  void SnipFinish(std::vector<uint32_t> const &a_u, std::vector<float>
+      *a_out)
+  {
+    auto n = a_u.size();
+    a_out->resize(n);
+    auto src = a_u.data();
+    auto dst = a_out->data();
+    for (size_t i = 0; i < n; ++i) {
+      dst[i] = SnipExp(src[i]);
+    }
+  }
+
+  // One clipping pass, the loop is left simple enough to auto-vectorize.
+  void SnipRow(uint32_t const *__restrict a_l, uint32_t const *__restrict
+      a_c, uint32_t const *__restrict a_r, uint32_t *__restrict a_dst, size_t
+      a_n)
+  {
+    for (size_t i = 0; i < a_n; ++i) {
+      // Floats in [2,2^32] have bits < 2^31, the sum can't wrap.
+      auto avg = (a_l[i] + a_r[i]) >> 1;
+      a_dst[i] = std::min(a_c[i], avg);
+    }
+  }
+}
+
+void Snip(std::vector<uint32_t> const &a_v, uint32_t a_exp, SnipBuf *a_buf,
+    std::vector<float> *a_out)
+{
+  SnipPrepare(a_v, a_buf);
+  auto n = a_v.size();
   // Log2 filtering.
   size_t src_i = 0;
   for (uint32_t e = 0; e < a_exp; ++e) {
-    size_t p = 1 << e;
-    size_t dst_i = 1 ^ src_i;
-    auto &v_src = v[src_i];
-    auto &v_dst = v[dst_i];
-    for (size_t j = 2 * p; j < a_v.size(); ++j) {
-      auto i = j - p;
-      auto v0 = v_src[i - p];
-      auto v1 = v_src[i + 0];
-      auto v2 = v_src[i + p];
-      v_dst[i] = std::min(v1, (v0 + v2) / 2);
+    size_t p = (size_t)1 << e;
+    if (2 * p >= n) {
+      break;
     }
+    auto src = a_buf->v[src_i].data();
+    auto dst = a_buf->v[1 ^ src_i].data();
+    // Edges don't see both neighbours and are kept.
+    memcpy(dst, src, p * sizeof *dst);
+    memcpy(dst + n - p, src + n - p, p * sizeof *dst);
+    SnipRow(src, src + p, src + 2 * p, dst + p, n - 2 * p);
     src_i ^= 1;
   }
-  // Undo LLS.
-  auto &v_src = v[src_i];
-  for (size_t i = 0; i < a_v.size(); ++i) {
-    v_src[i] = (float)exp(v_src[i]) - 2;
-  }
-  return 0 == src_i ? buf0 : buf1;
+  SnipFinish(a_buf->v[src_i], a_out);
 }
 
-std::vector<float> Snip2(std::vector<uint32_t> const &a_v, size_t a_w, size_t
-    a_h, uint32_t a_exp)
+void Snip2(std::vector<uint32_t> const &a_v, size_t a_w, size_t a_h, uint32_t
+    a_exp, SnipBuf *a_buf, std::vector<float> *a_out)
 {
   assert(a_v.size() == a_w * a_h);
-  std::vector<float> buf0(a_v.size());
-  std::vector<float> buf1(a_v.size());
-  float *v[] = {&buf0[0], &buf1[0]};
-  for (size_t i = 0; i < a_v.size(); ++i) {
-    v[1][i] = v[0][i] = (float)log(a_v[i] + 2);
-  }
+  SnipPrepare(a_v, a_buf);
+  auto &avg = a_buf->avg;
+  avg.resize(a_w);
   // Log2 filtering.
   size_t src_i = 0;
   for (uint32_t e = 0; e < a_exp; ++e) {
-    size_t p = 1 << e;
+    size_t p = (size_t)1 << e;
+    if (2 * p >= a_w || 2 * p >= a_h) {
+      break;
+    }
     size_t pw = a_w << e;
-    size_t dst_i = 1 ^ src_i;
-    auto &v_src = v[src_i];
-    auto &v_dst = v[dst_i];
-    for (size_t k = 2 * p; k < a_h; ++k) {
-      auto i = k - p;
-      auto ofs = i * a_w + p;
-      for (size_t l = 2 * p; l < a_w; ++l) {
-        auto v0 = v_src[i - pw];
-        auto v1 = v_src[i - p];
-        auto v2 = v_src[i + 0];
-        auto v3 = v_src[i + p];
-        auto v4 = v_src[i + pw];
-        auto v04 = (v0 + v4) / 2;
-        auto v13 = (v1 + v3) / 2;
-        assert(ofs < a_v.size());
-        v_dst[ofs++] = std::min(v2, std::min(v04, v13));
-      }
+    auto src = a_buf->v[src_i].data();
+    auto dst = a_buf->v[1 ^ src_i].data();
+    memcpy(dst, src, pw * sizeof *dst);
+    for (size_t k = p; k < a_h - p; ++k) {
+      auto row = k * a_w;
+      auto c = src + row;
+      auto d = dst + row;
+      memcpy(d, c, p * sizeof *d);
+      memcpy(d + a_w - p, c + a_w - p, p * sizeof *d);
+      // Min of vertical and horizontal clipping, in two passes.
+      SnipRow(c - pw + p, c + p, c + pw + p, avg.data(), a_w - 2 * p);
+      SnipRow(c, avg.data(), c + 2 * p, d + p, a_w - 2 * p);
     }
+    memcpy(dst + (a_h - p) * a_w, src + (a_h - p) * a_w, pw * sizeof *dst);
     src_i ^= 1;
   }
-  auto &v_src = v[src_i];
-  for (size_t i = 0; i < a_v.size(); ++i) {
-    v_src[i] = (float)exp(v_src[i]) - 2;
-  }
-  return 0 == src_i ? buf0 : buf1;
+  SnipFinish(a_buf->v[src_i], a_out);
 }
 
 namespace {
   std::mutex g_status_mutex;
   std::string g_status;
+  uint64_t g_pathological;
 }
 
 std::string Status_get()
@@ -424,6 +622,18 @@ void Status_set(char const *a_fmt, ...)
   g_status = buf;
 }
 
+void Pathological_add()
+{
+  std::unique_lock<std::mutex> lock(g_status_mutex);
+  ++g_pathological;
+}
+
+uint64_t Pathological_get()
+{
+  std::unique_lock<std::mutex> lock(g_status_mutex);
+  return g_pathological;
+}
+
 double SubModDbl(double a_l, double a_r, double a_range)
 {
   double d = a_l - a_r;
@@ -21,6 +21,7 @@
  */
 
 #include <algorithm>
+#include <cassert>
 #include <cstdint>
 #include <cstring>
 #include <stdexcept>
@@ -118,6 +119,89 @@ void Value::Push(uint32_t a_i, Input::Scalar const &a_v)
   m_v.push_back(a_v);
 }
 
+void Value::PushChannels(Value const &a_src, uint32_t a_i0, uint32_t a_i1)
+{
+  if (a_i0 >= a_i1) {
+    return;
+  }
+  assert(a_i1 <= a_src.m_id.size());
+  auto src_id = a_src.m_id.begin();
+  auto src_end = a_src.m_end.begin();
+  auto v0 = 0 == a_i0 ? 0 : src_end[a_i0 - 1];
+  auto v1 = src_end[a_i1 - 1];
+  auto end_prev = m_end.empty() ? 0 : m_end.back();
+
+  auto i = a_i0;
+  if (!m_id.empty() && m_id.back() == src_id[i]) {
+    // Same channel as our last, extend it.
+    m_end.back() += src_end[i] - v0;
+    ++i;
+  }
+  assert(m_id.empty() || i == a_i1 || m_id.back() < src_id[i]);
+  auto n = m_id.size();
+  m_id.resize(n + (a_i1 - i));
+  m_end.resize(n + (a_i1 - i));
+  auto dst_id = m_id.begin() + n;
+  auto dst_end = m_end.begin() + n;
+  for (; i < a_i1; ++i) {
+    *dst_id++ = src_id[i];
+    *dst_end++ = src_end[i] - v0 + end_prev;
+  }
+
+  auto nv = m_v.size();
+  m_v.resize(nv + (v1 - v0));
+  memcpy(m_v.begin() + nv, a_src.m_v.begin() + v0, (v1 - v0) * sizeof
+      *m_v.begin());
+}
+
+void Value::PushLayout(Value const &a_src, Input::Scalar const *a_v)
+{
+  auto nv = m_v.size();
+  PushChannels(a_src, 0, (uint32_t)a_src.m_id.size());
+  memcpy(m_v.begin() + nv, a_v, (m_v.size() - nv) * sizeof *a_v);
+}
+
+void Value::PushMasked(Value const &a_src, uint32_t a_i1, uint8_t const
+    *a_mask)
+{
+  if (0 == a_i1) {
+    return;
+  }
+  assert(a_i1 <= a_src.m_id.size());
+  assert(m_id.empty() || m_id.back() < a_src.m_id[0]);
+  auto src_id = a_src.m_id.begin();
+  auto src_end = a_src.m_end.begin();
+  auto src_v = a_src.m_v.begin();
+  auto v1 = src_end[a_i1 - 1];
+
+  // Size for everything surviving, then trim.
+  auto n = m_id.size();
+  auto nv = m_v.size();
+  m_id.resize(n + a_i1);
+  m_end.resize(n + a_i1);
+  m_v.resize(nv + v1);
+  auto dst_id = m_id.begin() + n;
+  auto dst_end = m_end.begin() + n;
+  auto v0 = m_v.begin();
+  auto dst_v = v0 + nv;
+  uint32_t vi = 0;
+  for (uint32_t i = 0; i < a_i1; ++i) {
+    auto dst_v_prev = dst_v;
+    for (auto e = src_end[i]; vi < e; ++vi) {
+      // Branch-free compaction, always store and conditionally advance.
+      *dst_v = src_v[vi];
+      dst_v += 0 != a_mask[vi];
+    }
+    if (dst_v != dst_v_prev) {
+      *dst_id++ = src_id[i];
+      *dst_end++ = (uint32_t)(dst_v - v0);
+    }
+  }
+  m_id.resize((size_t)(dst_id - m_id.begin()));
+  m_end.resize((size_t)(dst_end - m_end.begin()));
+  m_v.resize((size_t)(dst_v - v0));
+}
+
 void Value::SetType(Input::Type a_type)
 {
   if (Input::kNone != m_type && a_type != m_type) {
@@ -35,6 +35,9 @@
 
 #define LENGTH(x) (sizeof x / sizeof *x)
 
+// Background estimation is not needed at the full latch rate.
+#define SNIP_PERIOD_MS 1000
+
 extern GuiCollection g_gui;
 
 namespace {
@@ -282,9 +285,140 @@ bool Range::IsAdded() const
   return Input::kNone != m_type;
 }
 
+VisualSlices::VisualSlices(double a_drop_s, unsigned a_num):
+  m_drop_ms(a_drop_s > 0.0 ? (uint64_t)(1000 * a_drop_s) : 0),
+  m_is_decay(0 == a_num),
+  m_slice_vec(std::max(a_num, 1U)),
+  m_sum(),
+  m_active_i(0),
+  m_t_prev(0),
+  m_version(0)
+{
+}
+
+void VisualSlices::Clear()
+{
+  for (auto it = m_slice_vec.begin(); m_slice_vec.end() != it; ++it) {
+    it->Clear();
+  }
+  m_sum.Clear();
+  ++m_version;
+}
+
+// Empties only the slice being filled, keeping the sum consistent.
+void VisualSlices::ClearActive()
+{
+  auto &h = m_slice_vec.at(m_active_i);
+  if (m_slice_vec.size() > 1) {
+    m_sum.Sub(h);
+  }
+  h.Zero();
+  ++m_version;
+}
+
+void VisualSlices::Copy(VisualHistVec *a_dst) const
+{
+  GetSum().Copy(a_dst);
+}
+
+TiledCounts const &VisualSlices::GetSum() const
+{
+  // A single slice is its own sum.
+  return m_slice_vec.size() > 1 ? m_sum : m_slice_vec.at(0);
+}
+
+uint64_t VisualSlices::GetVersion() const
+{
+  return m_version;
+}
+
+void VisualSlices::Add(size_t a_x, size_t a_y, uint64_t a_count)
+{
+  m_slice_vec[m_active_i].Add(a_x, a_y, a_count);
+  if (m_slice_vec.size() > 1) {
+    m_sum.Add(a_x, a_y, a_count);
+  }
+  ++m_version;
+}
+
+void VisualSlices::Inc(size_t a_x, size_t a_y)
+{
+  m_slice_vec[m_active_i].Inc(a_x, a_y);
+  if (m_slice_vec.size() > 1) {
+    m_sum.Inc(a_x, a_y);
+  }
+  ++m_version;
+}
+
+// 1D re-binning goes via 32-bit counts, it's rare enough to not matter.
+void VisualSlices::Rebin1(Gui::Axis const &a_from, Gui::Axis const &a_to)
+{
+  VisualHistVec h;
+  for (auto it = m_slice_vec.begin(); m_slice_vec.end() != it; ++it) {
+    it->Copy(&h);
+    it->Set(::Rebin1(h,
+        a_from.bins, a_from.min, a_from.max,
+        a_to.bins, a_to.min, a_to.max), a_to.bins, 1);
+  }
+  Resum();
+}
+
+void VisualSlices::Rebin2(Gui::Axis const &a_from_x, Gui::Axis const
+    &a_from_y, Gui::Axis const &a_to_x, Gui::Axis const &a_to_y)
+{
+  for (auto it = m_slice_vec.begin(); m_slice_vec.end() != it; ++it) {
+    auto &h = *it;
+    if (0 == h.GetSize()) {
+      h.Resize(a_to_x.bins, a_to_y.bins);
+      continue;
+    }
+    h = ::Rebin2(h,
+        a_from_x.min, a_from_x.max,
+        a_from_y.min, a_from_y.max,
+        a_to_x.bins, a_to_x.min, a_to_x.max,
+        a_to_y.bins, a_to_y.min, a_to_y.max);
+  }
+  Resum();
+}
+
+// Re-binning doesn't commute with summing, so add up the rebinned slices
+// again to be able to subtract them exactly later.
+void VisualSlices::Resum()
+{
+  ++m_version;
+  if (m_slice_vec.size() < 2) {
+    return;
+  }
+  m_sum = m_slice_vec.at(0);
+  for (size_t i = 1; i < m_slice_vec.size(); ++i) {
+    m_sum.Add(m_slice_vec.at(i));
+  }
+}
+
+void VisualSlices::Update()
+{
+  if (0 == m_drop_ms) {
+    return;
+  }
+  auto t_cur = Time_get_ms();
+  if (t_cur <= m_t_prev + m_drop_ms) {
+    return;
+  }
+  m_t_prev = t_cur;
+  if (m_is_decay) {
+    m_slice_vec.at(0).Halve();
+    ++m_version;
+    return;
+  }
+  // Throw away oldest slice and start filling it.
+  m_active_i = (m_active_i + 1) % m_slice_vec.size();
+  ClearActive();
+}
+
 Visual::Visual(std::string const &a_name):
   m_name(a_name),
-  m_gui_id(g_gui.AddPlot(m_name, this))
+  m_gui_id(g_gui.AddPlot(m_name, this)),
+  m_version_latch()
 {
 }
 
@@ -292,6 +426,11 @@ Visual::~Visual()
 {
 }
 
+uint64_t Visual::GetVersion()
+{
+  return m_version_latch;
+}
+
 VisualAnnular::VisualAnnular(std::string const &a_title, double a_r_min,
     double a_r_max, double a_phi0, bool a_is_log_z, double a_drop_counts_s,
     unsigned a_drop_counts_num, double a_drop_stats_s):
@@ -304,8 +443,7 @@ VisualAnnular::VisualAnnular(std::string const &a_title, double a_r_min,
   m_axis_r(),
   m_axis_p(),
   m_hist_mutex(),
-  m_drop_counts_ms((int64_t)(1000 * a_drop_counts_s)),
-  m_hist(a_drop_counts_num),
+  m_hist(a_drop_counts_s, a_drop_counts_num),
   m_axis_r_copy(),
   m_axis_p_copy(),
   m_hist_copy(),
@@ -333,7 +471,7 @@ void VisualAnnular::Fill(Input::Type a_type_r, Input::Scalar const &a_r,
   uint32_t i = (uint32_t)(m_axis_p.bins * dp);
   assert(i < m_axis_p.bins);
   assert(j < m_axis_r.bins);
-  ++m_hist.slice_vec.at(m_hist.active_i).at(i * m_axis_r.bins + j);
+  m_hist.Inc(j, i);
 }
 
 void VisualAnnular::Fit()
@@ -354,15 +492,7 @@ void VisualAnnular::Fit()
         m_axis_p.min != axis_p.min ||
         m_axis_p.max != axis_p.max) {
       // Have to re-bin all slices.
-      auto &v = m_hist.slice_vec;
-      for (auto it = v.begin(); v.end() != it; ++it) {
-        auto &h = *it;
-        h = Rebin2(h,
-            m_axis_r.bins, m_axis_r.min, m_axis_r.max,
-            m_axis_p.bins, m_axis_p.min, m_axis_p.max,
-            axis_r.bins, axis_r.min, axis_r.max,
-            axis_p.bins, axis_p.min, axis_p.max);
-      }
+      m_hist.Rebin2(m_axis_r, m_axis_p, axis_r, axis_p);
       m_axis_r = axis_r;
       m_axis_p = axis_p;
     }
@@ -373,46 +503,22 @@ void VisualAnnular::Latch()
 {
   const std::lock_guard<std::mutex> lock(m_hist_mutex);
 
-  auto &v = m_hist.slice_vec;
-
   if (g_gui.DoClear(m_gui_id)) {
     // TODO: See VisualHist::Latch.
     m_range_r.Clear();
     m_range_p.Clear();
     m_axis_r.Clear();
     m_axis_p.Clear();
-    for (auto it = v.begin(); v.end() != it; ++it) {
-      it->clear();
-    }
+    m_hist.Clear();
   }
 
   m_axis_r_copy = m_axis_r;
   m_axis_p_copy = m_axis_p;
 
-  if (m_drop_counts_ms > 0) {
-    // Update slices, i.e. throw away oldest slice and start filling it.
-    auto t_cur = Time_get_ms();
-    if (t_cur > m_hist.t_prev + (uint64_t)m_drop_counts_ms) {
-      m_hist.active_i = (m_hist.active_i + 1) % v.size();
-      auto &h = v.at(m_hist.active_i);
-      memset(h.data(), 0, h.size() * sizeof h[0]);
-      m_hist.t_prev = t_cur;
-    }
-  }
-
-  if (m_hist_copy.size() != v.at(0).size()) {
-    m_hist_copy.resize(v.at(0).size());
-  }
-
-  // Sum up slices.
-  memcpy(m_hist_copy.data(), v.at(0).data(),
-      m_hist_copy.size() * sizeof m_hist_copy[0]);
-  for (size_t i = 1; i < v.size(); ++i) {
-    auto const &h = v.at(i);
-    assert(m_hist_copy.size() == h.size());
-    for (size_t j = 0; j < h.size(); ++j) {
-      m_hist_copy[j] += h[j];
-    }
+  m_hist.Update();
+  if (m_hist.GetVersion() != m_version_latch) {
+    m_hist.Copy(&m_hist_copy);
+    m_version_latch = m_hist.GetVersion();
   }
 }
 
@@ -427,8 +533,8 @@ void VisualAnnular::Prefill(Input::Type a_type_r, Input::Scalar const &a_r,
 
 VisualHist::VisualHist(std::string const &a_title, uint32_t a_xb,
     LinearTransform const &a_transform, PeakFitVec const &a_fit_vec, bool
-    a_is_log_y, bool a_is_contour, double a_drop_counts_s, unsigned
-    a_drop_counts_num, double a_drop_stats_s):
+    a_is_log_y, bool a_is_contour, uint32_t a_snip_exp, double
+    a_drop_counts_s, unsigned a_drop_counts_num, double a_drop_stats_s):
   Visual(a_title),
   m_xb(a_xb),
   m_transform(a_transform),
@@ -436,29 +542,48 @@ VisualHist::VisualHist(std::string const &a_title, uint32_t a_xb,
   m_range(a_drop_stats_s),
   m_axis(),
   m_hist_mutex(),
-  m_drop_counts_ms((int64_t)(1000 * a_drop_counts_s)),
-  m_hist(a_drop_counts_num),
+  m_hist(a_drop_counts_s, a_drop_counts_num),
   m_axis_copy(),
   m_hist_copy(),
+  m_pyramid(),
   m_is_log_y(a_is_log_y),
   m_is_contour(a_is_contour),
-  m_peak_vec()
+  m_snip_exp(a_snip_exp),
+  m_fit_job(this),
+  m_fit_mutex(),
+  m_fit(),
+  m_peak_vec(),
+  m_bg_vec(),
+  m_peak_version()
+{
+  m_fit.axis.Clear();
+  m_fit.work_axis.Clear();
+  m_fit.param_vec.resize(m_fit_vec.size());
+}
+
+VisualHist::~VisualHist()
+{
+  m_fit_job.Cancel();
+}
+
+VisualHist::FitJob::FitJob(VisualHist *a_visual):
+  Job(),
+  m_visual(a_visual)
 {
 }
 
+void VisualHist::FitJob::Run()
+{
+  m_visual->FitRun();
+}
+
 void VisualHist::Draw(Gui *a_gui)
 {
   if (m_hist_copy.empty()) {
     return;
   }
-
-  // Fitting at 1 Hz should be fine?
-  if (!m_fit_vec.empty()) {
-    FitGauss(m_hist_copy, m_axis_copy, m_fit_vec);
-  }
-
   g_gui.DrawHist1(a_gui, m_gui_id, m_axis_copy, m_transform, m_is_log_y,
-      m_is_contour, m_hist_copy, m_peak_vec);
+      m_is_contour, m_hist_copy, m_pyramid, m_peak_vec, m_bg_vec);
 }
 
 void VisualHist::Fill(Input::Type a_type, Input::Scalar const &a_x)
@@ -468,7 +593,13 @@ void VisualHist::Fill(Input::Type a_type, Input::Scalar const &a_x)
   auto dx = SubTyped(a_type, m_axis, a_x);
   uint32_t i = (uint32_t)(m_axis.bins * dx);
   assert(i < m_axis.bins);
-  ++m_hist.slice_vec.at(m_hist.active_i).at(i);
+  m_hist.Inc(i, 0);
+}
+
+uint64_t VisualHist::GetVersion()
+{
+  // New fit results must also be drawn.
+  return m_version_latch + m_peak_version;
 }
 
 void VisualHist::Fit()
@@ -482,13 +613,7 @@ void VisualHist::Fit()
         m_axis.min != axis.min ||
         m_axis.max != axis.max) {
       // Have to re-bin all slices.
-      auto &v = m_hist.slice_vec;
-      for (auto it = v.begin(); v.end() != it; ++it) {
-        auto &h = *it;
-        h = Rebin1(h,
-            m_axis.bins, m_axis.min, m_axis.max,
-            axis.bins, axis.min, axis.max);
-      }
+      m_hist.Rebin1(m_axis, axis);
       m_axis = axis;
     }
   }
@@ -500,43 +625,64 @@ void VisualHist::Latch()
   // tries to figure out ranges, so a locked copy is important!
   const std::lock_guard<std::mutex> lock(m_hist_mutex);
 
-  auto &v = m_hist.slice_vec;
-
   if (g_gui.DoClear(m_gui_id)) {
     // We should clear.
     // TODO: Clear all, or just histogram contents?
     m_range.Clear();
     m_axis.Clear();
-    for (auto it = v.begin(); v.end() != it; ++it) {
-      it->clear();
-    }
+    m_hist.Clear();
   }
 
   m_axis_copy = m_axis;
 
-  if (m_drop_counts_ms > 0) {
-    // Update slices, i.e. throw away oldest slice and start filling it.
-    auto t_cur = Time_get_ms();
-    if (t_cur > m_hist.t_prev + (uint64_t)m_drop_counts_ms) {
-      m_hist.active_i = (m_hist.active_i + 1) % v.size();
-      auto &h = v.at(m_hist.active_i);
-      memset(h.data(), 0, h.size() * sizeof h[0]);
-      m_hist.t_prev = t_cur;
+  m_hist.Update();
+  if (m_hist.GetVersion() != m_version_latch) {
+    m_hist.Copy(&m_hist_copy);
+    m_version_latch = m_hist.GetVersion();
+    // Built here on the latch worker so zoomed-out drawing is cheap.
+    m_pyramid.Build(m_hist_copy);
+    if (!m_fit_vec.empty() || m_snip_exp > 0) {
+      uint64_t sum = 0;
+      for (auto it = m_hist_copy.begin(); m_hist_copy.end() != it; ++it) {
+        sum += *it;
+      }
+      auto t_cur = Time_get_ms();
+      const std::lock_guard<std::mutex> lock_fit(m_fit_mutex);
+      bool is_axis_new =
+          m_fit.axis.bins != m_axis_copy.bins ||
+          m_fit.axis.min != m_axis_copy.min ||
+          m_fit.axis.max != m_axis_copy.max;
+      // Only re-fit when the shape can have changed noticeably, and the
+      // background is only refreshed at a low rate.
+      bool do_fit = !m_fit_vec.empty() &&
+          (is_axis_new ||
+           sum < m_fit.sum ||
+           sum - m_fit.sum > m_fit.sum / 100);
+      bool do_snip = m_snip_exp > 0 &&
+          (is_axis_new || m_fit.t_snip + SNIP_PERIOD_MS <= t_cur);
+      if (do_fit || do_snip) {
+        m_fit.hist = m_hist_copy;
+        m_fit.axis = m_axis_copy;
+        if (do_fit) {
+          m_fit.sum = sum;
+          m_fit.do_fit = true;
+        }
+        if (do_snip) {
+          m_fit.t_snip = t_cur;
+          m_fit.do_snip = true;
+        }
+        m_fit_job.Queue();
+      }
     }
   }
 
-  if (m_hist_copy.size() != v.at(0).size()) {
-    m_hist_copy.resize(v.at(0).size());
-  }
-
-  // Sum up slices.
-  memcpy(m_hist_copy.data(), v.at(0).data(),
-      m_hist_copy.size() * sizeof m_hist_copy[0]);
-  for (size_t i = 1; i < v.size(); ++i) {
-    auto const &h = v.at(i);
-    assert(m_hist_copy.size() == h.size());
-    for (size_t j = 0; j < h.size(); ++j) {
-      m_hist_copy[j] += h[j];
+  if (!m_fit_vec.empty() || m_snip_exp > 0) {
+    const std::lock_guard<std::mutex> lock_fit(m_fit_mutex);
+    if (m_fit.is_new) {
+      m_peak_vec = m_fit.peak_vec;
+      m_bg_vec = m_fit.bg_vec;
+      m_fit.is_new = false;
+      ++m_peak_version;
     }
   }
 }
@@ -550,9 +696,12 @@ void VisualHist::Prefill(Input::Type a_type, Input::Scalar const &a_x)
 
 // Fitters must work on given copy and not look at the ever-changing m_hist!
 void VisualHist::FitGauss(std::vector<uint32_t> const &a_hist, Gui::Axis const
-    &a_axis, PeakFitVec const &a_fit_vec)
+    &a_axis, PeakFitVec const &a_fit_vec, std::vector<Gui::Peak> *a_peak_vec)
 {
-  m_peak_vec.clear();
+  a_peak_vec->clear();
+  if (a_hist.empty()) {
+    return;
+  }
   auto scale = (a_axis.max - a_axis.min) / (double)a_hist.size();
   for (auto it = a_fit_vec.begin(); a_fit_vec.end() != it; ++it) {
     // Fit left..right in histo.
@@ -567,6 +716,7 @@ void VisualHist::FitGauss(std::vector<uint32_t> const &a_hist, Gui::Axis const
     for (uint32_t i = l_u; i <= r_u; ++i) {
       max_y = std::max(max_y, (uint32_t)a_hist.at(i));
     }
+    auto &params = m_fit.param_vec.at((size_t)(it - a_fit_vec.begin()));
     bool has_exp = it->name.npos != it->name.find("exp");
     bool has_gauss = it->name.npos != it->name.find("gauss");
     try {
@@ -577,7 +727,7 @@ void VisualHist::FitGauss(std::vector<uint32_t> const &a_hist, Gui::Axis const
       double gau_mean = 0.0;
       double gau_std = 0.0;
       if (has_exp && has_gauss) {
-        ::FitExpGauss fit(a_hist, max_y, l_u, r_u);
+        ::FitExpGauss fit(a_hist, max_y, l_u, r_u, &params);
         if (fit.GetGaussAmp() > 0) {
           // Reasonable fit, save peak.
           y = fit.GetY();
@@ -587,23 +737,71 @@ void VisualHist::FitGauss(std::vector<uint32_t> const &a_hist, Gui::Axis const
           gau_amp = fit.GetGaussAmp();
           gau_mean = a_axis.min + (fit.GetGaussMean() + 0.5) * scale;
           gau_std = fit.GetGaussStd() * scale;
+        } else {
+          // Don't warm-start from garbage.
+          params.is_set = false;
         }
       } else if (has_gauss) {
-        ::FitGauss fit(a_hist, max_y, l_u, r_u);
+        ::FitGauss fit(a_hist, max_y, l_u, r_u, &params);
         if (fit.GetAmp() > 0) {
           y = fit.GetY();
           gau_amp = fit.GetAmp();
           auto mean = fit.GetMean() + 0.5;
           gau_mean = a_axis.min + mean * scale;
           gau_std = fit.GetStd() * scale;
+        } else {
+          params.is_set = false;
         }
       }
-      m_peak_vec.push_back(Gui::Peak(
+      a_peak_vec->push_back(Gui::Peak(
           y,
           has_exp, exp_phase, exp_tau,
           has_gauss, gau_amp, gau_mean, gau_std));
     } catch (...) {
+      params.is_set = false;
+    }
+  }
+}
+
+void VisualHist::FitRun()
+{
+  bool do_fit;
+  bool do_snip;
+  {
+    const std::lock_guard<std::mutex> lock(m_fit_mutex);
+    m_fit.work.swap(m_fit.hist);
+    do_fit = m_fit.do_fit;
+    do_snip = m_fit.do_snip;
+    m_fit.do_fit = false;
+    m_fit.do_snip = false;
+    if (m_fit.work_axis.bins != m_fit.axis.bins ||
+        m_fit.work_axis.min != m_fit.axis.min ||
+        m_fit.work_axis.max != m_fit.axis.max) {
+      // Old parameters are in the wrong bins.
+      for (auto it = m_fit.param_vec.begin(); m_fit.param_vec.end() != it;
+          ++it) {
+        it->is_set = false;
+      }
+      m_fit.work_axis = m_fit.axis;
+    }
+  }
+  std::vector<Gui::Peak> peak_vec;
+  if (do_fit) {
+    FitGauss(m_fit.work, m_fit.work_axis, m_fit_vec, &peak_vec);
+  }
+  std::vector<float> bg_vec;
+  if (do_snip) {
+    Snip(m_fit.work, m_snip_exp, &m_fit.snip_buf, &bg_vec);
+  }
+  {
+    const std::lock_guard<std::mutex> lock(m_fit_mutex);
+    if (do_fit) {
+      m_fit.peak_vec.swap(peak_vec);
+    }
+    if (do_snip) {
+      m_fit.bg_vec.swap(bg_vec);
     }
+    m_fit.is_new = true;
   }
 }
 
@@ -621,12 +819,13 @@ VisualHist2::VisualHist2(std::string const &a_title, uint32_t a_xb, uint32_t
   m_axis_x(),
   m_axis_y(),
   m_hist_mutex(),
-  m_drop_counts_ms((int64_t)(1000 * a_drop_counts_s)),
-  m_hist(a_drop_counts_num),
+  m_hist(a_drop_counts_s, a_drop_counts_num),
   m_axis_x_copy(),
   m_axis_y_copy(),
   m_hist_copy(),
   m_is_log_z(a_is_log_z),
+  m_outer_x(),
+  m_outer_y(),
   m_single()
 {
   m_single.time_ms = a_single < 0.0
@@ -638,7 +837,7 @@ VisualHist2::VisualHist2(std::string const &a_title, uint32_t a_xb, uint32_t
 
 void VisualHist2::Draw(Gui *a_gui)
 {
-  if (m_hist_copy.empty()) {
+  if (0 == m_hist_copy.GetSize()) {
     return;
   }
   g_gui.DrawHist2(a_gui, m_gui_id, m_axis_x_copy, m_axis_y_copy,
@@ -656,7 +855,55 @@ void VisualHist2::Fill(Input::Type a_type_x, Input::Scalar const &a_x,
   uint32_t i = (uint32_t)(m_axis_y.bins * dy);
   assert(i < m_axis_y.bins);
   assert(j < m_axis_x.bins);
-  ++m_hist.slice_vec.at(m_hist.active_i).at(i * m_axis_x.bins + j);
+  m_hist.Inc(j, i);
+}
+
+void VisualHist2::FillOuter(
+    Input::Type a_type_x, Vector<Input::Scalar> const &a_vec_x,
+    Input::Type a_type_y, Vector<Input::Scalar> const &a_vec_y)
+{
+  if (a_vec_x.empty() || a_vec_y.empty()) {
+    return;
+  }
+
+  const std::lock_guard<std::mutex> lock(m_hist_mutex);
+
+  OuterBin(a_type_x, a_vec_x, m_axis_x, &m_outer_x);
+  OuterBin(a_type_y, a_vec_y, m_axis_y, &m_outer_y);
+  for (auto ity = m_outer_y.used.begin(); m_outer_y.used.end() != ity;
+      ++ity) {
+    auto i = *ity;
+    uint64_t cy = m_outer_y.count[i];
+    for (auto itx = m_outer_x.used.begin(); m_outer_x.used.end() != itx;
+        ++itx) {
+      auto j = *itx;
+      m_hist.Add(j, i, cy * m_outer_x.count[j]);
+    }
+  }
+  // Only touched bins need zeroing.
+  for (auto it = m_outer_x.used.begin(); m_outer_x.used.end() != it; ++it) {
+    m_outer_x.count[*it] = 0;
+  }
+  for (auto it = m_outer_y.used.begin(); m_outer_y.used.end() != it; ++it) {
+    m_outer_y.count[*it] = 0;
+  }
+}
+
+void VisualHist2::OuterBin(Input::Type a_type, Vector<Input::Scalar> const
+    &a_vec, Gui::Axis const &a_axis, OuterAxis *a_outer)
+{
+  if (a_outer->count.size() != a_axis.bins) {
+    a_outer->count.assign(a_axis.bins, 0);
+  }
+  a_outer->used.clear();
+  for (auto it = a_vec.begin(); a_vec.end() != it; ++it) {
+    auto d = SubTyped(a_type, a_axis, *it);
+    uint32_t b = (uint32_t)(a_axis.bins * d);
+    assert(b < a_axis.bins);
+    if (0 == a_outer->count[b]++) {
+      a_outer->used.push_back(b);
+    }
+  }
 }
 
 void VisualHist2::Fit()
@@ -677,15 +924,7 @@ void VisualHist2::Fit()
         m_axis_y.min != axis_y.min ||
         m_axis_y.max != axis_y.max) {
       // Have to re-bin all slices.
-      auto &v = m_hist.slice_vec;
-      for (auto it = v.begin(); v.end() != it; ++it) {
-        auto &h = *it;
-        h = Rebin2(h,
-            m_axis_x.bins, m_axis_x.min, m_axis_x.max,
-            m_axis_y.bins, m_axis_y.min, m_axis_y.max,
-            axis_x.bins, axis_x.min, axis_x.max,
-            axis_y.bins, axis_y.min, axis_y.max);
-      }
+      m_hist.Rebin2(m_axis_x, m_axis_y, axis_x, axis_y);
       m_axis_x = axis_x;
       m_axis_y = axis_y;
     }
@@ -710,46 +949,22 @@ void VisualHist2::Latch()
 {
   const std::lock_guard<std::mutex> lock(m_hist_mutex);
 
-  auto &v = m_hist.slice_vec;
-
   if (g_gui.DoClear(m_gui_id)) {
     // TODO: See VisualHist::Latch.
     m_range_x.Clear();
     m_range_y.Clear();
     m_axis_x.Clear();
     m_axis_y.Clear();
-    for (auto it = v.begin(); v.end() != it; ++it) {
-      it->clear();
-    }
+    m_hist.Clear();
   }
 
   m_axis_x_copy = m_axis_x;
   m_axis_y_copy = m_axis_y;
 
-  if (m_drop_counts_ms > 0) {
-    // Update slices, i.e. throw away oldest slice and start filling it.
-    auto t_cur = Time_get_ms();
-    if (t_cur > m_hist.t_prev + (uint64_t)m_drop_counts_ms) {
-      m_hist.active_i = (m_hist.active_i + 1) % v.size();
-      auto &h = v.at(m_hist.active_i);
-      memset(h.data(), 0, h.size() * sizeof h[0]);
-      m_hist.t_prev = t_cur;
-    }
-  }
-
-  if (m_hist_copy.size() != v.at(0).size()) {
-    m_hist_copy.resize(v.at(0).size());
-  }
-
-  // Sum up slices.
-  memcpy(m_hist_copy.data(), v.at(0).data(),
-      m_hist_copy.size() * sizeof m_hist_copy[0]);
-  for (size_t i = 1; i < v.size(); ++i) {
-    auto const &h = v.at(i);
-    assert(m_hist_copy.size() == h.size());
-    for (size_t j = 0; j < h.size(); ++j) {
-      m_hist_copy[j] += h[j];
-    }
+  m_hist.Update();
+  if (m_hist.GetVersion() != m_version_latch) {
+    m_hist_copy = m_hist.GetSum();
+    m_version_latch = m_hist.GetVersion();
   }
 }
 
@@ -759,11 +974,34 @@ void VisualHist2::Prefill(Input::Type a_type_x, Input::Scalar const &a_x,
   const std::lock_guard<std::mutex> lock(m_hist_mutex);
 
   if (m_single.do_clear) {
-    auto &h = m_hist.slice_vec.at(0);
-    memset(h.data(), 0, h.size() * sizeof h[0]);
+    m_hist.ClearActive();
     m_single.do_clear = false;
   }
 
   m_range_x.Add(a_type_x, a_x);
   m_range_y.Add(a_type_y, a_y);
 }
+
+void VisualHist2::PrefillOuter(
+    Input::Type a_type_x, Vector<Input::Scalar> const &a_vec_x,
+    Input::Type a_type_y, Vector<Input::Scalar> const &a_vec_y)
+{
+  if (a_vec_x.empty() || a_vec_y.empty()) {
+    return;
+  }
+
+  const std::lock_guard<std::mutex> lock(m_hist_mutex);
+
+  if (m_single.do_clear) {
+    m_hist.ClearActive();
+    m_single.do_clear = false;
+  }
+
+  // Every value is in some pair, each is added once.
+  for (auto it = a_vec_x.begin(); a_vec_x.end() != it; ++it) {
+    m_range_x.Add(a_type_x, *it);
+  }
+  for (auto it = a_vec_y.begin(); a_vec_y.end() != it; ++it) {
+    m_range_y.Add(a_type_y, *it);
+  }
+}
@@ -38,32 +38,69 @@ void MyTest::Run()
 {
   {
     // Single fine-time.
-    CalFineTime c;
+    CalFineTable c;
     for (uint32_t i = 0; i < 1000; ++i) {
-      TEST_CMP(c.Get(0), <, 1e-6);
+      TEST_CMP(c.Get(0, 0), <, 1e-6);
     }
   }
 
   {
     // Two fine-times at 3:1 occurrence.
-    CalFineTime c;
+    CalFineTable c;
     for (uint32_t i = 0; i < 1000; ++i) {
-      c.Get((i & 3) / 3);
+      c.Get(0, (i & 3) / 3);
     }
-    TEST_CMP(c.Get(0), <, 1e-6);
-    TEST_CMP(std::abs(c.Get(1) - 0.75), <, 1 / (1000 / 2.));
+    TEST_CMP(c.Get(0, 0), <, 1e-6);
+    TEST_CMP(std::abs(c.Get(0, 1) - 0.75), <, 1 / (1000 / 2.));
   }
 
   {
     // Lots of uniform fine-times.
-    CalFineTime c;
+    CalFineTable c;
     for (uint32_t i = 0; i < 10000; ++i) {
-      c.Get(i & 127);
+      c.Get(0, i & 127);
     }
     for (uint32_t i = 0; i < 128; ++i) {
-      TEST_CMP(std::abs(c.Get(i) - i/128.0), <, 1 / (10000 / 128.));
+      TEST_CMP(std::abs(c.Get(0, i) - i/128.0), <, 1 / (10000 / 128.));
     }
   }
+
+  {
+    // Channels are independent, and growing the table keeps calibrations.
+    CalFineTable c;
+    std::vector<uint32_t> fine(100);
+    std::vector<double> ft(100);
+    for (uint32_t i = 0; i < 100; ++i) {
+      fine[i] = i & 7;
+    }
+    c.GetMany(0, fine.data(), fine.size(), ft.data());
+    TEST_CMP(std::abs(ft[5] - 5/8.0), <, 1 / (100 / 8.));
+    for (uint32_t i = 0; i < 100; ++i) {
+      fine[i] = 100 + (i & 1);
+    }
+    c.GetMany(3, fine.data(), fine.size(), ft.data());
+    TEST_CMP(ft[0], <, 1e-6);
+    TEST_CMP(std::abs(ft[1] - 0.5), <, 1e-6);
+    TEST_CMP(std::abs(c.Get(0, 5) - 5/8.0), <, 1 / (100 / 8.));
+    // Beyond the calibrated range clamps.
+    TEST_CMP(std::abs(c.Get(0, 50) - c.Get(0, 7)), <, 1e-6);
+    TEST_CMP(c.Get(0, 0x3ff), <, 1e-6);
+  }
+
+  {
+    // Huge fine-times are not accounted and don't grow the tables.
+    CalFineTable c;
+    for (uint32_t i = 0; i < 1000; ++i) {
+      c.Get(0, i & 7);
+    }
+    auto ft7 = c.Get(0, 7);
+    TEST_CMP(std::abs(c.Get(0, 0x80000000) - ft7), <, 1e-6);
+    TEST_CMP(std::abs(c.Get(0, 0xffffffff) - ft7), <, 1e-6);
+    TEST_CMP(std::abs(c.Get(0, 5) - 5/8.0), <, 1 / (1000 / 8.));
+    std::vector<uint8_t> blob;
+    c.StateSave(&blob);
+    TEST_CMP(blob.size(), <, 1000UL);
+  }
 }
 
 }
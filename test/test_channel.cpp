@@ -0,0 +1,185 @@
+/*
+ * plutt, a scriptable monitor for experimental data.
+ *
+ * Copyright (C) 2025
+ * Hans Toshihide Toernqvist <hans.tornqvist@chalmers.se>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <channel.hpp>
+#include <test/test.hpp>
+
+namespace {
+
+class MyTest: public Test {
+  void Run();
+};
+MyTest g_test_channel_;
+
+// Channel i gets id a_ids[i] and (id % 3 + 1) hits with value 1000 * id + j.
+void Fill(Value *a_val, std::vector<uint32_t> const &a_ids)
+{
+  a_val->Clear();
+  a_val->SetType(Input::kUint64);
+  for (auto it = a_ids.begin(); a_ids.end() != it; ++it) {
+    for (uint32_t j = 0; j < *it % 3 + 1; ++j) {
+      Input::Scalar s;
+      s.u64 = 1000 * *it + j;
+      a_val->Push(*it, s);
+    }
+  }
+}
+
+std::vector<uint32_t> Ids(uint32_t a_n, uint32_t a_step, uint32_t a_ofs)
+{
+  std::vector<uint32_t> v;
+  for (uint32_t i = 0; i < a_n; ++i) {
+    v.push_back(a_ofs + i * a_step);
+  }
+  return v;
+}
+
+void MyTest::Run()
+{
+  // Seeking, check against a linear scan from every start.
+  {
+    Value v;
+    Fill(&v, Ids(50, 3, 2));
+    auto const &vid = v.GetID();
+    for (uint32_t from = 0; from <= vid.size(); ++from) {
+      for (uint32_t target = 0; target < 160; ++target) {
+        uint32_t ref = from;
+        while (ref < vid.size() && vid[ref] < target) {
+          ++ref;
+        }
+        TEST_CMP(ChannelSeek(vid, from, target), ==, ref);
+      }
+    }
+  }
+
+  // Ranges.
+  {
+    Value v;
+    Fill(&v, Ids(10, 2, 0));
+    uint32_t i0, i1;
+    ChannelRange(v, 3, 9, &i0, &i1);
+    TEST_CMP(i0, ==, 2U);
+    TEST_CMP(i1, ==, 5U);
+    ChannelRange(v, 18, UINT32_MAX, &i0, &i1);
+    TEST_CMP(i0, ==, 9U);
+    TEST_CMP(i1, ==, 10U);
+    ChannelRange(v, 19, 30, &i0, &i1);
+    TEST_CMP(i0, ==, i1);
+  }
+
+  // Intersections, similar sizes and sparse against dense.
+  {
+    uint32_t const c_step[][2] = {{2, 3}, {1, 17}, {29, 1}};
+    for (unsigned k = 0; k < 3; ++k) {
+      Value l, r;
+      Fill(&l, Ids(200 / c_step[k][0], c_step[k][0], 0));
+      Fill(&r, Ids(200 / c_step[k][1], c_step[k][1], 1));
+      std::vector<ChannelPair> pair_vec;
+      ChannelIntersect(l, r, &pair_vec);
+      std::vector<ChannelPair> ref_vec;
+      for (uint32_t i = 0; i < l.GetID().size(); ++i) {
+        for (uint32_t j = 0; j < r.GetID().size(); ++j) {
+          if (l.GetID()[i] == r.GetID()[j]) {
+            ChannelPair p;
+            p.l = i;
+            p.r = j;
+            ref_vec.push_back(p);
+          }
+        }
+      }
+      TEST_CMP(pair_vec.size(), ==, ref_vec.size());
+      for (size_t i = 0; i < std::min(pair_vec.size(), ref_vec.size()); ++i)
+      {
+        TEST_CMP(pair_vec[i].l, ==, ref_vec[i].l);
+        TEST_CMP(pair_vec[i].r, ==, ref_vec[i].r);
+      }
+    }
+  }
+
+  // Bulk copies, also into a channel that is already there.
+  {
+    Value src;
+    Fill(&src, Ids(5, 1, 10));
+    Value dst;
+    dst.SetType(Input::kUint64);
+    Input::Scalar s;
+    s.u64 = 1;
+    dst.Push(11, s);
+    dst.PushChannels(src, 1, 4);
+    TEST_CMP(dst.GetID().size(), ==, 3U);
+    TEST_CMP(dst.GetID()[0], ==, 11U);
+    TEST_CMP(dst.GetID()[2], ==, 13U);
+    // 11 has 3 hits in src, 12 has 1 and 13 has 2.
+    TEST_CMP(dst.GetEnd()[0], ==, 4U);
+    TEST_CMP(dst.GetEnd()[1], ==, 5U);
+    TEST_CMP(dst.GetEnd()[2], ==, 7U);
+    TEST_CMP(dst.GetV()[1].u64, ==, 11000U);
+    TEST_CMP(dst.GetV()[6].u64, ==, 13001U);
+  }
+
+  // k-way merge, check that copying the runs gives the sorted union.
+  {
+    Value a, b, c;
+    Fill(&a, Ids(20, 1, 0));
+    Fill(&b, Ids(5, 7, 3));
+    Fill(&c, Ids(3, 1, 100));
+    ChannelMerge merge;
+    merge.Add(&a);
+    merge.Add(&b);
+    merge.Add(&c);
+    Value dst;
+    dst.SetType(Input::kUint64);
+    std::vector<ChannelRun> run_vec;
+    Value const *src[] = {&a, &b, &c};
+    unsigned next_num = 0;
+    while (merge.Next(&run_vec)) {
+      for (auto it = run_vec.begin(); run_vec.end() != it; ++it) {
+        dst.PushChannels(*src[it->src], it->i0, it->i1);
+      }
+      ++next_num;
+    }
+    // a alone 0..2, a+b at 3, a alone 4..9, a+b at 10, ..., c alone.
+    TEST_CMP(next_num, ==, 9U);
+    auto const &vid = dst.GetID();
+    uint32_t hits = 0;
+    for (uint32_t i = 0; i < vid.size(); ++i) {
+      if (i > 0) {
+        TEST_CMP(vid[i - 1], <, vid[i]);
+      }
+      auto v0 = 0 == i ? 0 : dst.GetEnd()[i - 1];
+      auto v1 = dst.GetEnd()[i];
+      // Channels in both a and b get hits from both, in source order.
+      bool is_both = vid[i] < 20 && vid[i] >= 3 && 0 == (vid[i] - 3) % 7;
+      TEST_CMP(v1 - v0, ==, (vid[i] % 3 + 1) * (is_both ? 2U : 1U));
+      TEST_CMP(dst.GetV()[v0].u64, ==, 1000U * vid[i]);
+      hits += v1 - v0;
+    }
+    TEST_CMP(vid.size(), ==, 20U + 2U + 3U);
+    TEST_CMP(dst.GetV().size(), ==, (size_t)hits);
+  }
+}
+
+}
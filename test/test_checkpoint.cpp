@@ -0,0 +1,146 @@
+/*
+ * plutt, a scriptable monitor for experimental data.
+ *
+ * Copyright (C) 2025
+ * Hans Toshihide Toernqvist <hans.tornqvist@chalmers.se>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+#include <unistd.h>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <cal.hpp>
+#include <checkpoint.hpp>
+#include <node_pedestal.hpp>
+#include <test/mock_node.hpp>
+#include <test/test.hpp>
+
+namespace {
+
+class MyTest: public Test {
+  void Run();
+};
+MyTest g_test_checkpoint_;
+
+class MockNode: public MockNodeValue {
+  public:
+    MOCK_NODE_VALUE(MockNode)
+    void ProcessUser()
+    {
+      m_value[0].Clear();
+      Input::Scalar s;
+      s.u64 = 10 + (rand() & 3);
+      m_value[0].Push(4, s);
+    }
+};
+
+void MyTest::Run()
+{
+  char dir[] = "/tmp/plutt_test_checkpoint.XXXXXX";
+  TEST_BOOL(nullptr != mkdtemp(dir));
+  auto path_str = std::string(dir) + "/state";
+  auto path = path_str.c_str();
+
+  {
+    // Blob round-trip and truncation.
+    std::vector<uint8_t> blob;
+    std::vector<double> v_in = {1.5, 2.5};
+    uint32_t u_in = 17;
+    StatePut(&blob, &u_in, sizeof u_in);
+    StatePutVec(&blob, v_in);
+    size_t ofs = 0;
+    uint32_t u_out;
+    std::vector<double> v_out;
+    TEST_BOOL(StateGet(blob, &ofs, &u_out, sizeof u_out));
+    TEST_BOOL(StateGetVec(blob, &ofs, &v_out));
+    TEST_CMP(u_out, ==, 17U);
+    TEST_CMP(v_out.size(), ==, 2U);
+    TEST_CMP(v_out[1], ==, 2.5);
+    TEST_CMP(ofs, ==, blob.size());
+    blob.pop_back();
+    ofs = sizeof u_out;
+    TEST_BOOL(!StateGetVec(blob, &ofs, &v_out));
+  }
+
+  {
+    // File round-trip.
+    Checkpoint c;
+    c.Put("a", std::vector<uint8_t>{1, 2, 3});
+    c.Put("b", std::vector<uint8_t>());
+    TEST_BOOL(c.Save(path));
+    Checkpoint d;
+    TEST_BOOL(d.Load(path));
+    std::vector<uint8_t> const *blob;
+    TEST_BOOL(d.Get("a", &blob));
+    TEST_CMP(blob->size(), ==, 3U);
+    TEST_CMP((*blob)[2], ==, 3);
+    TEST_BOOL(d.Get("b", &blob));
+    TEST_BOOL(blob->empty());
+    TEST_BOOL(!d.Get("c", &blob));
+    remove(path);
+    TEST_BOOL(!d.Load(path));
+    rmdir(dir);
+  }
+
+  {
+    // Restored fine-time calibration converts from the first hit.
+    CalFineTable c;
+    for (uint32_t i = 0; i < 1000; ++i) {
+      c.Get(2, i & 31);
+    }
+    std::vector<uint8_t> blob;
+    c.StateSave(&blob);
+    CalFineTable d;
+    size_t ofs = 0;
+    TEST_BOOL(d.StateLoad(blob, &ofs));
+    TEST_CMP(ofs, ==, blob.size());
+    TEST_CMP(std::abs(d.Get(2, 16) - 0.5), <, 0.05);
+    blob.resize(blob.size() / 2);
+    ofs = 0;
+    TEST_BOOL(!d.StateLoad(blob, &ofs));
+  }
+
+  {
+    // Restored pedestal subtracts from the first event.
+    MockNode nv(Input::kUint64, 1);
+    NodePedestal n("", &nv, 0.1, nullptr);
+    nv.Preprocess(&n);
+    for (unsigned i = 0; i < 1000; ++i) {
+      TestNodeProcess(n, 1 + i);
+    }
+    std::vector<uint8_t> blob;
+    n.StateSave(&blob);
+
+    MockNode nv2(Input::kUint64, 1);
+    NodePedestal n2("", &nv2, 0.1, nullptr);
+    TEST_BOOL(n2.StateLoad(blob));
+    TEST_BOOL(!n2.StateLoad(std::vector<uint8_t>(3)));
+    nv2.Preprocess(&n2);
+    TestNodeProcess(n2, 1);
+    auto const &s = n2.GetValue(1);
+    TEST_CMP(s.GetV().size(), ==, 1U);
+    TEST_CMP(std::abs(s.GetV(0, false) - 1.1), <, 0.2);
+  }
+}
+
+}
@@ -20,7 +20,9 @@
  * MA  02110-1301  USA
  */
 
+#include <cmath>
 #include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <map>
 #include <string>
@@ -35,6 +37,22 @@ class MyTest: public Test {
 };
 MyTest g_test_cut_;
 
+// Plain even-odd crossing test to compare with.
+bool RefTest(std::vector<CutPolygon::Point> const &a_vec, double a_x, double
+    a_y)
+{
+  bool is_in = false;
+  for (size_t i = 0, j = a_vec.size() - 1; i < a_vec.size(); j = i++) {
+    auto const &p = a_vec[i];
+    auto const &q = a_vec[j];
+    if ((p.y > a_y) != (q.y > a_y) &&
+        a_x < (q.x - p.x) * (a_y - p.y) / (q.y - p.y) + p.x) {
+      is_in = !is_in;
+    }
+  }
+  return is_in;
+}
+
 void MyTest::Run()
 {
   // 1d.
@@ -124,6 +142,53 @@ void MyTest::Run()
     TEST_BOOL(c.Test(1e-6, 0));
     TEST_BOOL(c.Test(0, 1e-6));
   }
+  {
+    // Concave star, grid cells must agree with the exact test.
+    CutPolygon c("c4", false);
+    std::vector<CutPolygon::Point> vec;
+    for (int i = 0; i < 10; ++i) {
+      auto r = i & 1 ? 0.3 : 1.0;
+      auto a = i * M_PI / 5;
+      vec.push_back(CutPolygon::Point(r * cos(a), 0.5 * r * sin(a)));
+      c.AddPoint(vec.back().x, vec.back().y);
+    }
+    unsigned mismatch_num = 0;
+    for (int i = 0; i < 20000; ++i) {
+      auto x = 2.4 * rand() / RAND_MAX - 1.2;
+      auto y = 1.2 * rand() / RAND_MAX - 0.6;
+      mismatch_num += c.Test(x, y) != RefTest(vec, x, y);
+    }
+    TEST_CMP(mismatch_num, ==, 0U);
+  }
+  {
+    // Many polygons in one producer, event flags must stay put.
+    std::vector<CutPolygon *> poly_vec;
+    std::vector<bool *> is_ok_vec;
+    CutProducerList producer;
+    for (int i = 0; i < 70; ++i) {
+      auto p = new CutPolygon("", false);
+      p->AddPoint(i, 0.0);
+      p->AddPoint(i + 1, 0.0);
+      p->AddPoint(i + 1, 1.0);
+      p->AddPoint(i, 1.0);
+      poly_vec.push_back(p);
+      is_ok_vec.push_back(producer.AddEvent(p));
+    }
+    // Same polygon again shares the test.
+    auto is_ok_dup = producer.AddEvent(poly_vec[65]);
+    producer.Reset();
+    Input::Scalar x, y;
+    x.dbl = 65.5;
+    y.dbl = 0.5;
+    producer.Test(Input::kDouble, x, Input::kDouble, y);
+    for (int i = 0; i < 70; ++i) {
+      TEST_BOOL(65 == i ? *is_ok_vec[(size_t)i] : !*is_ok_vec[(size_t)i]);
+    }
+    TEST_BOOL(*is_ok_dup);
+    for (auto it = poly_vec.begin(); poly_vec.end() != it; ++it) {
+      delete *it;
+    }
+  }
 }
 
 }
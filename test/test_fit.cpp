@@ -27,8 +27,6 @@
 #include <fit.hpp>
 #include <test/test.hpp>
 
-#if PLUTT_NLOPT
-
 namespace {
 
 class MyTest: public Test {
@@ -77,8 +75,38 @@ void MyTest::Run()
     TEST_CMP(std::abs(f.GetMean() - mean), <, std::abs(mean * 1e-2));
     TEST_CMP(std::abs(f.GetStd()  -  std), <, std::abs( std * 1e-2));
   }
-}
+  {
+    // Narrow peak far from the middle of a wide range, needs a decent guess.
+    std::vector<uint32_t> v(1000);
+    double y = 50;
+    double amp = 500;
+    double mean = 812.3;
+    double std = 4;
+    double denom = 1 / (2 * std * std);
+    for (uint32_t i = 0; i < v.size(); ++i) {
+      auto d = i - mean;
+      v.at(i) = (uint32_t)(y + amp * exp(-d * d * denom) + (i * 7919 % 11));
+    }
+    FitParams params;
+    FitGauss f(v, y + amp, 0, (uint32_t)(v.size() - 1), &params);
+    TEST_CMP(std::abs(f.GetAmp()  -  amp), <, std::abs( amp * 2e-2));
+    TEST_CMP(std::abs(f.GetMean() - mean), <, std::abs(mean * 1e-3));
+    TEST_CMP(std::abs(f.GetStd()  -  std), <, std::abs( std * 2e-2));
+    TEST_BOOL(params.is_set);
 
+    // Warm start lands on the same result.
+    FitGauss f2(v, y + amp, 0, (uint32_t)(v.size() - 1), &params);
+    TEST_CMP(std::abs(f2.GetMean() - f.GetMean()), <, 1e-3);
+    TEST_CMP(std::abs(f2.GetStd()  -  f.GetStd()), <, 1e-3);
+  }
+  {
+    // Too few bins.
+    std::vector<uint32_t> v(10, 1);
+    FitGauss f(v, 1, 4, 5);
+    TEST_CMP(f.GetAmp(), ==, 0.0);
+    FitExpGauss f2(v, 1, 4, 20);
+    TEST_CMP(f2.GetGaussAmp(), ==, 0.0);
+  }
 }
 
-#endif
+}
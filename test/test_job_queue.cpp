@@ -0,0 +1,101 @@
+/*
+ * plutt, a scriptable monitor for experimental data.
+ *
+ * Copyright (C) 2025
+ * Hans Toshihide Toernqvist <hans.tornqvist@chalmers.se>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <job_queue.hpp>
+#include <test/test.hpp>
+
+namespace {
+
+class MyJob: public Job {
+  public:
+    MyJob():
+      Job(),
+      m_run_num(0)
+    {
+    }
+    void Run()
+    {
+      ++m_run_num;
+    }
+    std::atomic<unsigned> m_run_num;
+};
+
+class SlowJob: public Job {
+  public:
+    SlowJob():
+      Job(),
+      m_inside_num(0),
+      m_is_overlap(false)
+    {
+    }
+    void Run()
+    {
+      if (++m_inside_num > 1) {
+        m_is_overlap = true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      --m_inside_num;
+    }
+    std::atomic<unsigned> m_inside_num;
+    std::atomic<bool> m_is_overlap;
+};
+
+class MyTest: public Test {
+  void Run();
+};
+MyTest g_test_job_queue_;
+
+void MyTest::Run()
+{
+  MyJob job;
+  job.Queue();
+  for (unsigned i = 0; i < 100 && 0 == job.m_run_num; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  TEST_CMP(job.m_run_num.load(), ==, 1U);
+
+  // Cancelled before it runs, or waited for, never runs after.
+  job.Queue();
+  job.Cancel();
+  auto run_num = job.m_run_num.load();
+  TEST_BOOL(run_num >= 1U && run_num <= 2U);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  TEST_CMP(job.m_run_num.load(), ==, run_num);
+
+  // Queued again while running, waits for the running instance even when
+  // other workers are idle.
+  SlowJob slow;
+  for (unsigned i = 0; i < 50; ++i) {
+    slow.Queue();
+    std::this_thread::sleep_for(std::chrono::microseconds(300));
+  }
+  slow.Cancel();
+  TEST_BOOL(!slow.m_is_overlap);
+  TEST_CMP(slow.m_inside_num.load(), ==, 0U);
+}
+
+}
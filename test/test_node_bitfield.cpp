@@ -63,6 +63,24 @@ class MockNode1: public MockNodeValue {
     }
 };
 
+// Same channels and multiplicities as MockNode1.
+class MockNode2: public MockNodeValue {
+  public:
+    MOCK_NODE_VALUE(MockNode2)
+    void ProcessUser()
+    {
+      Input::Scalar s;
+      s.u64 = 6;
+      m_value[0].Push(1, s);
+      s.u64 = 7;
+      m_value[0].Push(1, s);
+      s.u64 = g_big ? 0x10 : 8;
+      m_value[0].Push(3, s);
+    }
+    static bool g_big;
+};
+bool MockNode2::g_big;
+
 void MyTest::Run()
 {
   {
@@ -90,6 +108,59 @@ void MyTest::Run()
     TEST_CMP(v.GetV().at(2).u64, ==, 0x0002U);
     TEST_CMP(v.GetV().at(3).u64, ==, 0x0500U);
   }
+  {
+    // Each field starts where the earlier ones end.
+    MockNode0 nv0(Input::kUint64, 1);
+    auto a0 = new BitfieldArg("a0", &nv0, 4);
+    MockNode1 nv1(Input::kUint64, 1);
+    auto a1 = new BitfieldArg("a1", &nv1, 8);
+    a1->next = a0;
+
+    NodeBitfield n("", a1);
+
+    auto const &v = n.GetValue(0);
+    nv0.Preprocess(&n);
+    nv1.Preprocess(&n);
+    TestNodeProcess(n, 1);
+    TEST_CMP(v.GetV().at(0).u64, ==, 0x031U);
+    TEST_CMP(v.GetV().at(1).u64, ==, 0x040U);
+    TEST_CMP(v.GetV().at(2).u64, ==, 0x002U);
+    TEST_CMP(v.GetV().at(3).u64, ==, 0x050U);
+  }
+  {
+    // Same layout is packed array-wise.
+    MockNode1 nv1(Input::kUint64, 1);
+    auto a1 = new BitfieldArg("a1", &nv1, 4);
+    MockNode2 nv2(Input::kUint64, 1);
+    auto a2 = new BitfieldArg("a2", &nv2, 4);
+    a2->next = a1;
+
+    NodeBitfield n("", a2);
+
+    auto const &v = n.GetValue(0);
+    nv1.Preprocess(&n);
+    nv2.Preprocess(&n);
+    TestNodeProcess(n, 1);
+    TEST_CMP(v.GetID().size(), ==, 2U);
+    TEST_CMP(v.GetID().at(0), ==, 1U);
+    TEST_CMP(v.GetID().at(1), ==, 3U);
+    TEST_CMP(v.GetEnd().at(0), ==, 2U);
+    TEST_CMP(v.GetEnd().at(1), ==, 3U);
+    TEST_CMP(v.GetV().at(0).u64, ==, 0x63U);
+    TEST_CMP(v.GetV().at(1).u64, ==, 0x74U);
+    TEST_CMP(v.GetV().at(2).u64, ==, 0x85U);
+
+    // Too wide values are still caught.
+    MockNode2::g_big = true;
+    bool did_throw = false;
+    try {
+      TestNodeProcess(n, 2);
+    } catch (std::runtime_error const &) {
+      did_throw = true;
+    }
+    TEST_BOOL(did_throw);
+    MockNode2::g_big = false;
+  }
 }
 
 }
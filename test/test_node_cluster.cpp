@@ -52,17 +52,76 @@ class MockNode: public MockNodeValue {
       m_value[0].Push(5, s);
     }
 };
+class MockNodeEq: public MockNodeValue {
+  public:
+    MOCK_NODE_VALUE(MockNodeEq)
+    void ProcessUser()
+    {
+      Input::Scalar s;
+      s.u64 = 3;
+      m_value[0].Push(1, s);
+      m_value[0].Push(4, s);
+      m_value[0].Push(9, s);
+    }
+};
+// 10 pixels wide.
+class MockNode2D: public MockNodeValue {
+  public:
+    MOCK_NODE_VALUE(MockNode2D)
+    void ProcessUser()
+    {
+      Input::Scalar s;
+      s.u64 = 4;
+      m_value[0].Push(11, s);
+      m_value[0].Push(12, s);
+      s.u64 = 2;
+      m_value[0].Push(22, s);
+      s.u64 = 3;
+      m_value[0].Push(57, s);
+      s.u64 = 1;
+      m_value[0].Push(85, s);
+      m_value[0].Push(96, s);
+    }
+};
+// 10 pixels wide, a diagonal over 5 rows and a lonely pixel far below.
+class MockNode2DRows: public MockNodeValue {
+  public:
+    MOCK_NODE_VALUE(MockNode2DRows)
+    void ProcessUser()
+    {
+      m_value[0].Clear();
+      Input::Scalar s;
+      s.u64 = 1;
+      for (uint32_t r = 0; r < 5; ++r) {
+        m_value[0].Push(r * 10 + 1 + r, s);
+      }
+      m_value[0].Push(98, s);
+    }
+};
+// 10 pixels wide, with a stray id far away.
+class MockNode2DFar: public MockNodeValue {
+  public:
+    MOCK_NODE_VALUE(MockNode2DFar)
+    void ProcessUser()
+    {
+      Input::Scalar s;
+      s.u64 = 1;
+      m_value[0].Push(11, s);
+      m_value[0].Push(31, s);
+      m_value[0].Push(4000000001, s);
+    }
+};
 
 void MyTest::Run()
 {
   {
-    NodeCluster n("a", nullptr);
+    NodeCluster n("a", nullptr, 0, 0);
     TestNodeBase(n, "a");
   }
   {
     MockNode nv(Input::kUint64, 1);
 
-    NodeCluster n("", &nv);
+    NodeCluster n("", &nv, 0, 0);
 
     auto const &x = n.GetValue(0);
     TEST_BOOL(x.GetV().empty());
@@ -86,6 +145,91 @@ void MyTest::Run()
     TEST_CMP(eta.GetV(0, false), ==, mid - floor(mid));
     TEST_CMP(eta.GetV(1, false), ==, 0);
   }
+  {
+    // A gap of one channel joins 3 and 5.
+    MockNode nv(Input::kUint64, 1);
+    NodeCluster n("", &nv, 1, 0);
+    nv.Preprocess(&n);
+    TestNodeProcess(n, 1);
+    auto const &x = n.GetValue(0);
+    TEST_CMP(x.GetV().size(), ==, 1U);
+    TEST_CMP(x.GetV(0, false), ==, 22);
+  }
+  {
+    // Clusters with the same energy are all kept.
+    MockNodeEq nv(Input::kUint64, 1);
+    NodeCluster n("", &nv, 0, 0);
+    nv.Preprocess(&n);
+    TestNodeProcess(n, 1);
+    auto const &x = n.GetValue(0);
+    TEST_CMP(x.GetV().size(), ==, 3U);
+    TEST_CMP(x.GetID()[0], ==, 1U);
+    TEST_CMP(x.GetID()[1], ==, 4U);
+    TEST_CMP(x.GetID()[2], ==, 9U);
+    TEST_CMP(x.GetV(2, false), ==, 3);
+  }
+  {
+    MockNode2D nv(Input::kUint64, 1);
+    NodeCluster n("", &nv, 0, 10);
+    nv.Preprocess(&n);
+    TestNodeProcess(n, 1);
+    auto const &x = n.GetValue(0);
+    auto const &eta = n.GetValue(1);
+    TEST_CMP(x.GetV().size(), ==, 3U);
+    // (1,1) (2,1) (2,2).
+    TEST_CMP(x.GetID()[0], ==, 11U);
+    TEST_CMP(x.GetV(0, false), ==, 10);
+    TEST_CMP(std::abs(eta.GetV(0, false) - 0.6), <, 1e-9);
+    TEST_CMP(std::abs(eta.GetV(1, false) - 0.2), <, 1e-9);
+    // Lonely (7,5).
+    TEST_CMP(x.GetID()[1], ==, 57U);
+    TEST_CMP(x.GetV(1, false), ==, 3);
+    // Diagonal (5,8) (6,9).
+    TEST_CMP(x.GetID()[2], ==, 85U);
+    TEST_CMP(x.GetV(2, false), ==, 2);
+  }
+  {
+    // Only occupied rows are labelled, a stray id must not span the grid.
+    MockNode2DFar nv(Input::kUint64, 1);
+    NodeCluster n("", &nv, 0, 10);
+    nv.Preprocess(&n);
+    TestNodeProcess(n, 1);
+    auto const &x = n.GetValue(0);
+    TEST_CMP(x.GetV().size(), ==, 3U);
+    TEST_CMP(x.GetID()[0], ==, 11U);
+    TEST_CMP(x.GetID()[1], ==, 31U);
+    TEST_CMP(x.GetID()[2], ==, 4000000001U);
+  }
+  {
+    // A gap of one row joins rows 1 and 3 across the empty row 2.
+    MockNode2DFar nv(Input::kUint64, 1);
+    NodeCluster n("", &nv, 1, 10);
+    nv.Preprocess(&n);
+    TestNodeProcess(n, 1);
+    auto const &x = n.GetValue(0);
+    TEST_CMP(x.GetV().size(), ==, 2U);
+    TEST_CMP(x.GetID()[0], ==, 21U);
+    TEST_CMP(x.GetV(0, false), ==, 2);
+    TEST_CMP(x.GetID()[1], ==, 4000000001U);
+  }
+  {
+    // More occupied rows than the label ring holds.
+    MockNode2DRows nv(Input::kUint64, 1);
+    NodeCluster n("", &nv, 0, 10);
+    nv.Preprocess(&n);
+    TestNodeProcess(n, 1);
+    auto const &x = n.GetValue(0);
+    TEST_CMP(x.GetV().size(), ==, 2U);
+    // Centre of (1,0)...(5,4).
+    TEST_CMP(x.GetID()[0], ==, 23U);
+    TEST_CMP(x.GetV(0, false), ==, 5);
+    TEST_CMP(x.GetID()[1], ==, 98U);
+    TEST_CMP(x.GetV(1, false), ==, 1);
+    // Run again to check that the ring was left cleared.
+    TestNodeProcess(n, 2);
+    TEST_CMP(x.GetV().size(), ==, 2U);
+    TEST_CMP(x.GetV(0, false), ==, 5);
+  }
 }
 
 }
@@ -65,6 +65,23 @@ class MockNodeArg: public MockNodeValue {
       m_value[0].Push(3, s);
     }
 };
+// Same ids as the condition, but more hits.
+class MockNodeArgMult: public MockNodeValue {
+  public:
+    MOCK_NODE_VALUE(MockNodeArgMult)
+    void ProcessUser()
+    {
+      Input::Scalar s;
+
+      s.u64 = 4;
+      m_value[0].Push(1, s);
+      m_value[0].Push(1, s);
+      s.u64 = 5;
+      m_value[0].Push(3, s);
+      s.u64 = 6;
+      m_value[0].Push(3, s);
+    }
+};
 
 void MyTest::Run()
 {
@@ -111,6 +128,63 @@ void MyTest::Run()
     TEST_CMP(x.GetV(0, false), ==, 4);
     TEST_CMP(x.GetV(1, false), ==, 5);
   }
+  {
+    // Conditions are ANDed, channel 1 drops out completely.
+    MockNodeCond nv_cond(Input::kUint64, 1);
+    MockNodeArg nv_arg(Input::kUint64, 1);
+
+    NodeFilterRange::CondVec cv(2);
+    cv[0].node = &nv_cond;
+    cv[0].lower = 1;
+    cv[0].lower_le = 1;
+    cv[0].upper = 3;
+    cv[0].upper_le = 0;
+    cv[1].node = &nv_arg;
+    cv[1].lower = 4;
+    cv[1].lower_le = 0;
+    cv[1].upper = 6;
+    cv[1].upper_le = 1;
+
+    std::vector<NodeValue *> av;
+    av.push_back(&nv_arg);
+    av.push_back(&nv_cond);
+
+    NodeFilterRange n("", cv, av);
+    nv_cond.Preprocess(&n);
+    nv_arg.Preprocess(&n);
+    TestNodeProcess(n, 1);
+
+    auto const &x = n.GetValue(0);
+    TEST_CMP(x.GetID().size(), ==, 1U);
+    TEST_CMP(x.GetID()[0], ==, 3U);
+    TEST_CMP(x.GetEnd()[0], ==, 1U);
+    TEST_CMP(x.GetV(0, false), ==, 5);
+    auto const &y = n.GetValue(1);
+    TEST_CMP(y.GetV().size(), ==, 1U);
+    TEST_CMP(y.GetV(0, false), ==, 2);
+  }
+  {
+    // An argument with another multiplicity than the conditions is caught.
+    MockNodeCond nv_cond(Input::kUint64, 1);
+    MockNodeArgMult nv_arg(Input::kUint64, 1);
+
+    NodeFilterRange::CondVec cv(1);
+    cv[0].node = &nv_cond;
+    cv[0].lower = 1;
+    cv[0].lower_le = 1;
+    cv[0].upper = 3;
+    cv[0].upper_le = 1;
+
+    std::vector<NodeValue *> av;
+    av.push_back(&nv_arg);
+
+    NodeFilterRange n("", cv, av);
+    nv_cond.Preprocess(&n);
+    nv_arg.Preprocess(&n);
+    TEST_TRY;
+    TestNodeProcess(n, 1);
+    TEST_CATCH;
+  }
 }
 
 }
@@ -20,6 +20,7 @@
  * MA  02110-1301  USA
  */
 
+#include <cmath>
 #include <cstdint>
 #include <iostream>
 #include <map>
@@ -49,31 +50,95 @@ class MockNode: public MockNodeValue {
       m_value[0].Push(3, s);
     }
 };
+uint64_t g_ped_v;
+class MockNodeSet: public MockNodeValue {
+  public:
+    MOCK_NODE_VALUE(MockNodeSet)
+    void ProcessUser()
+    {
+      m_value[0].Clear();
+      Input::Scalar s;
+      s.u64 = g_ped_v;
+      m_value[0].Push(0, s);
+    }
+};
 
 void MyTest::Run()
 {
-  MockNode nv(Input::kUint64, 1);
-  NodePedestal n("", &nv, 0.1, nullptr);
+  {
+    MockNode nv(Input::kUint64, 1);
+    NodePedestal n("", &nv, 0.1, nullptr);
 
-  auto const &v = n.GetValue(0);
-  TEST_BOOL(v.GetV().empty());
-  auto const &s = n.GetValue(1);
-  TEST_BOOL(s.GetV().empty());
+    auto const &v = n.GetValue(0);
+    TEST_BOOL(v.GetV().empty());
+    auto const &s = n.GetValue(1);
+    TEST_BOOL(s.GetV().empty());
 
-  nv.Preprocess(&n);
-  for (unsigned i = 0; i < 11000; ++i) {
-    TestNodeProcess(n, 1 + i);
+    nv.Preprocess(&n);
+    for (unsigned i = 0; i < 11000; ++i) {
+      TestNodeProcess(n, 1 + i);
+    }
+
+    TEST_CMP(s.GetID().size(), ==, 2UL);
+    TEST_CMP(s.GetID().at(0), ==, 2UL);
+    TEST_CMP(s.GetID().at(1), ==, 3UL);
+    TEST_CMP(s.GetEnd().size(), ==, 2UL);
+    TEST_CMP(s.GetEnd().at(0), ==, 1UL);
+    TEST_CMP(s.GetEnd().at(1), ==, 2UL);
+    TEST_CMP(s.GetV().size(), ==, 2UL);
+    TEST_CMP(std::abs(s.GetV().at(0).dbl - 2.3), <, 0.5);
+    TEST_CMP(std::abs(s.GetV().at(1).dbl - 4.6), <, 0.5);
   }
+  {
+    // Refreshes of the cached sigma.
+    MockNodeSet nv(Input::kUint64, 1);
+    NodePedestal n("", &nv, 0.0, nullptr);
+    auto const &s = n.GetValue(1);
+    nv.Preprocess(&n);
+    uint64_t evid = 1;
 
-  TEST_CMP(s.GetID().size(), ==, 2UL);
-  TEST_CMP(s.GetID().at(0), ==, 2UL);
-  TEST_CMP(s.GetID().at(1), ==, 3UL);
-  TEST_CMP(s.GetEnd().size(), ==, 2UL);
-  TEST_CMP(s.GetEnd().at(0), ==, 1UL);
-  TEST_CMP(s.GetEnd().at(1), ==, 2UL);
-  TEST_CMP(s.GetV().size(), ==, 2UL);
-  TEST_CMP(std::abs(s.GetV().at(0).dbl - 2.3), <, 0.5);
-  TEST_CMP(std::abs(s.GetV().at(1).dbl - 4.6), <, 0.5);
+    // Young page refreshes on every add.
+    for (unsigned i = 0; i < 100; ++i) {
+      g_ped_v = 2 * (i & 1);
+      TestNodeProcess(n, evid++);
+    }
+    auto std100 = sqrt(100.0 / 99);
+    TEST_CMP(s.GetV().size(), ==, 1UL);
+    TEST_CMP(std::abs(s.GetV().at(0).dbl - std100), <, 1e-9);
+
+    // Then only every 100 adds.
+    g_ped_v = 100;
+    for (unsigned i = 0; i < 99; ++i) {
+      TestNodeProcess(n, evid++);
+    }
+    TEST_CMP(std::abs(s.GetV().at(0).dbl - std100), <, 1e-9);
+    TestNodeProcess(n, evid++);
+    TEST_CMP(s.GetV().at(0).dbl, >, 10.0);
+
+    // Fill the first page, which refreshes and swaps.
+    while (evid <= 10000) {
+      TestNodeProcess(n, evid++);
+    }
+    double sum = 0.0;
+    double sum2 = 0.0;
+    for (unsigned i = 0; i < 10000; ++i) {
+      double x = i < 100 ? 2 * (i & 1) : 100;
+      sum += x;
+      sum2 += x * x;
+    }
+    auto var0 = (sum2 - sum * sum / 10000) / 9999;
+    TEST_CMP(std::abs(s.GetV().at(0).dbl - sqrt(var0)), <, 1e-6);
+
+    // The new page is young, mixes in right away.
+    TestNodeProcess(n, evid++);
+    TEST_CMP(std::abs(s.GetV().at(0).dbl - sqrt(var0 / 2)), <, 1e-6);
+
+    // Fill the second page, the next swap drops the first one.
+    while (evid <= 20001) {
+      TestNodeProcess(n, evid++);
+    }
+    TEST_BOOL(s.GetV().empty());
+  }
 
   // TODO: Test tpat.
 }
@@ -0,0 +1,212 @@
+/*
+ * plutt, a scriptable monitor for experimental data.
+ *
+ * Copyright (C) 2025
+ * Hans Toshihide Toernqvist <hans.tornqvist@chalmers.se>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+#include <unistd.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <config.hpp>
+#include <gui.hpp>
+#include <util.hpp>
+#include <test/test.hpp>
+
+extern GuiCollection g_gui;
+
+namespace {
+
+class MyTest: public Test {
+  void Run();
+};
+MyTest g_test_node_signal_;
+
+// Keeps plots and the hit count of the last drawn 1D histograms.
+class MockGui: public Gui {
+  public:
+    MockGui(): m_plot_vec(), m_sum_vec() {}
+    std::vector<Plot *> m_plot_vec;
+    std::vector<uint64_t> m_sum_vec;
+
+  protected:
+    void AddPage(std::string const &) {}
+    uint32_t AddPlot(std::string const &, Plot *a_plot)
+    {
+      m_plot_vec.push_back(a_plot);
+      m_sum_vec.push_back(0);
+      return (uint32_t)m_plot_vec.size() - 1;
+    }
+    bool DoClear(uint32_t) { return false; }
+    bool Draw(double) { return true; }
+    void DrawAnnular(uint32_t, Axis const &, double, double, Axis const &,
+        double, bool, std::vector<uint32_t> const &) {}
+    void DrawHist1(uint32_t a_id, Axis const &, LinearTransform const &,
+        bool, bool, std::vector<uint32_t> const &a_hist, Hist1Pyramid const
+        &, std::vector<Peak> const &, std::vector<float> const &)
+    {
+      uint64_t sum = 0;
+      for (auto it = a_hist.begin(); a_hist.end() != it; ++it) {
+        sum += *it;
+      }
+      m_sum_vec.at(a_id) = sum;
+    }
+    void DrawHist2(uint32_t, Axis const &, Axis const &, LinearTransform
+        const &, LinearTransform const &, bool, TiledCounts const &) {}
+    Visibility GetVisibility(uint32_t) { return kUnknown; }
+};
+
+// Multi-hit 'multi' with 5 hits, single-hit 'hit1' with 3, and scalar
+// array 'scalar' with 3.
+class MockInput: public Input {
+  public:
+    MockInput()
+    {
+      uint64_t m_id[] = {1, 2};
+      uint64_t m_end[] = {3, 5};
+      uint64_t s_id[] = {1, 2, 3};
+      for (unsigned i = 0; i < 6; ++i) {
+        m_data[i].clear();
+      }
+      for (unsigned i = 0; i < 2; ++i) {
+        Push(0, m_id[i]);
+        Push(1, m_end[i]);
+      }
+      for (unsigned i = 0; i < 5; ++i) {
+        Push(2, 10 + i);
+      }
+      for (unsigned i = 0; i < 3; ++i) {
+        Push(3, s_id[i]);
+        Push(4, 20 + i);
+        Push(5, 30 + i);
+      }
+    }
+    void Buffer() {}
+    bool Fetch() { return true; }
+    std::pair<Scalar const *, size_t> GetData(size_t a_id)
+    {
+      auto const &v = m_data[a_id];
+      return std::make_pair(v.data(), v.size());
+    }
+
+  private:
+    void Push(size_t a_id, uint64_t a_u64)
+    {
+      Scalar s;
+      s.u64 = a_u64;
+      m_data[a_id].push_back(s);
+    }
+    std::vector<Scalar> m_data[6];
+};
+
+// Runs one event per iteration and returns the hits of each histogram.
+std::vector<uint64_t> RunCaps(char const *a_caps, unsigned a_event_num)
+{
+  char dir[] = "/tmp/plutt_test_node_signal.XXXXXX";
+  if (!mkdtemp(dir)) {
+    throw std::runtime_error(__func__);
+  }
+  auto path = std::string(dir) + "/caps.plutt";
+  {
+    std::ofstream of(path);
+    of << a_caps;
+    of << "hist(\"multi\", multi)\n";
+    of << "hist(\"hit1\", hit1)\n";
+    of << "hist(\"scalar\", scalar)\n";
+  }
+  // Only this config's plots are drawn through this mock.
+  MockGui mock_gui;
+  g_gui.AddGui(&mock_gui);
+  auto config = new Config(path.c_str(), nullptr);
+  remove(path.c_str());
+  rmdir(dir);
+
+  config->BindSignal("multi", NodeSignal::kId, 0, Input::kUint64);
+  config->BindSignal("multi", NodeSignal::kEnd, 1, Input::kUint64);
+  config->BindSignal("multi", NodeSignal::kV, 2, Input::kUint64);
+  config->BindSignal("hit1", NodeSignal::kId, 3, Input::kUint64);
+  config->BindSignal("hit1", NodeSignal::kV, 4, Input::kUint64);
+  config->BindSignal("scalar", NodeSignal::kV, 5, Input::kUint64);
+  MockInput input;
+  for (unsigned i = 0; i < a_event_num; ++i) {
+    config->DoEvent(&input);
+  }
+
+  std::vector<uint64_t> sum_vec;
+  for (size_t i = 0; i < mock_gui.m_plot_vec.size(); ++i) {
+    auto plot = mock_gui.m_plot_vec[i];
+    plot->Latch();
+    plot->Draw(&mock_gui);
+    sum_vec.push_back(mock_gui.m_sum_vec[i]);
+  }
+  g_gui.RemoveGui(&mock_gui);
+  // The plots go with the config.
+  mock_gui.m_plot_vec.clear();
+  mock_gui.m_sum_vec.clear();
+  config->UnbindSignals();
+  delete config;
+  return sum_vec;
+}
+
+void MyTest::Run()
+{
+  {
+    // No caps.
+    auto patho = Pathological_get();
+    auto sum_vec = RunCaps("", 2);
+    TEST_CMP(sum_vec.size(), ==, 3U);
+    TEST_CMP(sum_vec.at(0), ==, 2 * 5U);
+    TEST_CMP(sum_vec.at(1), ==, 2 * 3U);
+    TEST_CMP(sum_vec.at(2), ==, 2 * 3U);
+    TEST_CMP(Pathological_get(), ==, patho);
+  }
+  {
+    // Truncated, the multi-hit cap counts hits and not channels.
+    auto patho = Pathological_get();
+    auto sum_vec = RunCaps(
+        "mult_max(\"multi\", 4)\n"
+        "mult_max(\"hit1\", 2)\n"
+        "mult_max(\"scalar\", 1)\n", 2);
+    TEST_CMP(sum_vec.size(), ==, 3U);
+    TEST_CMP(sum_vec.at(0), ==, 2 * 4U);
+    TEST_CMP(sum_vec.at(1), ==, 2 * 2U);
+    TEST_CMP(sum_vec.at(2), ==, 2 * 1U);
+    // One per event, not per signal.
+    TEST_CMP(Pathological_get(), ==, patho + 2);
+  }
+  {
+    // Skipped, with a global cap and a looser one for 'scalar'.
+    auto sum_vec = RunCaps(
+        "mult_max(2, skip)\n"
+        "mult_max(\"scalar\", 3)\n", 2);
+    TEST_CMP(sum_vec.size(), ==, 3U);
+    TEST_CMP(sum_vec.at(0), ==, 0U);
+    TEST_CMP(sum_vec.at(1), ==, 0U);
+    TEST_CMP(sum_vec.at(2), ==, 2 * 3U);
+  }
+}
+
+}
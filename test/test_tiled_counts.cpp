@@ -0,0 +1,180 @@
+/*
+ * plutt, a scriptable monitor for experimental data.
+ *
+ * Copyright (C) 2025
+ * Hans Toshihide Toernqvist <hans.tornqvist@chalmers.se>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include <tiled_counts.hpp>
+#include <util.hpp>
+#include <test/test.hpp>
+
+namespace {
+
+class MyTest: public Test {
+  void Run();
+};
+MyTest g_test_tiled_counts_;
+
+void MyTest::Run()
+{
+  // Spans a few tiles with a partial one at the end.
+  size_t const c_size = 10000;
+
+  TiledCounts c;
+  c.Resize(c_size, 1);
+  TEST_CMP(c.GetSize(), ==, c_size);
+  TEST_CMP(c.Get(0, 0), ==, 0U);
+  TEST_CMP(c.Get(c_size - 1, 0), ==, 0U);
+
+  c.Inc(1, 0);
+  c.Inc(c_size - 1, 0);
+  c.Inc(c_size - 1, 0);
+  TEST_CMP(c.Get(1, 0), ==, 1U);
+  TEST_CMP(c.Get(c_size - 1, 0), ==, 2U);
+
+  // Promotion past 16 bits.
+  for (uint32_t i = 0; i < 70000; ++i) {
+    c.Inc(5000, 0);
+  }
+  TEST_CMP(c.Get(5000, 0), ==, 70000U);
+  TEST_CMP(c.Get(1, 0), ==, 1U);
+  TEST_CMP(c.Get(c_size - 1, 0), ==, 2U);
+
+  std::vector<uint32_t> v;
+  c.Copy(&v);
+  TEST_CMP(v.size(), ==, c_size);
+  TEST_CMP(v.at(1), ==, 1U);
+  TEST_CMP(v.at(5000), ==, 70000U);
+  TEST_CMP(v.at(c_size - 1), ==, 2U);
+
+  // Sums.
+  TiledCounts d;
+  d.Set(v, c_size, 1);
+  TEST_CMP(d.Get(5000, 0), ==, 70000U);
+  d.Add(c);
+  TEST_CMP(d.Get(1, 0), ==, 2U);
+  TEST_CMP(d.Get(5000, 0), ==, 140000U);
+  d.Sub(c);
+  TEST_CMP(d.Get(1, 0), ==, 1U);
+  TEST_CMP(d.Get(5000, 0), ==, 70000U);
+  d.Halve();
+  TEST_CMP(d.Get(1, 0), ==, 0U);
+  TEST_CMP(d.Get(5000, 0), ==, 35000U);
+
+  // Beyond 32 bits saturates the copy.
+  std::vector<uint32_t> big(1, UINT32_MAX);
+  TiledCounts e;
+  e.Set(big, 1, 1);
+  e.Inc(0, 0);
+  TEST_CMP(e.Get(0, 0), ==, (uint64_t)UINT32_MAX + 1);
+  e.Copy(&big);
+  TEST_CMP(big.at(0), ==, UINT32_MAX);
+
+  // Small histograms cost no more than plain 32-bit counters.
+  {
+    TiledCounts m;
+    m.Resize(1000, 1);
+    m.Inc(999, 0);
+    TEST_CMP(m.Get(999, 0), ==, 1U);
+    TEST_CMP(m.GetMemSize(), <, 1000 * sizeof(uint32_t));
+    m.Resize(10, 10);
+    // Padding of the 16x16 tile doesn't count.
+    for (size_t y = 0; y < 10; ++y) {
+      for (size_t x = 0; x < 10; ++x) {
+        m.Inc(x, y);
+      }
+    }
+    uint32_t min, max;
+    m.GetMinMax(&min, &max);
+    TEST_CMP(min, ==, 1U);
+    TEST_CMP(max, ==, 1U);
+    m.Zero();
+    TEST_CMP(m.GetTileWidth(), ==, 16U);
+    TEST_CMP(m.GetTileHeight(), ==, 16U);
+    m.Inc(9, 9);
+    std::vector<uint32_t> mv;
+    m.Copy(&mv);
+    TEST_CMP(mv.at(99), ==, 1U);
+  }
+
+  c.Zero();
+  TEST_CMP(c.Get(5000, 0), ==, 0U);
+  c.Clear();
+  TEST_CMP(c.GetSize(), ==, 0U);
+
+  // Large 2D only allocates touched tiles.
+  {
+    TiledCounts s;
+    s.Resize(2000, 1000);
+    TEST_BOOL(s.IsSparse());
+    TEST_BOOL(!s.HasTile(0, 0));
+    s.Inc(1999, 999);
+    s.Inc(100, 10);
+    s.Inc(100, 10);
+    TEST_BOOL(s.HasTile(100, 10));
+    TEST_BOOL(!s.HasTile(0, 0));
+    TEST_CMP(s.Get(1999, 999), ==, 1U);
+    TEST_CMP(s.Get(100, 10), ==, 2U);
+    TEST_CMP(s.Get(101, 10), ==, 0U);
+    TEST_CMP(s.Get(0, 0), ==, 0U);
+
+    std::vector<uint32_t> dense;
+    s.Copy(&dense);
+    TEST_CMP(dense.size(), ==, 2000U * 1000U);
+    TEST_CMP(dense.at(999 * 2000 + 1999), ==, 1U);
+    TEST_CMP(dense.at(10 * 2000 + 100), ==, 2U);
+    TEST_CMP(dense.at(0), ==, 0U);
+
+    // Rectangles across tile borders, untouched tiles read as 0.
+    std::vector<uint32_t> rect(4 * 3, 7);
+    s.CopyRect(62, 9, 4, 3, rect.data());
+    TEST_CMP(rect.at(0), ==, 0U);
+    s.CopyRect(98, 9, 4, 3, rect.data());
+    TEST_CMP(rect.at(1 * 4 + 2), ==, 2U);
+    TEST_CMP(rect.at(1 * 4 + 3), ==, 0U);
+    TEST_CMP(rect.at(0), ==, 0U);
+    uint32_t min, max;
+    s.GetMinMax(&min, &max);
+    TEST_CMP(min, ==, 0U);
+    TEST_CMP(max, ==, 2U);
+
+    // Same re-binning as for dense storage.
+    auto nd = Rebin2(dense,
+        2000, 0.0, 2000.0, 1000, 0.0, 1000.0,
+        1000, 0.0, 4000.0, 500, 0.0, 2000.0);
+    auto ns = Rebin2(s,
+        0.0, 2000.0, 0.0, 1000.0,
+        1000, 0.0, 4000.0, 500, 0.0, 2000.0);
+    TEST_CMP(ns.GetWidth(), ==, 1000U);
+    TEST_CMP(ns.GetHeight(), ==, 500U);
+    TEST_CMP(nd.at(249 * 1000 + 499), ==, 1U);
+    TEST_CMP(nd.at(2 * 1000 + 25), ==, 2U);
+    std::vector<uint32_t> nsd;
+    ns.Copy(&nsd);
+    TEST_BOOL(nd == nsd);
+
+    s.Zero();
+    TEST_BOOL(!s.HasTile(100, 10));
+  }
+}
+
+}
@@ -20,6 +20,8 @@
  * MA  02110-1301  USA
  */
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <iostream>
 #include <vector>
@@ -270,6 +272,83 @@ void test_rebin2()
   }
 }
 
+void test_hist1_pyramid()
+{
+  Hist1Pyramid pyr;
+  pyr.Build(std::vector<uint32_t>());
+  TEST_CMP(pyr.GetSize(), ==, 0U);
+  // Odd and even sizes, compared against brute force on all ranges.
+  for (size_t n = 1; n < 40; n += 3) {
+    std::vector<uint32_t> v(n);
+    for (size_t i = 0; i < n; ++i) {
+      v[i] = (uint32_t)((i * 7919 + n) % 101);
+    }
+    pyr.Build(v);
+    TEST_CMP(pyr.GetSize(), ==, n);
+    bool ok = true;
+    for (size_t i0 = 0; i0 < n; ++i0) {
+      for (size_t i1 = i0 + 1; i1 <= n; ++i1) {
+        uint32_t min, max;
+        pyr.Query(i0, i1, &min, &max);
+        uint32_t min_ref = v[i0];
+        uint32_t max_ref = v[i0];
+        for (size_t i = i0; i < i1; ++i) {
+          min_ref = std::min(min_ref, v[i]);
+          max_ref = std::max(max_ref, v[i]);
+        }
+        ok = ok && min == min_ref && max == max_ref;
+      }
+    }
+    TEST_BOOL(ok);
+  }
+}
+
+void test_snip()
+{
+  SnipBuf buf;
+  {
+    // Flat background under a peak, flat parts pass untouched.
+    std::vector<uint32_t> v(1000, 100);
+    for (uint32_t i = 0; i < v.size(); ++i) {
+      auto d = i - 500.0;
+      v.at(i) += (uint32_t)(1000 * exp(-d * d / 18));
+    }
+    std::vector<float> bg;
+    Snip(v, 6, &buf, &bg);
+    TEST_CMP(bg.size(), ==, v.size());
+    TEST_CMP(bg.at(0), ==, 100.0f);
+    TEST_CMP(bg.at(300), ==, 100.0f);
+    TEST_CMP(bg.at(999), ==, 100.0f);
+    TEST_CMP(std::abs(bg.at(500) - 100.0f), <, 10.0f);
+  }
+  {
+    // Too short for the window, comes back as is.
+    std::vector<uint32_t> v(3, 7);
+    v.at(1) = 70;
+    std::vector<float> bg;
+    Snip(v, 6, &buf, &bg);
+    TEST_CMP(bg.at(1), ==, 7.0f);
+  }
+  {
+    // Spot on a plane, non-square to catch row/column mix-ups.
+    size_t w = 100;
+    size_t h = 60;
+    std::vector<uint32_t> v(w * h, 50);
+    for (size_t k = 0; k < h; ++k) {
+      for (size_t l = 0; l < w; ++l) {
+        auto dx = (double)l - 70.0;
+        auto dy = (double)k - 20.0;
+        v.at(k * w + l) += (uint32_t)(500 * exp(-(dx * dx + dy * dy) / 8));
+      }
+    }
+    std::vector<float> bg;
+    Snip2(v, w, h, 5, &buf, &bg);
+    TEST_CMP(bg.size(), ==, v.size());
+    TEST_CMP(bg.at(5 * w + 5), ==, 50.0f);
+    TEST_CMP(std::abs(bg.at(20 * w + 70) - 50.0f), <, 5.0f);
+  }
+}
+
 void test_utf8()
 {
   {
@@ -357,6 +436,8 @@ void MyTest::Run()
 
   test_rebin1();
   test_rebin2();
+  test_hist1_pyramid();
+  test_snip();
 
   TEST_CMP(SubModDbl(0, 0, 8), ==, 0);
 
@@ -92,6 +92,27 @@ void MyTest::Run()
     TEST_BOOL(v.GetEnd().empty());
     TEST_BOOL(v.GetV().empty());
   }
+
+  // Masked compaction.
+  {
+    Value src;
+    src.SetType(Input::kUint64);
+    Input::Scalar s;
+    for (uint32_t i = 0; i < 6; ++i) {
+      s.u64 = i;
+      src.Push(i / 2, s);
+    }
+    uint8_t const mask[] = {1, 0, 0, 0, 0, 1};
+    Value v;
+    v.SetType(Input::kUint64);
+    v.PushMasked(src, 3, mask);
+    TEST_CMP(v.GetID().size(), ==, 2U);
+    TEST_CMP(v.GetID().at(0), ==, 0U);
+    TEST_CMP(v.GetID().at(1), ==, 2U);
+    TEST_CMP(v.GetEnd().at(0), ==, 1U);
+    TEST_CMP(v.GetEnd().at(1), ==, 2U);
+    TEST_CMP(v.GetV().at(1).u64, ==, 5U);
+  }
 }
 
 }
@@ -0,0 +1,218 @@
+/*
+ * plutt, a scriptable monitor for experimental data.
+ *
+ * Copyright (C) 2025
+ * Hans Toshihide Toernqvist <hans.tornqvist@chalmers.se>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <tiled_counts.hpp>
+#include <util.hpp>
+#include <visual.hpp>
+#include <test/test.hpp>
+
+extern GuiCollection g_gui;
+
+namespace {
+
+class MyTest: public Test {
+  void Run();
+};
+MyTest g_test_visual_;
+
+// Keeps the last drawn 2D histogram.
+class MockGui: public Gui {
+  public:
+    MockGui(): m_hist2() {}
+    TiledCounts m_hist2;
+
+  protected:
+    void AddPage(std::string const &) {}
+    uint32_t AddPlot(std::string const &, Plot *) { return 0; }
+    bool DoClear(uint32_t) { return false; }
+    bool Draw(double) { return true; }
+    void DrawAnnular(uint32_t, Axis const &, double, double, Axis const &,
+        double, bool, std::vector<uint32_t> const &) {}
+    void DrawHist1(uint32_t, Axis const &, LinearTransform const &, bool,
+        bool, std::vector<uint32_t> const &, Hist1Pyramid const &,
+        std::vector<Peak> const &, std::vector<float> const &) {}
+    void DrawHist2(uint32_t, Axis const &, Axis const &, LinearTransform
+        const &, LinearTransform const &, bool, TiledCounts const &a_hist)
+    {
+      m_hist2 = a_hist;
+    }
+    Visibility GetVisibility(uint32_t) { return kUnknown; }
+};
+
+void MyTest::Run()
+{
+  Gui::Axis axis0;
+  axis0.Clear();
+  Gui::Axis axis4;
+  axis4.bins = 4;
+  axis4.min = 0.0;
+  axis4.max = 4.0;
+
+  // Running sum over slices.
+  {
+    Time_set_ms(0);
+    VisualSlices s(1.0, 3);
+    s.Update();
+    s.Rebin1(axis0, axis4);
+    TEST_CMP(s.GetSum().GetSize(), ==, 4U);
+    s.Inc(0, 0);
+    s.Inc(1, 0);
+    TEST_CMP(s.GetSum().Get(0, 0), ==, 1U);
+    TEST_CMP(s.GetSum().Get(1, 0), ==, 1U);
+
+    Time_set_ms(1001);
+    s.Update();
+    s.Inc(1, 0);
+    s.Inc(2, 0);
+    TEST_CMP(s.GetSum().Get(0, 0), ==, 1U);
+    TEST_CMP(s.GetSum().Get(1, 0), ==, 2U);
+    TEST_CMP(s.GetSum().Get(2, 0), ==, 1U);
+
+    // Third slice, nothing is dropped yet.
+    Time_set_ms(2002);
+    s.Update();
+    s.Inc(3, 0);
+    TEST_CMP(s.GetSum().Get(0, 0), ==, 1U);
+    TEST_CMP(s.GetSum().Get(1, 0), ==, 2U);
+    TEST_CMP(s.GetSum().Get(3, 0), ==, 1U);
+
+    // Wraps around, drops the first slice.
+    Time_set_ms(3003);
+    s.Update();
+    TEST_CMP(s.GetSum().Get(0, 0), ==, 0U);
+    TEST_CMP(s.GetSum().Get(1, 0), ==, 1U);
+    TEST_CMP(s.GetSum().Get(2, 0), ==, 1U);
+    TEST_CMP(s.GetSum().Get(3, 0), ==, 1U);
+
+    VisualHistVec copy;
+    s.Copy(&copy);
+    TEST_CMP(copy.size(), ==, 4U);
+    TEST_CMP(copy.at(1), ==, 1U);
+
+    s.ClearActive();
+    s.Inc(0, 0);
+    s.Clear();
+    TEST_CMP(s.GetSum().GetSize(), ==, 0U);
+  }
+
+  // Weighted adds, as from outer-product fills.
+  {
+    Time_set_ms(0);
+    VisualSlices s(1.0, 3);
+    s.Update();
+    s.Rebin1(axis0, axis4);
+    auto version = s.GetVersion();
+    s.Add(2, 0, 5);
+    s.Inc(2, 0);
+    TEST_CMP(s.GetSum().Get(2, 0), ==, 6U);
+    TEST_CMP(s.GetVersion(), !=, version);
+  }
+
+  // Exponential decay.
+  {
+    Time_set_ms(0);
+    VisualSlices s(1.0, 0);
+    s.Update();
+    s.Rebin1(axis0, axis4);
+    for (unsigned i = 0; i < 8; ++i) {
+      s.Inc(0, 0);
+    }
+    s.Inc(1, 0);
+    TEST_CMP(s.GetSum().Get(0, 0), ==, 8U);
+    Time_set_ms(1001);
+    s.Update();
+    TEST_CMP(s.GetSum().Get(0, 0), ==, 4U);
+    TEST_CMP(s.GetSum().Get(1, 0), ==, 0U);
+  }
+
+  // Outer-product fill matches filling every pair.
+  {
+    MockGui mock_gui;
+    g_gui.AddGui(&mock_gui);
+    LinearTransform lt(1.0, 0.0);
+    VisualHist2 h_outer("outer", 8, 8, lt, lt, false, 0.0, 1, 0.0, -1.0);
+    VisualHist2 h_pair("pair", 8, 8, lt, lt, false, 0.0, 1, 0.0, -1.0);
+    // Duplicates, and different values sharing a bin once rebinned.
+    uint64_t xs[] = {3, 3, 7, 100, 101, 3, 250};
+    uint64_t ys[] = {10, 10, 10, 55, 2000, 11};
+    Vector<Input::Scalar> vec_x;
+    Vector<Input::Scalar> vec_y;
+    for (size_t i = 0; i < LENGTH(xs); ++i) {
+      Input::Scalar sc;
+      sc.u64 = xs[i];
+      vec_x.push_back(sc);
+    }
+    for (size_t i = 0; i < LENGTH(ys); ++i) {
+      Input::Scalar sc;
+      sc.u64 = ys[i];
+      vec_y.push_back(sc);
+    }
+    for (unsigned ev = 0; ev < 3; ++ev) {
+      h_outer.PrefillOuter(Input::kUint64, vec_x, Input::kUint64, vec_y);
+      h_outer.Fit();
+      h_outer.FillOuter(Input::kUint64, vec_x, Input::kUint64, vec_y);
+      for (auto ity = vec_y.begin(); vec_y.end() != ity; ++ity) {
+        for (auto itx = vec_x.begin(); vec_x.end() != itx; ++itx) {
+          h_pair.Prefill(Input::kUint64, *itx, Input::kUint64, *ity);
+        }
+      }
+      h_pair.Fit();
+      for (auto ity = vec_y.begin(); vec_y.end() != ity; ++ity) {
+        for (auto itx = vec_x.begin(); vec_x.end() != itx; ++itx) {
+          h_pair.Fill(Input::kUint64, *itx, Input::kUint64, *ity);
+        }
+      }
+    }
+    h_outer.Latch();
+    h_outer.Draw(&mock_gui);
+    TiledCounts outer = mock_gui.m_hist2;
+    h_pair.Latch();
+    h_pair.Draw(&mock_gui);
+    g_gui.RemoveGui(&mock_gui);
+    auto const &pair = mock_gui.m_hist2;
+    TEST_CMP(outer.GetWidth(), ==, pair.GetWidth());
+    TEST_CMP(outer.GetHeight(), ==, pair.GetHeight());
+    TEST_CMP(outer.GetWidth(), >, 0U);
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    for (size_t y = 0; y < pair.GetHeight(); ++y) {
+      for (size_t x = 0; x < pair.GetWidth(); ++x) {
+        TEST_CMP(outer.Get(x, y), ==, pair.Get(x, y));
+        sum += pair.Get(x, y);
+        max = std::max(max, pair.Get(x, y));
+      }
+    }
+    TEST_CMP(sum, ==, 3 * LENGTH(xs) * LENGTH(ys));
+    // Three 3:s times two 10:s in one bin, at least.
+    TEST_CMP(max, >=, 3U * 3 * 2);
+  }
+}
+
+}